@@ -48,6 +48,11 @@
 #include "PoolAddCommand.h"
 #include "PoolRemoveCommand.h"
 #include "InfoPoolsCommand.h"
+#include "InfoStatsCommand.h"
+#include "InfoSchedulerCommand.h"
+#include "InfoSqlCommand.h"
+#include "InfoTransfersCommand.h"
+#include "InfoThreadsCommand.h"
 #include "RetrieveCommand.h"
 #include "HelpCommand.h"
 
@@ -149,6 +154,14 @@ void HelpCommand::doCommand(int argc, char **argv)
                 ltfsdmCommand = new InfoTapesCommand();
             } else if (InfoPoolsCommand().compare(command)) {
                 ltfsdmCommand = new InfoPoolsCommand();
+            } else if (InfoSchedulerCommand().compare(command)) {
+                ltfsdmCommand = new InfoSchedulerCommand();
+            } else if (InfoSqlCommand().compare(command)) {
+                ltfsdmCommand = new InfoSqlCommand();
+            } else if (InfoTransfersCommand().compare(command)) {
+                ltfsdmCommand = new InfoTransfersCommand();
+            } else if (InfoThreadsCommand().compare(command)) {
+                ltfsdmCommand = new InfoThreadsCommand();
             } else {
                 ltfsdmCommand = new InfoCommand();
             }
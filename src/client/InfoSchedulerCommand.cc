@@ -0,0 +1,85 @@
+/*******************************************************************************
+ * Copyright 2018 IBM Corp. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *******************************************************************************/
+#include <sys/resource.h>
+
+#include <unistd.h>
+#include <string>
+#include <list>
+#include <sstream>
+#include <exception>
+
+#include "src/common/errors.h"
+#include "src/common/LTFSDMException.h"
+#include "src/common/Message.h"
+#include "src/common/Trace.h"
+
+#include "src/communication/ltfsdm.pb.h"
+#include "src/communication/LTFSDmComm.h"
+
+#include "LTFSDMCommand.h"
+#include "InfoStatsCommand.h"
+#include "InfoSchedulerCommand.h"
+
+/** @page ltfsdm_info_scheduler ltfsdm info scheduler
+    The ltfsdm info scheduler command lists latency histograms and counters
+    of the scheduler: the time requests are waiting to be scheduled, the
+    processing time of requests, the duration of cartridge mounts, moves,
+    and unmounts per drive, and the time suspended operations are waiting
+    to be continued. Times are in milliseconds. The percentiles are
+    estimated from the histogram buckets (see @ref metrics).
+
+    <tt>@LTFSDMC0108I</tt>
+
+    parameters | description
+    ---|---
+    -j | machine-readable output in JSON format including all histogram buckets
+
+    Example:
+
+    @verbatim
+    [root@visp ~]# ltfsdm info scheduler
+    name                           count        min (ms)     avg (ms)     max (ms)     p50 (ms)     p95 (ms)
+    mounts                         12
+    suspend requests               2
+    suspensions                    2
+    exec migration                 4            20512        81937        190381       65536        190381
+    mount 1013000505               6            21063        24172        28115        28115        28115
+    queue wait migration           4            0            11000        33000        16384        32768
+    queue wait transparent recall  57           0            3052         27000        1024         16384
+    @endverbatim
+
+    The corresponding class is @ref InfoSchedulerCommand.
+ */
+
+void InfoSchedulerCommand::printUsage()
+{
+    INFO(LTFSDMC0108I);
+}
+
+void InfoSchedulerCommand::doCommand(int argc, char **argv)
+{
+    processOptions(argc, argv);
+
+    TRACE(Trace::normal, *argv, argc, optind);
+
+    if (argc != optind) {
+        printUsage();
+        THROW(Error::GENERAL_ERROR);
+    }
+
+    listStats("scheduler");
+}
@@ -0,0 +1,180 @@
+/*******************************************************************************
+ * Copyright 2018 IBM Corp. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *******************************************************************************/
+#include <sys/resource.h>
+
+#include <unistd.h>
+#include <string>
+#include <list>
+#include <vector>
+#include <algorithm>
+#include <sstream>
+#include <exception>
+
+#include "src/common/errors.h"
+#include "src/common/LTFSDMException.h"
+#include "src/common/Message.h"
+#include "src/common/Trace.h"
+
+#include "src/communication/ltfsdm.pb.h"
+#include "src/communication/LTFSDmComm.h"
+
+#include "LTFSDMCommand.h"
+#include "InfoSqlCommand.h"
+
+/** @page ltfsdm_info_sql ltfsdm info sql
+    The ltfsdm info sql command lists execution statistics of the SQL
+    statements of the backend ordered by the total time spent: the number
+    of executions, the total time to prepare the statements, to execute
+    them, and to wait for locks, the number of rows returned and the
+    number of rows changed. The statistics are only recorded if the
+    backend has been started with option -p (see @ref server_code and
+    @ref sqlite). Statements are truncated to 60 characters.
+
+    <tt>@LTFSDMC0112I</tt>
+
+    parameters | description
+    ---|---
+    -j | machine-readable output in JSON format including the complete statements, times are in nanoseconds
+
+    Example:
+
+    @verbatim
+    [root@visp ~]# ltfsdm info sql
+    count        total (ms)   prepare (ms) step (ms)    wait (ms)    rows         changes      statement
+    200000       5321         0            4410         911          0            200000       INSERT INTO JOB_QUEUE (OPERATION, DIR_ID, LEAF_NAME, REQ_NUM...
+    21           1087         0            1020         67           0            0            COMMIT TRANSACTION
+    @endverbatim
+
+    The corresponding class is @ref InfoSqlCommand.
+ */
+
+static std::string jsonString(std::string s)
+
+{
+    std::string res;
+
+    for (char c : s) {
+        if (c == '"' || c == '\\')
+            res += '\\';
+        res += c;
+    }
+
+    return res;
+}
+
+void InfoSqlCommand::printUsage()
+{
+    INFO(LTFSDMC0112I);
+}
+
+void InfoSqlCommand::doCommand(int argc, char **argv)
+{
+    std::vector<sql_profile_t> profiles;
+    bool profiling = false;
+
+    processOptions(argc, argv);
+
+    TRACE(Trace::normal, *argv, argc, optind);
+
+    if (argc != optind) {
+        printUsage();
+        THROW(Error::GENERAL_ERROR);
+    }
+
+    try {
+        connect();
+    } catch (const std::exception& e) {
+        MSG(LTFSDMC0026E);
+        return;
+    }
+
+    LTFSDmProtocol::LTFSDmInfoSqlRequest *infosql =
+            commCommand.mutable_infosqlrequest();
+
+    infosql->set_key(key);
+
+    try {
+        commCommand.send();
+    } catch (const std::exception& e) {
+        MSG(LTFSDMC0027E);
+        THROW(Error::GENERAL_ERROR);
+    }
+
+    do {
+        try {
+            commCommand.recv();
+        } catch (const std::exception& e) {
+            MSG(LTFSDMC0028E);
+            THROW(Error::GENERAL_ERROR);
+        }
+
+        const LTFSDmProtocol::LTFSDmInfoSqlResp infosqlresp =
+                commCommand.infosqlresp();
+        profiling = infosqlresp.profiling();
+        if (infosqlresp.statement().compare("") == 0)
+            break;
+
+        profiles.push_back( { infosqlresp.statement(),
+                infosqlresp.executions(), infosqlresp.prepares(),
+                infosqlresp.preparens(), infosqlresp.stepns(),
+                infosqlresp.lockwaitns(), infosqlresp.rows(),
+                infosqlresp.changes() });
+    } while (true);
+
+    std::sort(profiles.begin(), profiles.end(),
+            [] (const sql_profile_t& a, const sql_profile_t& b) {
+                return a.total() > b.total();
+            });
+
+    if (jsonOutput) {
+        std::stringstream json;
+        bool first = true;
+
+        json << "{\"profiling\": " << (profiling ? "true" : "false")
+                << ", \"statements\": [";
+        for (const sql_profile_t& prof : profiles) {
+            json << (first ? "" : ", ") << "{\"statement\": \""
+                    << jsonString(prof.statement) << "\", \"executions\": "
+                    << prof.executions << ", \"prepares\": " << prof.prepares
+                    << ", \"prepare_ns\": " << prof.prepareNs
+                    << ", \"step_ns\": " << prof.stepNs
+                    << ", \"lock_wait_ns\": " << prof.lockWaitNs
+                    << ", \"rows\": " << prof.rows << ", \"changes\": "
+                    << prof.changes << "}";
+            first = false;
+        }
+        json << "]}" << std::endl;
+        INFO(LTFSDMC0024I, json.str());
+        return;
+    }
+
+    if (profiling == false) {
+        INFO(LTFSDMC0115I);
+        return;
+    }
+
+    INFO(LTFSDMC0113I);
+
+    for (const sql_profile_t& prof : profiles) {
+        std::string statement = prof.statement;
+        if (statement.size() > 60)
+            statement = statement.substr(0, 57) + "...";
+        INFO(LTFSDMC0114I, prof.executions, prof.total() / 1000000,
+                prof.prepareNs / 1000000, prof.stepNs / 1000000,
+                prof.lockWaitNs / 1000000, prof.rows, prof.changes, statement);
+    }
+}
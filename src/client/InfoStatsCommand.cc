@@ -0,0 +1,132 @@
+/*******************************************************************************
+ * Copyright 2018 IBM Corp. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *******************************************************************************/
+#include <sys/resource.h>
+
+#include <unistd.h>
+#include <string>
+#include <list>
+#include <vector>
+#include <sstream>
+#include <exception>
+
+#include "src/common/errors.h"
+#include "src/common/LTFSDMException.h"
+#include "src/common/Message.h"
+#include "src/common/Trace.h"
+
+#include "src/communication/ltfsdm.pb.h"
+#include "src/communication/LTFSDmComm.h"
+
+#include "LTFSDMCommand.h"
+#include "InfoStatsCommand.h"
+
+static unsigned long percentile(
+        const LTFSDmProtocol::LTFSDmInfoStatsResp& infostatsresp, int pct)
+
+{
+    unsigned long limit = (infostatsresp.count() * pct + 99) / 100;
+    unsigned long sum = 0;
+
+    for (int i = 0; i < infostatsresp.buckets_size(); i++) {
+        sum += infostatsresp.buckets(i);
+        if (sum >= limit) {
+            unsigned long upper = (i == 0 ? 0 : 1UL << i);
+            return upper < infostatsresp.max() ? upper : infostatsresp.max();
+        }
+    }
+
+    return infostatsresp.max();
+}
+
+void InfoStatsCommand::listStats(std::string category)
+
+{
+    try {
+        connect();
+    } catch (const std::exception& e) {
+        MSG(LTFSDMC0026E);
+        return;
+    }
+
+    LTFSDmProtocol::LTFSDmInfoStatsRequest *infostats =
+            commCommand.mutable_infostatsrequest();
+
+    infostats->set_key(key);
+    infostats->set_category(category);
+
+    try {
+        commCommand.send();
+    } catch (const std::exception& e) {
+        MSG(LTFSDMC0027E);
+        THROW(Error::GENERAL_ERROR);
+    }
+
+    std::stringstream json;
+    std::string name;
+    bool first = true;
+
+    if (jsonOutput)
+        json << "{\"category\": \"" << category << "\", \"metrics\": [";
+    else
+        INFO(LTFSDMC0109I);
+
+    do {
+        try {
+            commCommand.recv();
+        } catch (const std::exception& e) {
+            MSG(LTFSDMC0028E);
+            THROW(Error::GENERAL_ERROR);
+        }
+
+        const LTFSDmProtocol::LTFSDmInfoStatsResp infostatsresp =
+                commCommand.infostatsresp();
+        name = infostatsresp.name();
+        if (name.compare("") == 0)
+            break;
+
+        if (jsonOutput) {
+            json << (first ? "" : ", ") << "{\"name\": \"" << name
+                    << "\", \"type\": \""
+                    << (infostatsresp.counter() ? "counter" : "histogram")
+                    << "\", \"count\": " << infostatsresp.count();
+            if (infostatsresp.counter() == false) {
+                json << ", \"sum_ms\": " << infostatsresp.sum()
+                        << ", \"min_ms\": " << infostatsresp.min()
+                        << ", \"max_ms\": " << infostatsresp.max()
+                        << ", \"buckets\": [";
+                for (int i = 0; i < infostatsresp.buckets_size(); i++)
+                    json << (i ? ", " : "") << infostatsresp.buckets(i);
+                json << "]";
+            }
+            json << "}";
+            first = false;
+        } else if (infostatsresp.counter()) {
+            INFO(LTFSDMC0111I, name, infostatsresp.count());
+        } else {
+            INFO(LTFSDMC0110I, name, infostatsresp.count(),
+                    infostatsresp.min(),
+                    infostatsresp.sum() / infostatsresp.count(),
+                    infostatsresp.max(), percentile(infostatsresp, 50),
+                    percentile(infostatsresp, 95));
+        }
+    } while (true);
+
+    if (jsonOutput) {
+        json << "]}" << std::endl;
+        INFO(LTFSDMC0024I, json.str());
+    }
+}
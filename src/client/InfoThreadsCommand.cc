@@ -0,0 +1,91 @@
+/*******************************************************************************
+ * Copyright 2018 IBM Corp. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *******************************************************************************/
+#include <sys/resource.h>
+
+#include <unistd.h>
+#include <string>
+#include <list>
+#include <sstream>
+#include <exception>
+
+#include "src/common/errors.h"
+#include "src/common/LTFSDMException.h"
+#include "src/common/Message.h"
+#include "src/common/Trace.h"
+
+#include "src/communication/ltfsdm.pb.h"
+#include "src/communication/LTFSDmComm.h"
+
+#include "LTFSDMCommand.h"
+#include "InfoStatsCommand.h"
+#include "InfoThreadsCommand.h"
+
+/** @page ltfsdm_info_threads ltfsdm info threads
+    The ltfsdm info threads command lists the number of threads of the
+    backend executor and for each thread pool the number of running
+    tasks, the time tasks are waiting to be executed, their execution
+    time, and the time ThreadPool::enqueue has been blocked because the
+    queue of the pool was full. Times are in milliseconds. See
+    @ref metrics for a description of all values and @ref executor.
+
+    <tt>@LTFSDMC0117I</tt>
+
+    parameters | description
+    ---|---
+    -j | machine-readable output in JSON format including all histogram buckets
+
+    Example:
+
+    @verbatim
+    [root@visp ~]# ltfsdm info threads
+    name                           count        min (ms)     avg (ms)     max (ms)     p50 (ms)     p95 (ms)
+    threads live                   64
+    threads peak                   71
+    threads spawned                93
+    threads reaped                 29
+    threads blocked                18
+    pmig0-wq running               16
+    pmig0-wq running peak          16
+    stub2-wq running               0
+    stub2-wq running peak          64
+    pmig0-wq queue wait            4096         0            2210         9830         2048         8192
+    pmig0-wq run time              4096         2            148          4377         128          512
+    stub2-wq queue wait            4096         0            0            3            0            1
+    stub2-wq run time              4096         0            1            12           1            2
+    @endverbatim
+
+    The corresponding class is @ref InfoThreadsCommand.
+ */
+
+void InfoThreadsCommand::printUsage()
+{
+    INFO(LTFSDMC0117I);
+}
+
+void InfoThreadsCommand::doCommand(int argc, char **argv)
+{
+    processOptions(argc, argv);
+
+    TRACE(Trace::normal, *argv, argc, optind);
+
+    if (argc != optind) {
+        printUsage();
+        THROW(Error::GENERAL_ERROR);
+    }
+
+    listStats("threads");
+}
@@ -0,0 +1,82 @@
+/*******************************************************************************
+ * Copyright 2018 IBM Corp. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *******************************************************************************/
+#include <sys/resource.h>
+
+#include <unistd.h>
+#include <string>
+#include <list>
+#include <sstream>
+#include <exception>
+
+#include "src/common/errors.h"
+#include "src/common/LTFSDMException.h"
+#include "src/common/Message.h"
+#include "src/common/Trace.h"
+
+#include "src/communication/ltfsdm.pb.h"
+#include "src/communication/LTFSDmComm.h"
+
+#include "LTFSDMCommand.h"
+#include "InfoStatsCommand.h"
+#include "InfoTransfersCommand.h"
+
+/** @page ltfsdm_info_transfers ltfsdm info transfers
+    The ltfsdm info transfers command lists the number of bytes written to
+    and read from cartridges per drive together with the time spent for
+    these transfers in microseconds. The throughput of a drive is the
+    number of bytes divided by the time. The counters show the benefit of
+    binding the data transfers to the NUMA node of the drive (see
+    @ref drive_placement).
+
+    <tt>@LTFSDMC0116I</tt>
+
+    parameters | description
+    ---|---
+    -j | machine-readable output in JSON format
+
+    Example:
+
+    @verbatim
+    [root@visp ~]# ltfsdm info transfers
+    name                           count        min (ms)     avg (ms)     max (ms)     p50 (ms)     p95 (ms)
+    bytes read 1013000505          4294967296
+    bytes written 1013000505       21474836480
+    read us 1013000505             15730214
+    write us 1013000505            74411030
+    @endverbatim
+
+    The corresponding class is @ref InfoTransfersCommand.
+ */
+
+void InfoTransfersCommand::printUsage()
+{
+    INFO(LTFSDMC0116I);
+}
+
+void InfoTransfersCommand::doCommand(int argc, char **argv)
+{
+    processOptions(argc, argv);
+
+    TRACE(Trace::normal, *argv, argc, optind);
+
+    if (argc != optind) {
+        printUsage();
+        THROW(Error::GENERAL_ERROR);
+    }
+
+    listStats("transfers");
+}
@@ -93,6 +93,9 @@ void LTFSDMCommand::processOptions(int argc, char **argv)
             case 'C':
                 check = true;
                 break;
+            case 'j':
+                jsonOutput = true;
+                break;
             case ':':
                 INFO(LTFSDMC0014E);
                 printUsage();
@@ -39,6 +39,7 @@
  -x                    | indicates a forced operation
  -F                    | format a cartridge when added to a tape storage pool
  -C                    | check a cartridge when added to a tape storage pool
+ -j                    | machine-readable output in JSON format
 
  The LTFSDMCommand::checkOptions method checks if the number
  of arguments is correct and the request number is not set.
@@ -126,7 +127,7 @@ protected:
                     Const::UNSET), fileList(""), command(command_), optionStr(
                     optionStr_), fsName(""), mountPoint(""), startTime(
                     time(NULL)), poolNames(""), tapeList( { }), forced(false), format(
-                    false), check(false), key(Const::UNSET), commCommand(
+                    false), check(false), jsonOutput(false), key(Const::UNSET), commCommand(
                     Const::CLIENT_SOCKET_FILE), resident(0), transferred(0), premigrated(
                     0), migrated(0), failed(0), not_all_exist(false)
     {
@@ -146,6 +147,7 @@ protected:
     bool forced;
     bool format;
     bool check;
+    bool jsonOutput;
     long key;
     LTFSDmCommClient commCommand;
     long resident;
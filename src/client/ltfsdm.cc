@@ -57,6 +57,11 @@
 #include "PoolAddCommand.h"
 #include "PoolRemoveCommand.h"
 #include "InfoPoolsCommand.h"
+#include "InfoStatsCommand.h"
+#include "InfoSchedulerCommand.h"
+#include "InfoSqlCommand.h"
+#include "InfoTransfersCommand.h"
+#include "InfoThreadsCommand.h"
 #include "RetrieveCommand.h"
 #include "VersionCommand.h"
 
@@ -250,6 +255,17 @@ int main(int argc, char *argv[])
         } else if (InfoPoolsCommand().compare(command)) {
             ltfsdmCommand = std::unique_ptr<LTFSDMCommand>(
                     new InfoPoolsCommand);
+        } else if (InfoSchedulerCommand().compare(command)) {
+            ltfsdmCommand = std::unique_ptr<LTFSDMCommand>(
+                    new InfoSchedulerCommand);
+        } else if (InfoSqlCommand().compare(command)) {
+            ltfsdmCommand = std::unique_ptr<LTFSDMCommand>(new InfoSqlCommand);
+        } else if (InfoTransfersCommand().compare(command)) {
+            ltfsdmCommand = std::unique_ptr<LTFSDMCommand>(
+                    new InfoTransfersCommand);
+        } else if (InfoThreadsCommand().compare(command)) {
+            ltfsdmCommand = std::unique_ptr<LTFSDMCommand>(
+                    new InfoThreadsCommand);
         } else {
             MSG(LTFSDMC0012E, command.c_str());
             ltfsdmCommand = std::unique_ptr<LTFSDMCommand>(new HelpCommand);
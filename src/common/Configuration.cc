@@ -104,6 +104,10 @@ void Configuration::write()
                     << fs.second.source << " " << fs.second.fstype << " "
                     << fs.second.options << " " << fs.second.uuid << std::endl;
         }
+
+        for (std::pair<std::string, int> node : nodelist)
+            conffiletmp << "numa: " << node.first << " " << node.second
+                    << std::endl;
     }
 
     if (rename((Const::TMP_CONFIG_FILE).c_str(), (Const::CONFIG_FILE).c_str())
@@ -117,9 +121,11 @@ void Configuration::read()
     std::fstream conffile(Const::CONFIG_FILE);
     std::map<std::string, std::set<std::string>> stgplisttmp;
     std::map<std::string, fsinfo> fslisttmp;
+    std::map<std::string, int> nodelisttmp;
     std::string line;
     std::string poolName;
     std::string fsName;
+    std::string driveId;
     fsinfo finfo;
 
     std::lock_guard<std::recursive_mutex> lock(mtx);
@@ -161,6 +167,18 @@ void Configuration::read()
             if (std::getline(liness, token, ' '))
                 THROW(Error::CONFIG_FORMAT_ERROR);
             fslisttmp[fsName] = finfo;
+        } else if (token.compare("numa:") == 0) {
+            if (!std::getline(liness, driveId, ' '))
+                THROW(Error::CONFIG_FORMAT_ERROR);
+            if (!std::getline(liness, token, ' '))
+                THROW(Error::CONFIG_FORMAT_ERROR);
+            try {
+                nodelisttmp[driveId] = std::stoi(token);
+            } catch (const std::exception& e) {
+                THROW(Error::CONFIG_FORMAT_ERROR);
+            }
+            if (std::getline(liness, token, ' '))
+                THROW(Error::CONFIG_FORMAT_ERROR);
         } else {
             THROW(Error::CONFIG_FORMAT_ERROR);
         }
@@ -168,6 +186,7 @@ void Configuration::read()
 
     stgplist = stgplisttmp;
     fslist = fslisttmp;
+    nodelist = nodelisttmp;
 }
 
 void Configuration::poolCreate(std::string poolName)
@@ -320,3 +339,21 @@ std::set<std::string> Configuration::getFss()
 
     return fss;
 }
+
+/*
+ * A configured NUMA node of a drive takes precedence over the node that
+ * is determined from sysfs (see @ref drive_placement). There is no client
+ * command to set it, the line "numa: <drive id> <node>" is added manually.
+ */
+int Configuration::getNode(std::string driveId)
+
+{
+    std::map<std::string, int>::iterator it;
+
+    std::lock_guard<std::recursive_mutex> lock(mtx);
+
+    if ((it = nodelist.find(driveId)) == nodelist.end())
+        return Const::UNSET;
+
+    return it->second;
+}
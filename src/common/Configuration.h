@@ -28,6 +28,7 @@ private:
     };
     std::map<std::string, std::set<std::string>> stgplist;
     std::map<std::string, fsinfo> fslist;
+    std::map<std::string, int> nodelist;
     void write();
     std::recursive_mutex mtx;
 
@@ -46,4 +47,6 @@ public:
     void addFs(FileSystems::fsinfo newfs);
     FileSystems::fsinfo getFs(std::string target);
     std::set<std::string> getFss();
+
+    int getNode(std::string driveId);
 };
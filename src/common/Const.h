@@ -37,12 +37,30 @@ const std::string DB_FILE = LTFSDM_TMP_DIR + DELIM + "LTFSDM.db";
 const std::string CONFIG_FILE = "/etc/ltfsdm.conf";
 const std::string TMP_CONFIG_FILE = "/etc/ltfsdm.tmp.conf";
 //const std::string DB_FILE = ":memory:";
-const int MAX_RECEIVER_THREADS = 64;
+const int DB_BUSY_TIMEOUT = 60000;
+const int MAX_RECEIVER_THREADS = 16;
+const int RECEIVER_EVENTS_PER_WAIT = 64;
+const int RECEIVER_POLL_INTERVAL = 100;
+const int REQ_STATUS_INTERVAL = 10;
 const int MAX_STUBBING_THREADS = 64;
 const int MAX_PREMIG_THREADS = 16;
-const int MAX_TRANSPARENT_RECALL_THREADS = 8192;
+const int TRANSPARENT_RECALL_THREADS = 4;
+const unsigned long TRANSPARENT_RECALL_BATCH = 256;
+const int RECALL_EVENTS_PER_WAIT = 64;
 const std::chrono::seconds IDLE_THREAD_LIVE_TIME(10);
+const unsigned long THREAD_POOL_QUEUE_SIZE = 1024;
+const int EXECUTOR_THREADS_PER_CORE = 4;
+const int EXECUTOR_MIN_THREADS = 16;
+const int RECALL_WAIT_LIMIT = 60;
+const int MOUNT_PLAN_AGING = 300;
 const int MAX_OBJECTS_SEND = 100000;
+const int JOB_UPDATE_BATCH = 10000;
+const int STATUS_SLOTS = 1024;
+const int STATUS_PROBE_LENGTH = 16;
+const int STATUS_READ_RETRIES = 100;
+const std::chrono::milliseconds JOB_STATE_FLUSH_INTERVAL(100);
+const unsigned long LTFS_BLOCK_SIZE = 512 * 1024;
+const unsigned long LTFS_FILE_OVERHEAD = 4 * 1024;
 const int MAX_FUSE_BACKGROUND = 256 * 1024;
 const struct rlimit NOFILE_LIMIT = (struct rlimit ) { 1024 * 1024, 1024 * 1024 };
 const struct rlimit NPROC_LIMIT = (struct rlimit ) { 16 * 1024 * 1024, 16 * 1024
@@ -15,4 +15,4 @@
  *
  *******************************************************************************/
 #pragma once
-#define LTFSDM_VERSION "0.4.772-rhel7-protobuf.2018-06-21T14:09:34"
+#define LTFSDM_VERSION "0.4.39-master.2026-10-18T17:31:18"
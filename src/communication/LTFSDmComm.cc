@@ -194,3 +194,46 @@ void LTFSDmComm::recv(int fd)
     this->ParseFromArray(buffer, MessageSize);
     free(buffer);
 }
+
+/*
+ * Receives a message without blocking. The data that are available on
+ * the socket are appended to the buffer and the message is parsed as
+ * soon as it is complete. The data of a following message are kept
+ * within the buffer. Returns true if a message has been received.
+ */
+bool LTFSDmComm::recv(int fd, std::string *buffer)
+
+{
+    unsigned long MessageSize;
+    ssize_t rsize;
+    char data[4096];
+
+    while ((rsize = ::recv(fd, data, sizeof(data), MSG_DONTWAIT)) > 0)
+        buffer->append(data, rsize);
+
+    if (rsize == -1 && errno != EAGAIN && errno != EWOULDBLOCK) {
+        TRACE(Trace::error, errno);
+        THROW(Error::GENERAL_ERROR);
+    }
+
+    if (buffer->size() >= sizeof(long)) {
+        memcpy(&MessageSize, buffer->c_str(), sizeof(long));
+
+        if (MessageSize == 0)
+            THROW(Error::GENERAL_ERROR);
+
+        if (buffer->size() >= MessageSize + sizeof(long)) {
+            TRACE(Trace::full, MessageSize);
+            this->ParseFromArray(buffer->c_str() + sizeof(long), MessageSize);
+            buffer->erase(0, MessageSize + sizeof(long));
+            return true;
+        }
+    }
+
+    if (rsize == 0) {
+        TRACE(Trace::error, buffer->size());
+        THROW(Error::GENERAL_ERROR);
+    }
+
+    return false;
+}
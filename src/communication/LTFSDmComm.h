@@ -32,6 +32,7 @@ public:
     }
     void send(int fd);
     void recv(int fd);
+    bool recv(int fd, std::string *buffer);
 };
 
 class LTFSDmCommClient: public LTFSDmComm
@@ -82,6 +83,18 @@ public:
     }
     void listen();
     void accept();
+    int getRefFd()
+    {
+        return socRefFd;
+    }
+    int getAccFd()
+    {
+        return socAccFd;
+    }
+    void setAccFd(int fd)
+    {
+        socAccFd = fd;
+    }
     void closeAcc()
     {
         ::close(socAccFd);
@@ -100,4 +113,8 @@ public:
     {
         return LTFSDmComm::recv(socAccFd);
     }
+    bool recv(std::string *buffer)
+    {
+        return LTFSDmComm::recv(socAccFd, buffer);
+    }
 };
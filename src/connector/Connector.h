@@ -192,6 +192,8 @@ struct fuid_t
     This class is providing the recall event system. Most prominent methods are
 
     - Connector::getEvents to get a recall event
+    - Connector::eventsPending to check if further events can be obtained
+      without waiting
     - Connector::respondRecallEvent to respond a recall event
 
     Further methods initialize and stop the recall event system.
@@ -224,6 +226,7 @@ public:
     void initTransRecalls();
     void endTransRecalls();
     rec_info_t getEvents();
+    bool eventsPending();
     static void respondRecallEvent(rec_info_t recinfo, bool success);
     void terminate();
 };
@@ -557,6 +557,12 @@ Connector::rec_info_t Connector::getEvents()
 	return recinfo;
 }
 
+bool Connector::eventsPending()
+
+{
+	return false;
+}
+
 void Connector::respondRecallEvent(rec_info_t recinfo, bool success)
 
 {
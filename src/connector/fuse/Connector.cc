@@ -21,11 +21,15 @@
 #include <libmount/libmount.h>
 #include <blkid/blkid.h>
 #include <signal.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
 
 #include <sstream>
 #include <map>
 #include <set>
 #include <vector>
+#include <deque>
 #include <thread>
 
 #include "src/common/errors.h"
@@ -282,6 +286,18 @@
     - LTFSDmProtocol::LTFSDmTransRecRequest
     - LTFSDmProtocol::LTFSDmTransRecResp
 
+    Each recall event is sent on its own connection that stays open until
+    the event is responded. The backend does not receive the events one
+    after the other: the listening socket and all connections that did
+    not yet provide a complete request are non-blocking and are
+    multiplexed by an epoll instance (see Connector::getEvents). A slow
+    sender therefore does not delay other events. If a request is complete
+    the connection is removed from the epoll instance and only its file
+    descriptor is kept within conn_info_t until Connector::respondRecallEvent
+    is called. Connector::eventsPending tells if further events already
+    have been received such that the backend is able to process several
+    events together.
+
     ### Mandatory file locking
 
     LTFS Data Management requires mandatory file locking. If a file data is
@@ -310,6 +326,9 @@ std::atomic<bool> Connector::recallEventSystemStopped(false);
 Configuration *Connector::conf = nullptr;
 
 LTFSDmCommServer recrequest(Const::RECALL_SOCKET_FILE);
+int recEpollFd = Const::UNSET;
+std::map<int, std::string> recPartial;
+std::deque<Connector::rec_info_t> recReady;
 
 Connector::Connector(bool _cleanup, Configuration *_conf) :
         cleanup(_cleanup)
@@ -340,6 +359,8 @@ Connector::~Connector()
 void Connector::initTransRecalls()
 
 {
+    struct epoll_event event;
+
     try {
         recrequest.listen();
     } catch (const std::exception& e) {
@@ -347,43 +368,111 @@ void Connector::initTransRecalls()
         MSG(LTFSDMF0026E);
         THROW(Error::GENERAL_ERROR);
     }
+
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.fd = recrequest.getRefFd();
+
+    if (fcntl(event.data.fd, F_SETFL, O_NONBLOCK) == -1
+            || (recEpollFd = epoll_create1(EPOLL_CLOEXEC)) == -1
+            || epoll_ctl(recEpollFd, EPOLL_CTL_ADD, event.data.fd, &event)
+                    == -1) {
+        TRACE(Trace::error, errno);
+        MSG(LTFSDMF0026E);
+        THROW(Error::GENERAL_ERROR, errno);
+    }
 }
 
 void Connector::endTransRecalls()
 
 {
+    for (std::pair<const int, std::string>& partial : recPartial)
+        ::close(partial.first);
+    recPartial.clear();
+
+    for (Connector::rec_info_t& recinfo : recReady)
+        respondRecallEvent(recinfo, false);
+    recReady.clear();
+
+    if (recEpollFd != Const::UNSET) {
+        ::close(recEpollFd);
+        recEpollFd = Const::UNSET;
+    }
+
     recrequest.closeRef();
+    unlink(Const::RECALL_SOCKET_FILE.c_str());
 }
 
-Connector::rec_info_t Connector::getEvents()
+/*
+ * Accepts all pending connections. The connections are added to the
+ * epoll instance until a request has been received completely.
+ */
+static void acceptEvents()
 
 {
+    struct epoll_event event;
+    int fd;
+
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+
+    while ((fd = accept4(recrequest.getRefFd(), NULL, NULL,
+            SOCK_NONBLOCK | SOCK_CLOEXEC)) != -1) {
+        event.data.fd = fd;
+        if (epoll_ctl(recEpollFd, EPOLL_CTL_ADD, fd, &event) == -1) {
+            TRACE(Trace::error, errno);
+            ::close(fd);
+            continue;
+        }
+        recPartial[fd] = "";
+    }
+
+    if (errno != EAGAIN && errno != EWOULDBLOCK)
+        TRACE(Trace::error, errno);
+}
+
+/*
+ * Reads the data available on a connection. If the request is complete
+ * the connection is removed from the epoll instance and set to blocking
+ * mode again to send the response later on.
+ */
+static void readEvent(int fd)
+
+{
+    LTFSDmComm message(Const::RECALL_SOCKET_FILE);
     Connector::rec_info_t recinfo;
+    bool complete;
     long key;
 
-    recrequest.accept();
-
     try {
-        recrequest.recv();
+        complete = message.recv(fd, &recPartial[fd]);
     } catch (const std::exception& e) {
         MSG(LTFSDMF0019E, e.what(), errno);
-        THROW(Error::GENERAL_ERROR);
+        recPartial.erase(fd);
+        epoll_ctl(recEpollFd, EPOLL_CTL_DEL, fd, NULL);
+        ::close(fd);
+        return;
     }
 
+    if (complete == false)
+        return;
+
+    recPartial.erase(fd);
+    epoll_ctl(recEpollFd, EPOLL_CTL_DEL, fd, NULL);
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+
     const LTFSDmProtocol::LTFSDmTransRecRequest request =
-            recrequest.transrecrequest();
+            message.transrecrequest();
 
     key = request.key();
     if (FuseConnector::ltfsdmKey != key) {
         TRACE(Trace::error, (long ) FuseConnector::ltfsdmKey, key);
-        recinfo = (rec_info_t ) { NULL, false, (fuid_t ) { 0, 0, 0, 0 }, "" };
-        return recinfo;
+        ::close(fd);
+        return;
     }
 
-    struct conn_info_t *conn_info = new struct conn_info_t;
-    conn_info->reqrequest = new LTFSDmCommServer(recrequest);
-
-    recinfo.conn_info = conn_info;
+    recinfo.conn_info = new struct conn_info_t;
+    recinfo.conn_info->fd = fd;
     recinfo.toresident = request.toresident();
     recinfo.fuid = (fuid_t ) { (unsigned long) request.fsidh(),
                     (unsigned long) request.fsidl(),
@@ -394,19 +483,69 @@ Connector::rec_info_t Connector::getEvents()
     TRACE(Trace::always, recinfo.filename, recinfo.fuid.inum,
             recinfo.toresident);
 
+    recReady.push_back(recinfo);
+}
+
+/*
+ * Waits up to timeout milliseconds (-1: infinitely) for activity on the
+ * recall socket and processes all connections that are ready.
+ */
+static void waitEvents(int timeout)
+
+{
+    struct epoll_event events[Const::RECALL_EVENTS_PER_WAIT];
+    int num;
+
+    if ((num = epoll_wait(recEpollFd, events, Const::RECALL_EVENTS_PER_WAIT,
+            timeout)) == -1) {
+        if (errno == EINTR)
+            return;
+        TRACE(Trace::error, errno);
+        THROW(Error::GENERAL_ERROR, errno);
+    }
+
+    for (int i = 0; i < num; i++) {
+        if (events[i].data.fd == recrequest.getRefFd())
+            acceptEvents();
+        else
+            readEvent(events[i].data.fd);
+    }
+}
+
+Connector::rec_info_t Connector::getEvents()
+
+{
+    Connector::rec_info_t recinfo;
+
+    while (recReady.empty())
+        waitEvents(-1);
+
+    recinfo = recReady.front();
+    recReady.pop_front();
+
     return recinfo;
 }
 
+bool Connector::eventsPending()
+
+{
+    if (recReady.empty())
+        waitEvents(0);
+
+    return recReady.empty() == false;
+}
+
 void Connector::respondRecallEvent(rec_info_t recinfo, bool success)
 
 {
+    LTFSDmComm response(Const::RECALL_SOCKET_FILE);
     LTFSDmProtocol::LTFSDmTransRecResp *trecresp =
-            recinfo.conn_info->reqrequest->mutable_transrecresp();
+            response.mutable_transrecresp();
 
     trecresp->set_success(success);
 
     try {
-        recinfo.conn_info->reqrequest->send();
+        response.send(recinfo.conn_info->fd);
     } catch (const std::exception& e) {
         TRACE(Trace::error, e.what());
         MSG(LTFSDMS0007E);
@@ -414,10 +553,7 @@ void Connector::respondRecallEvent(rec_info_t recinfo, bool success)
 
     TRACE(Trace::always, recinfo.filename, success);
 
-    trecresp->Clear();
-    recinfo.conn_info->reqrequest->closeAcc();
-
-    delete (recinfo.conn_info->reqrequest);
+    ::close(recinfo.conn_info->fd);
     delete (recinfo.conn_info);
 }
 
@@ -279,5 +279,5 @@ public:
 
 struct conn_info_t
 {
-    LTFSDmCommServer *reqrequest;
+    int fd;
 };
@@ -20,11 +20,31 @@ DataBase DB;
 
 std::mutex DataBase::trans_mutex;
 
+thread_local DataBase::ThreadConnection DataBase::threadConn;
+
+const DataBase::storage_profile_t DataBase::DEFAULT_PROFILE = { "", "", 0, 0,
+        false };
+
+const DataBase::storage_profile_t DataBase::WAL_PROFILE = { "WAL", "NORMAL",
+        64 * 1024, 256, true };
+
+thread_local SQLStatement::StatementCache SQLStatement::cache;
+
+bool SQLStatement::profiling = false;
+
+thread_local SQLStatement::ProfileTable SQLStatement::profileTable;
+
+std::mutex SQLStatement::profileMutex;
+
+std::set<SQLStatement::ProfileTable*> SQLStatement::profileTables;
+
+std::unordered_map<std::string, SQLStatement::profile_t> SQLStatement::retiredProfiles;
+
 DataBase::~DataBase()
 
 {
     if (dbNeedsClosed)
-        sqlite3_close(db);
+        sqlite3_close_v2(db);
 
     sqlite3_shutdown();
 }
@@ -34,68 +54,174 @@ void DataBase::cleanup()
 {
     unlink(Const::DB_FILE.c_str());
     unlink((Const::DB_FILE + "-journal").c_str());
+    unlink((Const::DB_FILE + "-wal").c_str());
+    unlink((Const::DB_FILE + "-shm").c_str());
 }
 
-void DataBase::fits(sqlite3_context *ctx, int argc, sqlite3_value **argv)
+/*
+ * The storage profile is selected with the -s option of ltfsdmd. It is
+ * either the name of a profile ("default" or "wal") or a comma separated
+ * list of a profile name and settings overriding it, e.g.
+ * "wal,synchronous=full,cache=32768". The following settings exist:
+ *
+ * journal=<SQLite journal mode>
+ * synchronous=off|normal|full
+ * cache=<page cache size in KiB>
+ * mmap=<memory map size in MiB>
+ * connections=shared|thread
+ */
+DataBase::storage_profile_t DataBase::parseProfile(std::string spec)
 
 {
-    assert(argc == 5);
-
-    unsigned long size = sqlite3_value_int64(argv[1]);
-    unsigned long *free = (unsigned long *) sqlite3_value_int64(argv[2]);
-    unsigned long *num_found = (unsigned long *) sqlite3_value_int64(argv[3]);
-    unsigned long *total = (unsigned long *) sqlite3_value_int64(argv[4]);
+    storage_profile_t prof = DEFAULT_PROFILE;
+    std::stringstream specstream(spec);
+    std::string item;
+
+    while (std::getline(specstream, item, ',')) {
+        std::string::size_type pos = item.find('=');
+        std::string key = item.substr(0, pos);
+        std::string value;
+
+        if (pos == std::string::npos) {
+            if (key.compare("default") == 0)
+                prof = DEFAULT_PROFILE;
+            else if (key.compare("wal") == 0)
+                prof = WAL_PROFILE;
+            else
+                THROW(Error::GENERAL_ERROR, spec);
+            continue;
+        }
 
-    if (*free >= size) {
-        *free -= size;
-        (*total)++;
-        (*num_found)++;
-        sqlite3_result_int(ctx, 1);
-    } else {
-        (*total)++;
-        sqlite3_result_int(ctx, 0);
+        value = item.substr(pos + 1);
+        std::transform(value.begin(), value.end(), value.begin(), ::toupper);
+
+        try {
+            if (key.compare("journal") == 0) {
+                if (value.compare("DELETE") != 0
+                        && value.compare("TRUNCATE") != 0
+                        && value.compare("PERSIST") != 0
+                        && value.compare("MEMORY") != 0
+                        && value.compare("WAL") != 0)
+                    THROW(Error::GENERAL_ERROR, spec);
+                prof.journalMode = value;
+            } else if (key.compare("synchronous") == 0) {
+                if (value.compare("OFF") != 0 && value.compare("NORMAL") != 0
+                        && value.compare("FULL") != 0)
+                    THROW(Error::GENERAL_ERROR, spec);
+                prof.synchronous = value;
+            } else if (key.compare("cache") == 0) {
+                prof.cacheSize = std::stol(value);
+            } else if (key.compare("mmap") == 0) {
+                prof.mmapSize = std::stol(value);
+            } else if (key.compare("connections") == 0) {
+                if (value.compare("SHARED") == 0)
+                    prof.perThread = false;
+                else if (value.compare("THREAD") == 0)
+                    prof.perThread = true;
+                else
+                    THROW(Error::GENERAL_ERROR, spec);
+            } else {
+                THROW(Error::GENERAL_ERROR, spec);
+            }
+        } catch (const std::invalid_argument& e) {
+            THROW(Error::GENERAL_ERROR, spec);
+        } catch (const std::out_of_range& e) {
+            THROW(Error::GENERAL_ERROR, spec);
+        }
     }
+
+    return prof;
 }
 
-void DataBase::open(bool dbUseMemory)
+sqlite3 *DataBase::openConnection()
 
 {
+    sqlite3 *conn = NULL;
+    std::stringstream pragmas;
+    int flags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE;
     int rc;
-    std::string sql;
-    std::string uri;
 
-    if (dbUseMemory)
-        uri = "file::memory:";
+    // a connection per thread is only used by that thread
+    if (profile.perThread)
+        flags |= SQLITE_OPEN_NOMUTEX;
     else
-        uri = std::string("file:") + Const::DB_FILE;
+        flags |= SQLITE_OPEN_FULLMUTEX | SQLITE_OPEN_SHAREDCACHE
+                | SQLITE_OPEN_EXCLUSIVE;
 
-    rc = sqlite3_config(SQLITE_CONFIG_URI, 1);
+    rc = sqlite3_open_v2(uri.c_str(), &conn, flags, NULL);
 
     if (rc != SQLITE_OK) {
-        TRACE(Trace::error, rc);
+        TRACE(Trace::error, rc, uri);
+        sqlite3_close_v2(conn);
         errno = rc;
         THROW(Error::GENERAL_ERROR, uri, rc);
     }
 
-    rc = sqlite3_initialize();
+    rc = sqlite3_extended_result_codes(conn, 1);
 
     if (rc != SQLITE_OK) {
         TRACE(Trace::error, rc);
+        sqlite3_close_v2(conn);
+        errno = rc;
+        THROW(Error::GENERAL_ERROR, rc);
+    }
+
+    if (profile.perThread)
+        sqlite3_busy_timeout(conn, Const::DB_BUSY_TIMEOUT);
+
+    if (profile.synchronous.compare("") != 0)
+        pragmas << "PRAGMA synchronous=" << profile.synchronous << ";";
+    if (profile.cacheSize != 0)
+        pragmas << "PRAGMA cache_size=" << -profile.cacheSize << ";";
+    if (profile.mmapSize != 0)
+        pragmas << "PRAGMA mmap_size=" << profile.mmapSize * 1024 * 1024
+                << ";";
+
+    if ((rc = sqlite3_exec(conn, pragmas.str().c_str(), NULL, NULL, NULL))
+            != SQLITE_OK) {
+        TRACE(Trace::error, pragmas.str(), rc);
+        sqlite3_close_v2(conn);
         errno = rc;
         THROW(Error::GENERAL_ERROR, rc);
     }
 
-    rc = sqlite3_open_v2(uri.c_str(), &db, SQLITE_OPEN_READWRITE |
-    SQLITE_OPEN_CREATE | SQLITE_OPEN_FULLMUTEX |
-    SQLITE_OPEN_SHAREDCACHE | SQLITE_OPEN_EXCLUSIVE, NULL);
+    TRACE(Trace::normal, pragmas.str());
+
+    return conn;
+}
+
+DataBase::ThreadConnection::~ThreadConnection()
+
+{
+    if (db != nullptr)
+        sqlite3_close_v2(db);
+}
+
+void DataBase::open(bool dbUseMemory, storage_profile_t _profile)
+
+{
+    int rc;
+    std::string journal;
+
+    profile = _profile;
+
+    if (dbUseMemory) {
+        uri = "file::memory:";
+        // other connections would not see the in-memory database
+        profile.perThread = false;
+    } else {
+        uri = std::string("file:") + Const::DB_FILE;
+    }
+
+    rc = sqlite3_config(SQLITE_CONFIG_URI, 1);
 
     if (rc != SQLITE_OK) {
-        TRACE(Trace::error, rc, uri);
+        TRACE(Trace::error, rc);
         errno = rc;
         THROW(Error::GENERAL_ERROR, uri, rc);
     }
 
-    rc = sqlite3_extended_result_codes(db, 1);
+    rc = sqlite3_initialize();
 
     if (rc != SQLITE_OK) {
         TRACE(Trace::error, rc);
@@ -103,10 +229,23 @@ void DataBase::open(bool dbUseMemory)
         THROW(Error::GENERAL_ERROR, rc);
     }
 
+    db = openConnection();
+
     dbNeedsClosed = true;
 
-    sqlite3_create_function(db, "FITS", 5, SQLITE_UTF8, NULL, &DataBase::fits,
-    NULL, NULL);
+    // the journal mode is a property of the database file
+    if (profile.journalMode.compare("") != 0) {
+        journal = std::string("PRAGMA journal_mode=") + profile.journalMode;
+        if ((rc = sqlite3_exec(db, journal.c_str(), NULL, NULL, NULL))
+                != SQLITE_OK) {
+            TRACE(Trace::error, journal, rc);
+            errno = rc;
+            THROW(Error::GENERAL_ERROR, rc);
+        }
+    }
+
+    TRACE(Trace::always, uri, profile.journalMode, profile.synchronous,
+            profile.cacheSize, profile.mmapSize, profile.perThread);
 }
 
 void DataBase::createTables()
@@ -114,13 +253,24 @@ void DataBase::createTables()
 {
     SQLStatement stmt;
 
-    stmt(DataBase::CREATE_JOB_QUEUE);
+    stmt(DataBase::CREATE_REQUEST_QUEUE);
     stmt.doall();
 
-    stmt(DataBase::CREATE_REQUEST_QUEUE);
+    stmt(DataBase::CREATE_REQUEST_QUEUE_STATE_INDEX);
     stmt.doall();
 }
 
+/*
+ * The TIME_ADDED column of the REQUEST_QUEUE table is in milliseconds to
+ * measure the queue wait of requests that are scheduled within a second.
+ */
+long DataBase::timeAdded()
+
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
 std::string DataBase::opStr(DataBase::operation op)
 
 {
@@ -164,12 +314,112 @@ std::string DataBase::reqStateStr(DataBase::req_state reqs)
 int DataBase::lastUpdates()
 
 {
-    return sqlite3_changes(db);
+    return sqlite3_changes(getDB());
+}
+
+/*
+ * By default all threads share a single connection and therefore a
+ * single transaction. Only one thread at a time may start a transaction.
+ * The statements of other threads that are executed in the meantime
+ * become part of it. For that reason a transaction is not rolled back if
+ * a statement fails: a failing statement (e.g. a constraint violation)
+ * only undoes its own changes and the transaction is committed anyway.
+ * Only if the commit itself fails the transaction is rolled back to not
+ * leave the connection within it. With a connection per
+ * thread the transaction is started immediately as a write transaction
+ * to avoid that it fails when trying to upgrade from a read transaction.
+ */
+void DataBase::beginTransaction()
+
+{
+    std::chrono::steady_clock::time_point start =
+            std::chrono::steady_clock::now();
+
+    trans_mutex.lock();
+
+    if (SQLStatement::profiling) {
+        SQLStatement::profile_t prof;
+        prof.lockWaitNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count();
+        SQLStatement::record(DataBase::BEGIN_TRANSACTION, prof);
+    }
+
+    try {
+        SQLStatement stmt(DataBase::BEGIN_TRANSACTION);
+        stmt.doall();
+    } catch (const std::exception& e) {
+        trans_mutex.unlock();
+        throw;
+    }
+}
+
+void DataBase::endTransaction()
+
+{
+    SQLStatement::profile_t prof;
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::time_point limit =
+            std::chrono::steady_clock::now()
+                    + std::chrono::milliseconds(Const::DB_BUSY_TIMEOUT);
+    int rc;
+
+    prof.executions = 1;
+
+    while (true) {
+        start = std::chrono::steady_clock::now();
+        rc = sqlite3_exec(getDB(), COMMIT_TRANSACTION.c_str(), NULL, NULL,
+        NULL);
+        prof.stepNs += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count();
+        if (rc != SQLITE_BUSY || std::chrono::steady_clock::now() >= limit)
+            break;
+        start = std::chrono::steady_clock::now();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        prof.lockWaitNs += std::chrono::duration_cast<
+                std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count();
+    }
+
+    if (rc != SQLITE_OK && sqlite3_get_autocommit(getDB()) == 0) {
+        int rrc = sqlite3_exec(getDB(), ROLLBACK_TRANSACTION.c_str(), NULL,
+        NULL, NULL);
+        TRACE(Trace::error, rc, rrc);
+    }
+
+    trans_mutex.unlock();
+
+    if (SQLStatement::profiling)
+        SQLStatement::record(COMMIT_TRANSACTION, prof);
+
+    if (rc != SQLITE_OK) {
+        TRACE(Trace::error, rc);
+        MSG(LTFSDMS0119E, rc);
+        errno = rc;
+        THROW(Error::GENERAL_ERROR, rc);
+    }
+}
+
+DataBase::Transaction::Transaction()
+
+{
+    DB.beginTransaction();
+}
+
+DataBase::Transaction::~Transaction()
+
+{
+    try {
+        DB.endTransaction();
+    } catch (const std::exception& e) {
+        TRACE(Trace::error, e.what());
+    }
 }
 
 SQLStatement& SQLStatement::operator()(std::string _fmtstr)
 
 {
+    release();
+
     fmtstr = _fmtstr;
 
     try {
@@ -182,13 +432,117 @@ SQLStatement& SQLStatement::operator()(std::string _fmtstr)
     return *this;
 }
 
+/*
+ * Statements that are executed once per file (e.g. adding a job) are
+ * prepared only once per thread and kept in a thread local cache. The
+ * template text has to use ?NNN parameters that are bound in the order
+ * the values are passed with operator<<. A cached statement is reset
+ * instead of finalized and can be reused by the next object.
+ */
+SQLStatement::StatementCache::~StatementCache()
+
+{
+    for (auto& entry : stmts)
+        sqlite3_finalize(entry.second.stmt);
+}
+
+SQLStatement& SQLStatement::cached(const std::string& sql)
+
+{
+    sqlite3 *db = DB.getDB();
+    int rc;
+
+    release();
+
+    fmtstr = sql;
+    stmt_rc = 0;
+    bindPos = 0;
+
+    cached_stmt_t& entry = cache.stmts[sql];
+
+    if (entry.stmt != nullptr && entry.db != db) {
+        sqlite3_finalize(entry.stmt);
+        entry.stmt = nullptr;
+        entry.inUse = false;
+    }
+
+    std::chrono::steady_clock::time_point start =
+            std::chrono::steady_clock::now();
+
+    if (entry.inUse) {
+        // already used within this thread: use a private statement
+        rc = sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, NULL);
+        prof.prepares++;
+    } else {
+        if (entry.stmt == nullptr) {
+            rc = sqlite3_prepare_v2(db, sql.c_str(), -1, &entry.stmt, NULL);
+            entry.db = db;
+            prof.prepares++;
+        } else {
+            rc = sqlite3_clear_bindings(entry.stmt);
+        }
+        if (rc == SQLITE_OK) {
+            entry.inUse = true;
+            centry = &entry;
+            stmt = entry.stmt;
+        } else {
+            cache.stmts.erase(sql);
+        }
+    }
+
+    if (prof.prepares != 0)
+        prof.prepareNs += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count();
+
+    if (rc != SQLITE_OK) {
+        TRACE(Trace::error, sql, rc);
+        stmt = nullptr;
+        errno = rc;
+        THROW(Error::GENERAL_ERROR, rc);
+    }
+
+    bindMode = true;
+
+    return *this;
+}
+
+void SQLStatement::release()
+
+{
+    account();
+
+    if (bindMode == false)
+        return;
+
+    if (centry != nullptr) {
+        sqlite3_reset(centry->stmt);
+        centry->inUse = false;
+        centry = nullptr;
+    } else if (stmt != nullptr) {
+        sqlite3_finalize(stmt);
+    }
+
+    stmt = nullptr;
+    bindMode = false;
+}
+
 void SQLStatement::prepare()
 
 {
     int rc;
 
+    if (bindMode)
+        return;
+
+    std::chrono::steady_clock::time_point start =
+            std::chrono::steady_clock::now();
+
     rc = sqlite3_prepare_v2(DB.getDB(), fmt.str().c_str(), -1, &stmt, NULL);
 
+    prof.prepares++;
+    prof.prepareNs += std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+
     if (rc != SQLITE_OK) {
         TRACE(Trace::error, fmt.str(), rc);
         errno = rc;
@@ -303,6 +657,9 @@ std::string SQLStatement::str()
 {
     std::string str;
 
+    if (bindMode)
+        return fmtstr;
+
     try {
         str = fmt.str();
     } catch (const std::exception& e) {
@@ -325,13 +682,53 @@ void SQLStatement::bind(int num, int value)
     }
 }
 
+void SQLStatement::bind(int num, unsigned int value)
+
+{
+    bind(num, static_cast<int>(value));
+}
+
+void SQLStatement::bind(int num, long value)
+
+{
+    int rc;
+
+    if ((rc = sqlite3_bind_int64(stmt, num, value)) != SQLITE_OK) {
+        TRACE(Trace::error, rc);
+        errno = rc;
+        THROW(Error::GENERAL_ERROR, rc);
+    }
+}
+
+// convert unsigned to signed since there is unsigned in SQLite
+void SQLStatement::bind(int num, unsigned long value)
+
+{
+    bind(num, static_cast<long>(value));
+}
+
 void SQLStatement::bind(int num, std::string value)
 
 {
     int rc;
 
-    if ((rc = sqlite3_bind_text(stmt, num, value.c_str(), value.size(), 0))
-            != SQLITE_OK) {
+    if (bindMode)
+        value = encode(value);
+
+    if ((rc = sqlite3_bind_text(stmt, num, value.c_str(), value.size(),
+    SQLITE_TRANSIENT)) != SQLITE_OK) {
+        TRACE(Trace::error, rc);
+        errno = rc;
+        THROW(Error::GENERAL_ERROR, rc);
+    }
+}
+
+void SQLStatement::bindNull(int num)
+
+{
+    int rc;
+
+    if ((rc = sqlite3_bind_null(stmt, num)) != SQLITE_OK) {
         TRACE(Trace::error, rc);
         errno = rc;
         THROW(Error::GENERAL_ERROR, rc);
@@ -341,16 +738,25 @@ void SQLStatement::bind(int num, std::string value)
 void SQLStatement::finalize()
 
 {
+    account();
+
+    // keep the statement and its bindings for a further step
+    if (bindMode)
+        sqlite3_reset(stmt);
+
     if (stmt_rc != SQLITE_ROW && stmt_rc != SQLITE_DONE) {
-        TRACE(Trace::error, fmt.str(), stmt_rc);
+        TRACE(Trace::error, str(), stmt_rc);
         errno = stmt_rc;
         THROW(Error::GENERAL_ERROR, stmt_rc);
     }
 
+    if (bindMode)
+        return;
+
     int rc = sqlite3_finalize(stmt);
 
     if (rc != SQLITE_OK) {
-        TRACE(Trace::error, fmt.str(), rc);
+        TRACE(Trace::error, str(), rc);
         errno = rc;
         THROW(Error::GENERAL_ERROR, rc);
     }
@@ -363,3 +769,117 @@ void SQLStatement::doall()
     step();
     finalize();
 }
+
+/*
+ * If the backend is started with option -p the execution of the
+ * statements is profiled per statement template (see @ref sqlite).
+ * The values are collected within a table per thread that only is
+ * locked by its own thread and by SQLStatement::getProfiles. The table
+ * is merged into the retired profiles when the thread ends.
+ */
+SQLStatement::ProfileTable::ProfileTable()
+
+{
+    std::lock_guard<std::mutex> lock(profileMutex);
+
+    profileTables.insert(this);
+}
+
+SQLStatement::ProfileTable::~ProfileTable()
+
+{
+    std::lock_guard<std::mutex> lock(profileMutex);
+
+    for (const auto& entry : stmts)
+        merge(&retiredProfiles[entry.first], entry.second);
+
+    profileTables.erase(this);
+}
+
+void SQLStatement::merge(SQLStatement::profile_t *to,
+        const SQLStatement::profile_t& from)
+
+{
+    to->executions += from.executions;
+    to->prepares += from.prepares;
+    to->prepareNs += from.prepareNs;
+    to->stepNs += from.stepNs;
+    to->lockWaitNs += from.lockWaitNs;
+    to->rows += from.rows;
+    to->changes += from.changes;
+}
+
+void SQLStatement::record(const std::string& sql,
+        const SQLStatement::profile_t& p)
+
+{
+    std::lock_guard<std::mutex> lock(profileTable.mtx);
+
+    merge(&profileTable.stmts[sql], p);
+}
+
+std::map<std::string, SQLStatement::profile_t> SQLStatement::getProfiles()
+
+{
+    std::map<std::string, profile_t> profiles;
+
+    std::lock_guard<std::mutex> lock(profileMutex);
+
+    for (const auto& entry : retiredProfiles)
+        merge(&profiles[entry.first], entry.second);
+
+    for (ProfileTable *table : profileTables) {
+        std::lock_guard<std::mutex> tablelock(table->mtx);
+        for (const auto& entry : table->stmts)
+            merge(&profiles[entry.first], entry.second);
+    }
+
+    return profiles;
+}
+
+/*
+ * The mutex of the connection is acquired before the statement is
+ * executed to measure the time waiting for other threads that share the
+ * same connection. It is recursive and acquired again by SQLite. With a
+ * connection per thread there is no mutex and the time waiting for locks
+ * of other connections is part of the execution time.
+ */
+int SQLStatement::profiledStep()
+
+{
+    sqlite3 *db = sqlite3_db_handle(stmt);
+    sqlite3_mutex *mutex = sqlite3_db_mutex(db);
+    std::chrono::steady_clock::time_point start =
+            std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point locked;
+    int rc;
+
+    sqlite3_mutex_enter(mutex);
+    locked = std::chrono::steady_clock::now();
+
+    rc = sqlite3_step(stmt);
+
+    if (rc == SQLITE_DONE && sqlite3_stmt_readonly(stmt) == 0)
+        prof.changes += sqlite3_changes(db);
+
+    sqlite3_mutex_leave(mutex);
+
+    prof.stepNs += std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - locked).count();
+    prof.lockWaitNs += std::chrono::duration_cast<std::chrono::nanoseconds>(
+            locked - start).count();
+    prof.executions = 1;
+    if (rc == SQLITE_ROW)
+        prof.rows++;
+
+    return rc;
+}
+
+void SQLStatement::account()
+
+{
+    if (profiling && (prof.executions != 0 || prof.prepares != 0))
+        record(fmtstr, prof);
+
+    prof = profile_t();
+}
@@ -18,12 +18,33 @@
 
 class DataBase
 {
+public:
+    struct storage_profile_t
+    {
+        std::string journalMode;
+        std::string synchronous;
+        long cacheSize;
+        long mmapSize;
+        bool perThread;
+    };
 private:
+    class ThreadConnection
+    {
+    public:
+        sqlite3 *db = nullptr;
+        ~ThreadConnection();
+    };
+    static thread_local ThreadConnection threadConn;
     sqlite3 *db;
     bool dbNeedsClosed;
-    static void fits(sqlite3_context *ctx, int argc, sqlite3_value **argv);
-    static const std::string CREATE_JOB_QUEUE;
+    std::string uri;
+    storage_profile_t profile;
+    sqlite3 *openConnection();
     static const std::string CREATE_REQUEST_QUEUE;
+    static const std::string CREATE_REQUEST_QUEUE_STATE_INDEX;
+    static const std::string BEGIN_TRANSACTION;
+    static const std::string COMMIT_TRANSACTION;
+    static const std::string ROLLBACK_TRANSACTION;
 public:
     enum operation
     {
@@ -44,19 +65,37 @@ public:
         REQ_COMPLETED /**@< 2 */
     };
     static std::mutex trans_mutex;
+    class Transaction
+    {
+    public:
+        Transaction();
+        ~Transaction();
+    };
+    static const storage_profile_t DEFAULT_PROFILE;
+    static const storage_profile_t WAL_PROFILE;
     DataBase() :
-            db(NULL), dbNeedsClosed(false)
+            db(NULL), dbNeedsClosed(false), uri(""), profile(DEFAULT_PROFILE)
     {
     }
     ~DataBase();
+    static storage_profile_t parseProfile(std::string spec);
     void cleanup();
-    void open(bool dbUseMemory);
+    void open(bool dbUseMemory, storage_profile_t _profile);
     void createTables();
     int lastUpdates();
+    void beginTransaction();
+    void endTransaction();
     sqlite3 *getDB()
     {
-        return db;
+        if (profile.perThread == false)
+            return db;
+
+        if (threadConn.db == nullptr)
+            threadConn.db = openConnection();
+
+        return threadConn.db;
     }
+    static long timeAdded();
     static std::string opStr(operation op);
     static std::string reqStateStr(req_state reqs);
 };
@@ -65,11 +104,61 @@ extern DataBase DB;
 
 class SQLStatement
 {
+public:
+    struct profile_t
+    {
+        unsigned long executions = 0;
+        unsigned long prepares = 0;
+        unsigned long prepareNs = 0;
+        unsigned long stepNs = 0;
+        unsigned long lockWaitNs = 0;
+        unsigned long rows = 0;
+        unsigned long changes = 0;
+    };
 private:
+    struct cached_stmt_t
+    {
+        sqlite3 *db;
+        sqlite3_stmt *stmt;
+        bool inUse;
+    };
+
+    class StatementCache
+    {
+    public:
+        std::unordered_map<std::string, cached_stmt_t> stmts;
+        ~StatementCache();
+    };
+
+    static thread_local StatementCache cache;
+
+    class ProfileTable
+    {
+    public:
+        std::mutex mtx;
+        std::unordered_map<std::string, profile_t> stmts;
+        ProfileTable();
+        ~ProfileTable();
+    };
+
+    static thread_local ProfileTable profileTable;
+    static std::mutex profileMutex;
+    static std::set<ProfileTable*> profileTables;
+    static std::unordered_map<std::string, profile_t> retiredProfiles;
+
     std::string fmtstr;
     sqlite3_stmt *stmt;
     boost::format fmt;
     int stmt_rc;
+    cached_stmt_t *centry;
+    bool bindMode;
+    int bindPos;
+    profile_t prof;
+
+    void release();
+    static void merge(profile_t *to, const profile_t& from);
+    int profiledStep();
+    void account();
 
     std::string encode(std::string s);
     std::string decode(std::string s);
@@ -102,23 +191,44 @@ private:
     }
 
 public:
+    static bool profiling;
+    static void record(const std::string& sql, const profile_t& p);
+    static std::map<std::string, profile_t> getProfiles();
+
     SQLStatement() :
-            fmtstr(""), stmt(nullptr), fmt(""), stmt_rc(0)
+            fmtstr(""), stmt(nullptr), fmt(""), stmt_rc(0), centry(nullptr), bindMode(
+                    false), bindPos(0)
     {
     }
     SQLStatement(std::string _fmtstr) :
             fmtstr(_fmtstr), stmt(nullptr), fmt(boost::format(fmtstr)), stmt_rc(
-                    0)
+                    0), centry(nullptr), bindMode(false), bindPos(0)
+    {
+    }
+    // cached statements are owned by a single object and must not be copied
+    SQLStatement(const SQLStatement& other) :
+            fmtstr(other.fmtstr), stmt(other.stmt), fmt(other.fmt), stmt_rc(
+                    other.stmt_rc), centry(nullptr), bindMode(false), bindPos(0)
     {
+        if (other.bindMode)
+            THROW(Error::GENERAL_ERROR, fmtstr);
     }
+    SQLStatement& operator=(const SQLStatement& other) = delete;
     SQLStatement& operator()(std::string _fmtstr);
+    SQLStatement& cached(const std::string& sql);
     ~SQLStatement()
     {
+        release();
     }
 
     // convert unsigned to signed since there is unsigned in SQLite
     SQLStatement& operator<<(unsigned long long llu)
     {
+        if (bindMode) {
+            bind(++bindPos, static_cast<long>(llu));
+            return *this;
+        }
+
         try {
             fmt % static_cast<long>(llu);
         } catch (const std::exception& e) {
@@ -130,6 +240,11 @@ public:
 
     SQLStatement& operator<<(unsigned long lu)
     {
+        if (bindMode) {
+            bind(++bindPos, lu);
+            return *this;
+        }
+
         try {
             fmt % static_cast<long>(lu);
         } catch (const std::exception& e) {
@@ -142,6 +257,11 @@ public:
 
     SQLStatement& operator<<(std::string s)
     {
+        if (bindMode) {
+            bind(++bindPos, s);
+            return *this;
+        }
+
         try {
             fmt % encode(s);
         } catch (const std::exception& e) {
@@ -154,6 +274,11 @@ public:
 
     SQLStatement& operator<<(unsigned int u)
     {
+        if (bindMode) {
+            bind(++bindPos, u);
+            return *this;
+        }
+
         try {
             fmt % static_cast<int>(u);
         } catch (const std::exception& e) {
@@ -167,6 +292,11 @@ public:
     template<typename T>
     SQLStatement& operator<<(T s)
     {
+        if (bindMode) {
+            bind(++bindPos, s);
+            return *this;
+        }
+
         try {
             fmt % (s);
         } catch (const std::exception& e) {
@@ -179,7 +309,11 @@ public:
 
     std::string str();
     void bind(int num, int value);
+    void bind(int num, unsigned int value);
+    void bind(int num, long value);
+    void bind(int num, unsigned long value);
     void bind(int num, std::string value);
+    void bindNull(int num);
     void prepare();
 
     template<typename ... Args>
@@ -187,7 +321,10 @@ public:
     {
         int column = 0;
 
-        stmt_rc = sqlite3_step(stmt);
+        if (profiling)
+            stmt_rc = profiledStep();
+        else
+            stmt_rc = sqlite3_step(stmt);
 
         if (stmt_rc != SQLITE_ROW)
             return false;
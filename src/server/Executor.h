@@ -0,0 +1,490 @@
+/*******************************************************************************
+ * Copyright 2018 IBM Corp. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *******************************************************************************/
+#pragma once
+
+/** @page executor Executor
+
+    All ThreadPool objects of the backend share a single Executor
+    (Executor::instance). Each ThreadPool corresponds to a task group
+    (Executor::Group) that has
+
+    - a name that is set as thread name while a task of the group is
+      executed,
+    - a priority (Executor::priority): tasks of higher priority are
+      executed first,
+    - a limit of tasks that are executed concurrently, further tasks
+      are kept within the group until a task of the group completes,
+    - the information if its tasks block (e.g. waiting for a client,
+      for a cartridge or for the completion of other tasks).
+
+    The number of core threads is proportional to the number of
+    processors (Const::EXECUTOR_THREADS_PER_CORE, at least
+    Const::EXECUTOR_MIN_THREADS). These are started when the first
+    tasks are submitted (after the backend has been detached) and do
+    not terminate. Each core thread has its own queue per priority. A
+    task submitted by a core thread is added to its own queue, tasks
+    submitted by other threads to a common queue. A thread that runs out
+    of work takes tasks from the common queue and steals tasks from the
+    queues of the other core threads.
+
+    While a task of a blocking group is executed the thread does not
+    count as running. If there is further work and no idle thread, a
+    spare thread is started such that the number of running threads
+    stays at the number of core threads. Spare threads terminate after
+    Const::IDLE_THREAD_LIVE_TIME of inactivity. This way a task that
+    waits for other tasks cannot prevent them from being executed.
+
+    Every blocked task can add a thread. Therefore only groups whose
+    tasks wait most of the time are blocking (the SubServer, Migration::swq
+    and the data transfer pools). Groups with short tasks (e.g. "msg-wq",
+    "trec-wq", "stub1-wq") are not blocking and run on the core threads
+    only. If such a task has to wait it marks the thread as blocked for
+    this time by an Executor::Blocker object. ThreadPool::waitCompletion
+    and SubServer::waitAllRemaining do so such that waiting for other
+    tasks cannot exhaust the core threads.
+
+    The executor records the number of threads and per group the time
+    tasks are waiting to be executed and their execution time. These are
+    provided by Executor::getMetrics as "threads" category of the
+    @ref metrics (see @ref ltfsdm_info_threads "ltfsdm info threads").
+ */
+
+class Executor
+{
+public:
+    class Blocker
+    {
+    public:
+        Blocker()
+        {
+            Executor::instance().block();
+        }
+        ~Blocker()
+        {
+            Executor::instance().unblock();
+        }
+    };
+    enum priority
+    {
+        HIGH,
+        NORMAL,
+        LOW,
+        NUM_PRIORITIES
+    };
+    typedef std::function<void()> task_t;
+    class Group
+    {
+        friend class Executor;
+    private:
+        struct pending_t
+        {
+            std::chrono::steady_clock::time_point submitted;
+            task_t task;
+        };
+        const std::string name;
+        const priority prio;
+        const int limit;
+        const bool blocking;
+        std::mutex mtx;
+        int running;
+        int peak;
+        std::deque<pending_t> pending;
+        Metrics::histogram_t queueWait;
+        Metrics::histogram_t runTime;
+        Metrics::histogram_t enqueueWait;
+    public:
+        Group(std::string _name, priority _prio, int _limit, bool _blocking) :
+                name(_name), prio(_prio), limit(_limit), blocking(_blocking), running(
+                        0), peak(0)
+        {
+        }
+        void addEnqueueWait(std::chrono::steady_clock::duration duration)
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            Metrics::record(&enqueueWait, duration);
+        }
+    };
+private:
+    struct item_t
+    {
+        std::shared_ptr<Group> group;
+        task_t task;
+        std::chrono::steady_clock::time_point submitted;
+    };
+    class Worker
+    {
+    public:
+        std::mutex mtx;
+        std::deque<item_t> local[NUM_PRIORITIES];
+    };
+
+    const int numCore;
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::mutex injectmtx;
+    std::deque<item_t> inject[NUM_PRIORITIES];
+    std::atomic<long> queued;
+    std::atomic<long> queuedPrio[NUM_PRIORITIES];
+
+    std::mutex mtx;
+    std::condition_variable cond;
+    std::list<std::thread> threads;
+    std::vector<std::thread::id> exited;
+    std::list<std::weak_ptr<Group>> groups;
+    int numStarted;
+    int numSpare;
+    int numIdle;
+    int numBlocked;
+    int numPeak;
+    unsigned long numSpawned;
+    unsigned long numReaped;
+
+    static Worker *& self()
+    {
+        static thread_local Worker *worker = nullptr;
+        return worker;
+    }
+
+    // < 0: not an executor thread, > 0: blocked
+    static int& blockDepth()
+    {
+        static thread_local int depth = -1;
+        return depth;
+    }
+
+    Executor() :
+            numCore(
+                    std::max(Const::EXECUTOR_MIN_THREADS,
+                            static_cast<int>(std::thread::hardware_concurrency())
+                                    * Const::EXECUTOR_THREADS_PER_CORE)), queued(
+                    0), numStarted(0), numSpare(0), numIdle(0), numBlocked(0), numPeak(
+                    0), numSpawned(0), numReaped(0)
+    {
+        for (int i = 0; i < numCore; i++)
+            workers.push_back(std::unique_ptr<Worker>(new Worker()));
+        for (std::atomic<long>& num : queuedPrio)
+            num = 0;
+    }
+
+    // needs to be called with mtx held
+    void startThread()
+    {
+        Worker *worker = nullptr;
+
+        joinExited();
+
+        if (numStarted < numCore)
+            worker = workers[numStarted++].get();
+        else
+            numSpare++;
+
+        numSpawned++;
+        numPeak = std::max(numPeak, numStarted + numSpare);
+
+        threads.push_back(std::thread(&Executor::run, this, worker));
+    }
+
+    // needs to be called with mtx held, exited threads do not need it
+    void joinExited()
+    {
+        for (std::thread::id id : exited) {
+            for (auto it = threads.begin(); it != threads.end(); ++it) {
+                if (it->get_id() == id) {
+                    it->join();
+                    threads.erase(it);
+                    break;
+                }
+            }
+        }
+        exited.clear();
+    }
+
+    // needs to be called with mtx held
+    void wakeup()
+    {
+        if (numIdle > 0)
+            cond.notify_one();
+        else if (numStarted + numSpare - numBlocked < numCore)
+            startThread();
+    }
+
+    void push(item_t item)
+    {
+        Worker *worker = self();
+        priority prio = item.group->prio;
+
+        if (worker != nullptr) {
+            std::lock_guard<std::mutex> lock(worker->mtx);
+            worker->local[prio].push_back(std::move(item));
+        } else {
+            std::lock_guard<std::mutex> lock(injectmtx);
+            inject[prio].push_back(std::move(item));
+        }
+
+        queuedPrio[prio]++;
+        queued++;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        wakeup();
+    }
+
+    // priorities without queued tasks are skipped to avoid locking all queues
+    bool next(Worker *worker, item_t *item)
+    {
+        for (int prio = 0; prio < NUM_PRIORITIES; prio++) {
+            if (queuedPrio[prio] == 0)
+                continue;
+            if (worker != nullptr) {
+                std::lock_guard<std::mutex> lock(worker->mtx);
+                if (worker->local[prio].empty() == false) {
+                    *item = std::move(worker->local[prio].back());
+                    worker->local[prio].pop_back();
+                    queuedPrio[prio]--;
+                    queued--;
+                    return true;
+                }
+            }
+            {
+                std::lock_guard<std::mutex> lock(injectmtx);
+                if (inject[prio].empty() == false) {
+                    *item = std::move(inject[prio].front());
+                    inject[prio].pop_front();
+                    queuedPrio[prio]--;
+                    queued--;
+                    return true;
+                }
+            }
+            for (const std::unique_ptr<Worker>& victim : workers) {
+                if (victim.get() == worker)
+                    continue;
+                std::lock_guard<std::mutex> lock(victim->mtx);
+                if (victim->local[prio].empty() == false) {
+                    *item = std::move(victim->local[prio].front());
+                    victim->local[prio].pop_front();
+                    queuedPrio[prio]--;
+                    queued--;
+                    return true;
+                }
+            }
+        }
+
+        return false;
+    }
+
+    void execute(item_t *item)
+    {
+        std::shared_ptr<Group> group = item->group;
+        std::chrono::steady_clock::time_point submitted = item->submitted;
+        std::chrono::steady_clock::time_point start =
+                std::chrono::steady_clock::now();
+        std::chrono::steady_clock::time_point end;
+
+        if (group->blocking)
+            block();
+
+        setThreadName(group->name);
+
+        try {
+            item->task();
+        } catch (const std::exception& e) {
+            TRACE(Trace::error, group->name, e.what());
+        }
+        *item = item_t();
+        end = std::chrono::steady_clock::now();
+
+        if (group->blocking)
+            unblock();
+
+        std::unique_lock<std::mutex> lock(group->mtx);
+        Metrics::record(&group->queueWait, start - submitted);
+        Metrics::record(&group->runTime, end - start);
+        if (group->pending.empty()) {
+            group->running--;
+            return;
+        }
+        Group::pending_t next = std::move(group->pending.front());
+        group->pending.pop_front();
+        lock.unlock();
+
+        push( { group, std::move(next.task), next.submitted });
+    }
+
+    void block()
+    {
+        if (blockDepth() < 0 || blockDepth()++ > 0)
+            return;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        numBlocked++;
+        if (queued > 0)
+            wakeup();
+    }
+
+    void unblock()
+    {
+        if (blockDepth() <= 0 || --blockDepth() > 0)
+            return;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        numBlocked--;
+    }
+
+    void run(Worker *worker)
+    {
+        item_t item;
+        std::cv_status status;
+
+        self() = worker;
+        blockDepth() = 0;
+
+        while (true) {
+            if (next(worker, &item)) {
+                execute(&item);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(mtx);
+            status = std::cv_status::no_timeout;
+            while (queued == 0 && status == std::cv_status::no_timeout) {
+                numIdle++;
+                if (worker != nullptr)
+                    cond.wait(lock);
+                else
+                    status = cond.wait_for(lock, Const::IDLE_THREAD_LIVE_TIME);
+                numIdle--;
+            }
+            if (queued == 0) {
+                // joined by the next thread that is started
+                numSpare--;
+                numReaped++;
+                exited.push_back(std::this_thread::get_id());
+                return;
+            }
+        }
+    }
+
+public:
+    // the name only is changed if it differs since this is a system call
+    static void setThreadName(const std::string& name)
+    {
+        static thread_local std::string current;
+
+        if (current != name) {
+            current = name;
+            pthread_setname_np(pthread_self(), name.c_str());
+        }
+    }
+
+    static Executor& instance()
+    {
+        // never destroyed: ThreadPool objects with static storage
+        // duration may use it until the end
+        static Executor *executor = new Executor();
+        return *executor;
+    }
+
+    std::shared_ptr<Group> createGroup(std::string name, priority prio,
+            int limit, bool blocking)
+    {
+        std::shared_ptr<Group> group = std::make_shared<Group>(name, prio,
+                limit, blocking);
+
+        std::lock_guard<std::mutex> lock(mtx);
+        groups.remove_if([] (const std::weak_ptr<Group>& g) {
+            return g.expired();
+        });
+        groups.push_back(group);
+
+        return group;
+    }
+
+    void submit(std::shared_ptr<Group> group, task_t task)
+    {
+        std::chrono::steady_clock::time_point submitted =
+                std::chrono::steady_clock::now();
+
+        {
+            std::lock_guard<std::mutex> lock(group->mtx);
+            if (group->running >= group->limit) {
+                group->pending.push_back( { submitted, std::move(task) });
+                return;
+            }
+            group->running++;
+            group->peak = std::max(group->peak, group->running);
+        }
+
+        push( { group, std::move(task), submitted });
+    }
+
+    // the executor lock and the group locks are not held at the same time
+    void getMetrics(std::list<Metrics::metric_t> *metricList)
+    {
+        std::vector<std::shared_ptr<Group>> current;
+        std::list<Metrics::metric_t> hists;
+
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            Metrics::metric_t metric;
+            metric.isCounter = true;
+            metric.name = "threads live";
+            metric.hist.count = numStarted + numSpare;
+            metricList->push_back(metric);
+            metric.name = "threads peak";
+            metric.hist.count = numPeak;
+            metricList->push_back(metric);
+            metric.name = "threads spawned";
+            metric.hist.count = numSpawned;
+            metricList->push_back(metric);
+            metric.name = "threads reaped";
+            metric.hist.count = numReaped;
+            metricList->push_back(metric);
+            metric.name = "threads blocked";
+            metric.hist.count = numBlocked;
+            metricList->push_back(metric);
+            for (const std::weak_ptr<Group>& g : groups)
+                if (std::shared_ptr<Group> group = g.lock())
+                    current.push_back(group);
+        }
+
+        std::sort(current.begin(), current.end(),
+                [] (const std::shared_ptr<Group>& a, const std::shared_ptr<Group>& b) {
+                    return a->name < b->name;
+                });
+
+        for (std::shared_ptr<Group> group : current) {
+            std::lock_guard<std::mutex> lock(group->mtx);
+            Metrics::metric_t metric;
+            metric.isCounter = true;
+            metric.name = group->name + " running";
+            metric.hist.count = group->running;
+            metricList->push_back(metric);
+            metric.name = group->name + " running peak";
+            metric.hist.count = group->peak;
+            metricList->push_back(metric);
+            if (group->runTime.count > 0) {
+                hists.push_back( { group->name + " queue wait", false,
+                        group->queueWait });
+                hists.push_back( { group->name + " run time", false,
+                        group->runTime });
+            }
+            if (group->enqueueWait.count > 0)
+                hists.push_back( { group->name + " enqueue wait", false,
+                        group->enqueueWait });
+        }
+
+        metricList->splice(metricList->end(), hists);
+    }
+};
@@ -16,36 +16,21 @@
  *******************************************************************************/
 #include "ServerIncludes.h"
 
-std::string FileOperation::genInumString(std::list<unsigned long> inumList)
-
-{
-    std::stringstream inumss;
-
-    bool first = true;
-    for (unsigned long inum : inumList) {
-        if (first) {
-            inumss << inum;
-            first = false;
-        } else {
-            inumss << ", " << inum;
-        }
-    }
-    return inumss.str();
-}
-
+/*
+ * Does not wait for the request to progress: a status request is
+ * processed again if the request has been updated (see
+ * FileOperation::updated).
+ */
 bool FileOperation::queryResult(long reqNumber, long *resident,
         long *transferred, long *premigrated, long *migrated, long *failed)
 
 {
     SQLStatement stmt;
     int state;
-    bool done;
-    long starttime = time(NULL);
-
-    do {
-        done = true;
+    bool done = true;
 
-        std::unique_lock<std::mutex> lock(Scheduler::updmtx);
+    {
+        std::lock_guard<std::mutex> lock(Scheduler::updmtx);
 
         stmt(FileOperation::REQUEST_STATE) << reqNumber;
         stmt.prepare();
@@ -60,27 +45,24 @@ bool FileOperation::queryResult(long reqNumber, long *resident,
         if (Server::finishTerminate == true)
             done = true;
 
-        if (done == false) {
-            TRACE(Trace::full, reqNumber, (bool) Scheduler::updReq[reqNumber]);
-            Scheduler::updcond.wait(lock,
-                    [reqNumber] {return ((Server::finishTerminate == true) || (Scheduler::updReq[reqNumber] == true));});
-            Scheduler::updReq[reqNumber] = false;
-        }
-    } while (!done && time(NULL) - starttime < 10);
+        Scheduler::updReq[reqNumber] = false;
+    }
 
     mrStatus.get(reqNumber, resident, transferred, premigrated, migrated,
             failed);
 
     if (done) {
         mrStatus.remove(reqNumber);
+        jobStats.remove(reqNumber);
+        Scheduler::recallRemoved(reqNumber);
+        metrics.cancelTimers("scheduler", Scheduler::timerKey(reqNumber));
 
         {
             std::lock_guard<std::mutex> updlock(Scheduler::updmtx);
-            Scheduler::updReq.erase(Scheduler::updReq.find(reqNumber));
+            Scheduler::updReq.erase(reqNumber);
         }
 
-        stmt(FileOperation::DELETE_JOBS) << reqNumber;
-        stmt.doall();
+        jobStore->remove(reqNumber);
 
         stmt(FileOperation::DELETE_REQUESTS) << reqNumber;
         stmt.doall();
@@ -88,3 +70,14 @@ bool FileOperation::queryResult(long reqNumber, long *resident,
 
     return done;
 }
+
+bool FileOperation::updated(long reqNumber)
+
+{
+    std::lock_guard<std::mutex> lock(Scheduler::updmtx);
+    std::map<int, std::atomic<bool>>::iterator it = Scheduler::updReq.find(
+            reqNumber);
+
+    return Server::finishTerminate == true
+            || (it != Scheduler::updReq.end() && it->second == true);
+}
@@ -18,19 +18,21 @@
 
 class FileOperation
 {
-protected:
-    unsigned long requestSize;
-    static std::string genInumString(std::list<unsigned long> inumList);
 public:
     static const std::string REQUEST_STATE;
-    static const std::string DELETE_JOBS;
     static const std::string DELETE_REQUESTS;
-    FileOperation() :
-            requestSize(0)
+    FileOperation()
     {
     }
     virtual ~FileOperation() = default;
-    virtual void addJob(std::string fileName)
+    virtual void prepareJob(std::string fileName,
+            std::vector<JobStore::job_t> *jobs)
+    {
+    }
+    virtual void addJob(const JobStore::job_t& job)
+    {
+    }
+    virtual void addRequest()
     {
     }
     virtual void start()
@@ -38,8 +40,5 @@ public:
     }
     bool queryResult(long reqNumber, long *resident, long *transferred,
             long *premigrated, long *migrated, long *failed);
-    unsigned long getRequestSize()
-    {
-        return requestSize;
-    }
+    static bool updated(long reqNumber);
 };
@@ -0,0 +1,124 @@
+/*******************************************************************************
+ * Copyright 2018 IBM Corp. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *******************************************************************************/
+#include "ServerIncludes.h"
+
+/** @page job_state_queue Job state write-behind queue
+
+    # Job state write-behind queue
+
+    Failures of single files are recorded within the @ref job_store by the
+    worker threads that process these files: the premigration threads of
+    each drive (Migration::transferData), the stubbing threads
+    (Migration::changeFileState), and the selective recall
+    (SelRecall::processFiles). Instead of performing an UPDATE on their own
+    these threads add the state transition to the JobStateQueue
+    (JobStateQueue::add). An update is a function that calls the job store
+    (usually JobStore::fail).
+
+    The queued updates are written by the JobStateQueue::run thread. It wakes
+    up every Const::JOB_STATE_FLUSH_INTERVAL or if Const::JOB_UPDATE_BATCH
+    updates are pending and commits them within a single JobStore::Batch per
+    Const::JOB_UPDATE_BATCH updates. This way the worker threads do not need
+    to wait for the database.
+
+    The job store needs to be up to date whenever the state of the jobs
+    is evaluated. JobStateQueue::flush therefore acts as a barrier: on return
+    all updates that have been added before are committed. It is called
+
+    - by Migration::processFiles after all premigration or stubbing threads
+      of a request have been completed and before the remaining jobs are
+      reset,
+    - by SelRecall::processFiles before the next chunk of jobs is selected
+      and before the remaining jobs are reset,
+    - when the backend is stopped.
+
+    With that the content of the job store at the end of each
+    processing step is the same as if each failure had been written
+    immediately: a failed job never is reset to its previous state and is
+    not processed again.
+ */
+
+JobStateQueue jobStateQueue;
+
+/**
+ * Adds a state transition of a job. The update function is executed
+ * later by the JobStateQueue::run thread.
+ */
+void JobStateQueue::add(update_t update)
+
+{
+    std::lock_guard<std::mutex> lock(mtx);
+
+    pending.push_back(std::move(update));
+
+    if (pending.size() >= (unsigned long) Const::JOB_UPDATE_BATCH)
+        cond.notify_one();
+}
+
+/**
+ * Commits all pending updates. If another thread currently is committing
+ * updates this method waits for its completion. On return all updates
+ * that have been added before the call are written to the job store.
+ */
+void JobStateQueue::flush()
+
+{
+    std::lock_guard<std::mutex> flushlock(flushmtx);
+    std::vector<update_t> updates;
+    std::vector<update_t>::iterator it;
+
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        updates.swap(pending);
+    }
+
+    it = updates.begin();
+
+    while (it != updates.end()) {
+        JobStore::Batch batch;
+
+        for (int i = 0; i < Const::JOB_UPDATE_BATCH && it != updates.end();
+                i++, ++it) {
+            try {
+                (*it)();
+            } catch (const std::exception& e) {
+                TRACE(Trace::error, e.what());
+            }
+        }
+    }
+}
+
+/**
+ * Thread that commits the pending updates every
+ * Const::JOB_STATE_FLUSH_INTERVAL or if Const::JOB_UPDATE_BATCH updates are
+ * pending. It ends if the backend is terminated. Updates that are added
+ * afterwards are written by the next JobStateQueue::flush call.
+ */
+void JobStateQueue::run()
+
+{
+    while (Server::terminate == false) {
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            cond.wait_for(lock, Const::JOB_STATE_FLUSH_INTERVAL,
+                    [this] {return pending.size() >= (unsigned long) Const::JOB_UPDATE_BATCH;});
+        }
+        flush();
+    }
+
+    flush();
+}
@@ -0,0 +1,164 @@
+/*******************************************************************************
+ * Copyright 2018 IBM Corp. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *******************************************************************************/
+#include "ServerIncludes.h"
+
+/** @page job_stats Job statistics
+
+    # Job statistics
+
+    For each request and replica the JobStats class keeps the number of jobs
+    and the number of bytes per file state. These statistics are updated
+    whenever a job is added (Migration::addJob), transferred to tape
+    (Migration::transferData), changes its file system state
+    (Migration::changeFileState), or fails. The intermediate states
+    FsObj::TRANSFERRING and FsObj::CHANGINGFSTATE are not tracked: a job
+    keeps its previous state until the operation has been completed.
+
+    In addition the sizes of all jobs that still are in FsObj::RESIDENT state
+    are kept within a min-heap. Removing a size that is not at the top of the
+    heap is done lazily: the size is recorded and dropped from the heap when
+    it reaches the top. This way JobStats::minPending provides the size of the
+    smallest file that still needs to be migrated without the need to scan
+    the JOB_QUEUE table on every scheduler invocation (see Scheduler::run).
+    The number of pending bytes per replica (JobStats::sizePending) is used
+    to check if a tape storage pool provides enough capacity for a request
+    (see MessageParser::getObjects).
+
+    The statistics of a request are removed if the request has been
+    completed (FileOperation::queryResult).
+ */
+
+JobStats jobStats;
+
+void JobStats::removePending(JobStats::singleStats *stats, unsigned long size)
+
+{
+    if (stats->pending.size() == 0)
+        return;
+
+    if (size != stats->pending.top()) {
+        stats->removed[size]++;
+        return;
+    }
+
+    stats->pending.pop();
+
+    while (stats->pending.size() != 0) {
+        auto it = stats->removed.find(stats->pending.top());
+        if (it == stats->removed.end())
+            break;
+        stats->pending.pop();
+        if (--it->second == 0)
+            stats->removed.erase(it);
+    }
+}
+
+void JobStats::add(int reqNumber, int replNum, FsObj::file_state state,
+        unsigned long size)
+
+{
+    std::lock_guard<std::mutex> lock(JobStats::mtx);
+
+    singleStats& stats = allStats[std::make_pair(reqNumber, replNum)];
+
+    stats.num[state]++;
+    stats.size[state] += size;
+
+    if (state == FsObj::RESIDENT)
+        stats.pending.push(size);
+}
+
+void JobStats::update(int reqNumber, int replNum, FsObj::file_state from,
+        FsObj::file_state to, unsigned long size)
+
+{
+    std::lock_guard<std::mutex> lock(JobStats::mtx);
+
+    auto it = allStats.find(std::make_pair(reqNumber, replNum));
+
+    if (it == allStats.end()) {
+        TRACE(Trace::error, reqNumber, replNum);
+        return;
+    }
+
+    singleStats& stats = it->second;
+
+    stats.num[from]--;
+    stats.size[from] -= size;
+    stats.num[to]++;
+    stats.size[to] += size;
+
+    if (from == FsObj::RESIDENT)
+        removePending(&stats, size);
+    if (to == FsObj::RESIDENT)
+        stats.pending.push(size);
+}
+
+void JobStats::remove(int reqNumber)
+
+{
+    std::lock_guard<std::mutex> lock(JobStats::mtx);
+
+    auto it = allStats.lower_bound(std::make_pair(reqNumber, Const::UNSET));
+
+    while (it != allStats.end() && it->first.first == reqNumber)
+        it = allStats.erase(it);
+}
+
+unsigned long JobStats::minPending(int reqNumber, int replNum)
+
+{
+    std::lock_guard<std::mutex> lock(JobStats::mtx);
+
+    auto it = allStats.find(std::make_pair(reqNumber, replNum));
+
+    if (it == allStats.end() || it->second.pending.size() == 0)
+        return 0;
+
+    return it->second.pending.top();
+}
+
+unsigned long JobStats::sizePending(int reqNumber, int replNum)
+
+{
+    std::lock_guard<std::mutex> lock(JobStats::mtx);
+
+    auto it = allStats.find(std::make_pair(reqNumber, replNum));
+
+    if (it == allStats.end())
+        return 0;
+
+    return it->second.size[FsObj::RESIDENT];
+}
+
+void JobStats::get(int reqNumber, int replNum, FsObj::file_state state,
+        long *num, unsigned long *size)
+
+{
+    std::lock_guard<std::mutex> lock(JobStats::mtx);
+
+    auto it = allStats.find(std::make_pair(reqNumber, replNum));
+
+    if (it == allStats.end()) {
+        *num = 0;
+        *size = 0;
+        return;
+    }
+
+    *num = it->second.num[state];
+    *size = it->second.size[state];
+}
@@ -0,0 +1,49 @@
+/*******************************************************************************
+ * Copyright 2018 IBM Corp. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *******************************************************************************/
+#pragma once
+
+class JobStats
+{
+private:
+    struct singleStats
+    {
+        std::priority_queue<unsigned long, std::vector<unsigned long>,
+                std::greater<unsigned long>> pending;
+        std::unordered_map<unsigned long, long> removed;
+        long num[FsObj::RECALLING_PREMIG + 1] = { };
+        unsigned long size[FsObj::RECALLING_PREMIG + 1] = { };
+    };
+    std::map<std::pair<int, int>, singleStats> allStats;
+    std::mutex mtx;
+
+    void removePending(singleStats *stats, unsigned long size);
+public:
+    JobStats()
+    {
+    }
+    void add(int reqNumber, int replNum, FsObj::file_state state,
+            unsigned long size);
+    void update(int reqNumber, int replNum, FsObj::file_state from,
+            FsObj::file_state to, unsigned long size);
+    void remove(int reqNumber);
+    unsigned long minPending(int reqNumber, int replNum);
+    unsigned long sizePending(int reqNumber, int replNum);
+    void get(int reqNumber, int replNum, FsObj::file_state state, long *num,
+            unsigned long *size);
+};
+
+extern JobStats jobStats;
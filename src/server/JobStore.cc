@@ -0,0 +1,128 @@
+/*******************************************************************************
+ * Copyright 2018 IBM Corp. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *******************************************************************************/
+#include "ServerIncludes.h"
+
+/** @page job_store Job store
+
+    # Job store
+
+    The jobs of all requests are kept within a job store. Migration,
+    SelRecall, TransRecall, MessageParser and Status do not access the
+    jobs directly but use the JobStore interface. There are two
+    implementations that are selected by the -j option of ltfsdmd
+    (see @ref server_code):
+
+    type | class | description
+    ---|---|---
+    sqlite | SQLiteJobStore | the JOB_QUEUE table of the SQLite database (see @ref sqlite), default
+    memory | MemoryJobStore | an in-memory columnar store, see @ref memory_job_store
+
+    A job is described by JobStore::job_t which corresponds to a row of
+    the JOB_QUEUE table. Jobs of selective recall requests do not have a
+    replica number (JobStore::NO_REPL). If JobStore::NO_REPL is specified
+    as replica number argument of a method the jobs of all replicas are
+    affected.
+
+    Both implementations store the directory of a file name only once
+    and the jobs only contain the remaining part of the name (see
+    JobStore::splitName). This reduces the memory that is required for
+    deep directory trees and for migrations to several tape storage
+    pools where a job is created for each replica.
+
+    The following operations are provided:
+
+    method | description
+    ---|---
+    JobStore::add | add a job, a job of the same file (name or uid) and replica must not exist
+    JobStore::fail | mark the job of a file as FsObj::FAILED
+    JobStore::pending | the ids and sizes of all jobs of a replica in a specific state
+    JobStore::assign | assign jobs by id to a cartridge (see Migration::assignJobs)
+    JobStore::changeState | change the state of all jobs or of a list of files of a request on a cartridge
+    JobStore::select | the jobs of a request on a cartridge ordered by the starting block
+    JobStore::list | all jobs or the jobs of a request
+    JobStore::countStates | the number of jobs per state of a request
+    JobStore::count | the number of jobs of a request on a cartridge
+    JobStore::tapes | the cartridges of a request
+    JobStore::remove | delete the jobs of a request
+
+    If a job is added twice the exception thrown by JobStore::add carries
+    SQLITE_CONSTRAINT_UNIQUE as error number independently of the
+    implementation.
+
+    Modifications can be grouped within a JobStore::Batch. For the SQLite
+    job store a batch is a database transaction, for the MemoryJobStore it
+    has no effect. Batches must not be nested.
+ */
+
+JobStore *jobStore = nullptr;
+
+JobStore::Batch::Batch()
+
+{
+    jobStore->begin();
+}
+
+JobStore::Batch::~Batch()
+
+{
+    try {
+        jobStore->commit();
+    } catch (const std::exception& e) {
+        TRACE(Trace::error, e.what());
+    }
+}
+
+/*
+ * The directory includes the trailing slash to reconstruct the file name
+ * by concatenation, a name without a slash has an empty directory.
+ */
+void JobStore::splitName(const std::string& fileName, std::string *dir,
+        std::string *leaf)
+
+{
+    unsigned long pos = fileName.rfind('/');
+
+    if (pos == std::string::npos) {
+        *dir = "";
+        *leaf = fileName;
+    } else {
+        *dir = fileName.substr(0, pos + 1);
+        *leaf = fileName.substr(pos + 1);
+    }
+}
+
+JobStore::store_type JobStore::parseType(std::string type)
+
+{
+    if (type.compare("sqlite") == 0)
+        return JobStore::SQLITE;
+    else if (type.compare("memory") == 0)
+        return JobStore::MEMORY;
+
+    THROW(Error::GENERAL_ERROR, type);
+}
+
+JobStore *JobStore::create(JobStore::store_type type)
+
+{
+    switch (type) {
+        case JobStore::MEMORY:
+            return new MemoryJobStore();
+        default:
+            return new SQLiteJobStore();
+    }
+}
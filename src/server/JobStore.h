@@ -0,0 +1,89 @@
+/*******************************************************************************
+ * Copyright 2018 IBM Corp. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *******************************************************************************/
+#pragma once
+
+class JobStore
+{
+protected:
+    static void splitName(const std::string& fileName, std::string *dir,
+            std::string *leaf);
+public:
+    enum store_type
+    {
+        SQLITE, /**@< 0 */
+        MEMORY  /**@< 1 */
+    };
+    struct job_t
+    {
+        DataBase::operation operation;
+        std::string fileName;
+        long reqNumber;
+        int targetState;
+        int replNum;
+        std::string pool;
+        unsigned long fileSize;
+        fuid_t fuid;
+        long mtimeSec;
+        long mtimeNsec;
+        long lastUpd;
+        std::string tapeId;
+        FsObj::file_state state;
+        unsigned long startBlock;
+        long connInfo;
+    };
+    typedef std::function<bool(const job_t&)> visitor_t;
+    static const int NO_REPL = -2;
+    class Batch
+    {
+    public:
+        Batch();
+        ~Batch();
+    };
+
+    virtual ~JobStore()
+    {
+    }
+    static store_type parseType(std::string type);
+    static JobStore *create(store_type type);
+    virtual void open() = 0;
+    virtual void begin() = 0;
+    virtual void commit() = 0;
+    virtual void add(const job_t& job) = 0;
+    virtual void fail(long reqNumber, std::string fileName, int replNum) = 0;
+    virtual void pending(long reqNumber, FsObj::file_state state, int replNum,
+            std::vector<std::pair<unsigned long, long>> *jobs) = 0;
+    virtual void assign(long reqNumber, const std::vector<long>& ids,
+            FsObj::file_state state, std::string tapeId) = 0;
+    virtual void changeState(long reqNumber, std::string tapeId, int replNum,
+            FsObj::file_state from, FsObj::file_state to) = 0;
+    virtual void changeState(long reqNumber, std::string tapeId, int replNum,
+            const std::vector<FsObj::file_state>& from, FsObj::file_state to,
+            const std::vector<fuid_t>& uids) = 0;
+    virtual void select(long reqNumber, std::string tapeId,
+            const std::vector<FsObj::file_state>& states, unsigned long limit,
+            visitor_t visit) = 0;
+    virtual void list(long reqNumber, visitor_t visit) = 0;
+    virtual void countStates(long reqNumber,
+            std::map<FsObj::file_state, long> *num) = 0;
+    virtual long count(long reqNumber, std::string tapeId) = 0;
+    virtual void tapes(long reqNumber, std::vector<std::string> *tapeIds) = 0;
+    virtual void remove(long reqNumber) = 0;
+    virtual void remove(long reqNumber, std::string tapeId,
+            const std::vector<FsObj::file_state>& states) = 0;
+};
+
+extern JobStore *jobStore;
@@ -16,17 +16,223 @@
  *******************************************************************************/
 #include "ServerIncludes.h"
 
+/** @page drive_placement Drive placement
+
+    # Drive placement
+
+    On systems with several NUMA nodes the data transfer to and from a
+    drive is faster if the threads and the buffer that are used are
+    local to the node the host bus adapter of the drive is attached to.
+    When the inventory is updated LTFSDMDrive::place determines that
+    node for each drive:
+
+    - If the configuration contains a line "numa: <drive id> <node>"
+      that node is used.
+    - Otherwise the character device of the drive is looked up within
+      /sys/dev/char and the device hierarchy is followed upwards until
+      a numa_node attribute is found (usually the one of the PCI device
+      of the host bus adapter). A value of -1 means that the node is not
+      known.
+
+    If a node has been determined the data transfer threads are bound to
+    the processors of that node (/sys/devices/system/node/node<N>/cpulist)
+    for the time of the transfer of a file by creating an
+    LTFSDMDrive::Affinity object. The executor threads are shared by all
+    thread pools, the previous affinity is restored afterwards.
+
+    All data transfers of a drive are serialized by its LTFSDMDrive::mtx
+    mutex. Therefore a single buffer of Const::READ_BUFFER_SIZE bytes is
+    used per drive (LTFSDMDrive::getBuffer) instead of a buffer on the
+    stack of each thread. It is allocated the first time it is used and
+    is initialized by a bound thread such that its pages are allocated on
+    the local node.
+
+    The number of bytes written and read and the time spent per drive are
+    recorded within the "transfers" category of the @ref metrics and can
+    be listed by @ref ltfsdm_info_transfers "ltfsdm info transfers".
+    Dividing the bytes by the time shows the throughput of a drive.
+ */
+
 LTFSDMDrive::LTFSDMDrive(boost::shared_ptr<Drive> d) :
         drive(d), busy(false), umountReqNum(Const::UNSET), umountReqPool(""), toUnBlock(
-                DataBase::NOOP), mtx(nullptr), wqp(nullptr)
+                DataBase::NOOP), node(Const::UNSET), buffer(nullptr), mtx(
+                nullptr), wqp(nullptr)
 {
+    CPU_ZERO(&cpus);
 }
 
 LTFSDMDrive::~LTFSDMDrive()
 {
+    if (buffer != nullptr)
+        munmap(buffer, Const::READ_BUFFER_SIZE);
     delete (mtx);
 }
 
+LTFSDMDrive::Affinity::Affinity(std::shared_ptr<LTFSDMDrive> drive) :
+        pinned(false)
+
+{
+    if (drive->node == Const::UNSET)
+        return;
+
+    if (pthread_getaffinity_np(pthread_self(), sizeof(saved), &saved) != 0)
+        return;
+
+    if (pthread_setaffinity_np(pthread_self(), sizeof(drive->cpus),
+            &drive->cpus) != 0) {
+        TRACE(Trace::error, drive->node, errno);
+        return;
+    }
+
+    pinned = true;
+}
+
+LTFSDMDrive::Affinity::~Affinity()
+
+{
+    if (pinned)
+        pthread_setaffinity_np(pthread_self(), sizeof(saved), &saved);
+}
+
+/*
+ * Follows the sysfs device of a character device upwards until a
+ * numa_node attribute is found.
+ */
+int LTFSDMDrive::sysfsNode(std::string devName)
+
+{
+    struct stat statbuf;
+    std::stringstream devpath;
+    std::string dir;
+    char *path;
+    int value;
+
+    if (stat(devName.c_str(), &statbuf) == -1 || !S_ISCHR(statbuf.st_mode))
+        return Const::UNSET;
+
+    devpath << "/sys/dev/char/" << major(statbuf.st_rdev) << ":"
+            << minor(statbuf.st_rdev) << "/device";
+
+    if ((path = realpath(devpath.str().c_str(), NULL)) == NULL)
+        return Const::UNSET;
+    dir = path;
+    free(path);
+
+    while (dir.compare(0, 13, "/sys/devices/") == 0) {
+        std::ifstream nodefile(dir + "/numa_node");
+        if (nodefile >> value)
+            return value < 0 ? Const::UNSET : value;
+        dir = dir.substr(0, dir.rfind('/'));
+    }
+
+    return Const::UNSET;
+}
+
+/*
+ * The cpulist attribute contains comma separated ranges, e.g. "0-11,24-35".
+ */
+bool LTFSDMDrive::nodeCpus(int node, cpu_set_t *cpus)
+
+{
+    std::ifstream cpulist(
+            "/sys/devices/system/node/node" + std::to_string(node)
+                    + "/cpulist");
+    std::string range;
+    unsigned long pos;
+    int first;
+    int last;
+
+    CPU_ZERO(cpus);
+
+    while (std::getline(cpulist, range, ',')) {
+        try {
+            first = std::stoi(range);
+            if ((pos = range.find('-')) != std::string::npos)
+                last = std::stoi(range.substr(pos + 1));
+            else
+                last = first;
+        } catch (const std::exception& e) {
+            TRACE(Trace::error, node, range);
+            return false;
+        }
+        for (int cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++)
+            CPU_SET(cpu, cpus);
+    }
+
+    return CPU_COUNT(cpus) > 0;
+}
+
+void LTFSDMDrive::place()
+
+{
+    std::string driveId = drive->GetObjectID();
+    std::string source = "configuration";
+
+    if ((node = Server::conf.getNode(driveId)) == Const::UNSET) {
+        node = sysfsNode(drive->get_devname());
+        source = "sysfs";
+    }
+
+    if (node == Const::UNSET) {
+        MSG(LTFSDMS0124I, driveId);
+        return;
+    }
+
+    if (nodeCpus(node, &cpus) == false) {
+        MSG(LTFSDMS0125W, node, driveId);
+        node = Const::UNSET;
+        return;
+    }
+
+    MSG(LTFSDMS0123I, driveId, node, source, CPU_COUNT(&cpus));
+}
+
+int LTFSDMDrive::getNode()
+
+{
+    return node;
+}
+
+/*
+ * Needs to be called with mtx held by a thread that has been bound to the
+ * drive's node (see LTFSDMDrive::Affinity).
+ */
+char *LTFSDMDrive::getBuffer()
+
+{
+    void *addr;
+
+    if (buffer != nullptr)
+        return buffer;
+
+    addr = mmap(NULL, Const::READ_BUFFER_SIZE, PROT_READ | PROT_WRITE,
+    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (addr == MAP_FAILED) {
+        TRACE(Trace::error, errno);
+        THROW(Error::GENERAL_ERROR, errno);
+    }
+
+    // first touch: the pages are allocated on the local node
+    memset(addr, 0, Const::READ_BUFFER_SIZE);
+    buffer = static_cast<char *>(addr);
+
+    return buffer;
+}
+
+void LTFSDMDrive::transferred(bool written, unsigned long size,
+        std::chrono::steady_clock::duration duration)
+
+{
+    std::string driveId = drive->GetObjectID();
+
+    metrics.increment("transfers",
+            std::string(written ? "bytes written " : "bytes read ") + driveId,
+            size);
+    metrics.increment("transfers",
+            std::string(written ? "write us " : "read us ") + driveId,
+            std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+}
+
 void LTFSDMDrive::update()
 
 {
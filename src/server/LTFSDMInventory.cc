@@ -491,10 +491,11 @@ void LTFSDMInventory::inventorize()
         drive->wqp =
                 new ThreadPool<std::string, std::string, long, long,
                         Migration::mig_info_t,
-                        std::shared_ptr<std::list<unsigned long>>,
+                        std::shared_ptr<std::vector<fuid_t>>,
                         std::shared_ptr<bool>>(&Migration::transferData,
                         Const::MAX_PREMIG_THREADS, threadName.str());
         drive->mtx = new std::mutex();
+        drive->place();
     }
 }
 
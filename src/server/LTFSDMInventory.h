@@ -33,10 +33,24 @@ private:
     int umountReqNum;
     std::string umountReqPool;
     DataBase::operation toUnBlock;
+    int node;
+    cpu_set_t cpus;
+    char *buffer;
+    static int sysfsNode(std::string devName);
+    static bool nodeCpus(int node, cpu_set_t *cpus);
 public:
+    class Affinity
+    {
+    private:
+        cpu_set_t saved;
+        bool pinned;
+    public:
+        Affinity(std::shared_ptr<LTFSDMDrive> drive);
+        ~Affinity();
+    };
     std::mutex *mtx;
     ThreadPool<std::string, std::string, long, long, Migration::mig_info_t,
-            std::shared_ptr<std::list<unsigned long>>, std::shared_ptr<bool>> *wqp;
+            std::shared_ptr<std::vector<fuid_t>>, std::shared_ptr<bool>> *wqp;
     LTFSDMDrive(boost::shared_ptr<Drive> d);
     ~LTFSDMDrive();
     boost::shared_ptr<Drive> get_le()
@@ -54,6 +68,11 @@ public:
     void setToUnblock(DataBase::operation op);
     DataBase::operation getToUnblock();
     void clearToUnblock();
+    void place();
+    int getNode();
+    char *getBuffer();
+    void transferred(bool written, unsigned long size,
+            std::chrono::steady_clock::duration duration);
 };
 
 class LTFSDMCartridge
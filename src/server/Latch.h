@@ -0,0 +1,82 @@
+/*******************************************************************************
+ * Copyright 2018 IBM Corp. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *******************************************************************************/
+#pragma once
+
+/*
+ * A Latch counts outstanding tasks (e.g. of a single request within a
+ * ThreadPool). Latch::add is called for each task before it is started
+ * and Latch::done when it is completed. Only if the count drops to zero
+ * the threads waiting within Latch::wait are woken up and the
+ * continuations registered by Latch::then are called (by the thread
+ * that completed the last task or immediately if there is no task
+ * outstanding). The count is changed without holding the mutex, it only
+ * is used to wait and to register continuations.
+ */
+class Latch
+{
+private:
+    std::atomic<long> count;
+    std::mutex mtx;
+    std::condition_variable cond;
+    std::list<std::function<void()>> conts;
+public:
+    Latch() :
+            count(0)
+    {
+    }
+    void add()
+    {
+        count++;
+    }
+    void done()
+    {
+        std::list<std::function<void()>> ready;
+
+        if (--count != 0)
+            return;
+
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            cond.notify_all();
+            ready.swap(conts);
+        }
+
+        for (std::function<void()>& cont : ready)
+            cont();
+    }
+    long remaining()
+    {
+        return count;
+    }
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        cond.wait(lock, [this] {return count == 0;});
+    }
+    void then(std::function<void()> cont)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (count != 0) {
+                conts.push_back(cont);
+                return;
+            }
+        }
+
+        cont();
+    }
+};
@@ -0,0 +1,834 @@
+/*******************************************************************************
+ * Copyright 2018 IBM Corp. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *******************************************************************************/
+#include "ServerIncludes.h"
+
+/** @page memory_job_store Memory job store
+
+    # Memory job store
+
+    For requests of tens of millions of files the JOB_QUEUE table becomes
+    large and each change of a job state is an SQL UPDATE. The
+    MemoryJobStore is an alternative implementation of the @ref job_store
+    that is selected by "ltfsdmd -j memory".
+
+    ## Segments
+
+    The jobs of each request are kept within a separate segment. A segment
+    stores each attribute of a job in a separate column (a vector) and a
+    job is identified by its row within the segment:
+
+    - the operation is stored once per segment
+    - the cartridge ids and the tape storage pool names are stored within
+      a dictionary per segment, the columns only contain the index
+    - the file system id of the file uid is stored within a global
+      dictionary, the file uid of a job therefore only requires the
+      dictionary index, the inode generation and the inode number
+    - the directories of the file names are stored within a global
+      dictionary (see JobStore::splitName), a column contains the index
+      of the directory. The remaining parts of the file names are stored
+      contiguously within a single string, a column contains the end
+      offset of each of these
+    - the state of a job is stored in a column and within one bitmap per
+      FsObj::file_state. Selecting the jobs of a specific state only needs
+      to iterate over the set bits of the corresponding bitmap. The number
+      of jobs per state is counted when the state changes
+      (JobStore::countStates).
+
+    The jobs of a file are found by the hash of its name or of its uid
+    (two hash maps per segment). The uniqueness of file names and uids per
+    replica is checked against all segments when a job is added like the
+    unique constraints of the JOB_QUEUE table do.
+
+    Deleted jobs are marked and removed from the bitmaps and hash maps.
+    A segment is compacted if the number of deleted jobs exceeds the
+    number of remaining jobs and it is dropped if no job is left. This
+    happens only if no other thread currently iterates over the segment
+    (JobStore::select, JobStore::list). The ids provided by
+    JobStore::pending are not rows but ascending job ids per segment that
+    are kept by the compaction. JobStore::assign maps them to the current
+    rows (MemoryJobStore::rowOf) and ignores ids of deleted jobs. These methods copy the jobs in
+    chunks of MemoryJobStore::VISIT_CHUNK jobs and call the visitor
+    without holding the lock of the store.
+
+    ## Persistence
+
+    The memory job store is volatile. Like the SQLite database, which is
+    recreated when the backend starts and may be kept in memory (see
+    @ref sqlite), its jobs do not survive a restart of the backend. A
+    JobStore::Batch has no effect.
+ */
+
+const unsigned int MemoryJobStore::NO_DIR;
+
+void MemoryJobStore::Bitmap::set(unsigned long pos)
+
+{
+    if (pos / 64 >= words.size())
+        words.resize(pos / 64 + 1, 0);
+
+    words[pos / 64] |= 1UL << (pos % 64);
+}
+
+void MemoryJobStore::Bitmap::reset(unsigned long pos)
+
+{
+    if (pos / 64 < words.size())
+        words[pos / 64] &= ~(1UL << (pos % 64));
+}
+
+size_t MemoryJobStore::hashName(const std::string& name)
+
+{
+    return std::hash<std::string>()(name);
+}
+
+size_t MemoryJobStore::hashUid(const fuid_t& fuid)
+
+{
+    size_t hash = std::hash<unsigned long>()(fuid.inum);
+
+    hash ^= std::hash<unsigned long>()(fuid.igen) + 0x9e3779b97f4a7c15UL
+            + (hash << 6) + (hash >> 2);
+    hash ^= std::hash<unsigned long>()(fuid.fsid_l) + 0x9e3779b97f4a7c15UL
+            + (hash << 6) + (hash >> 2);
+    hash ^= std::hash<unsigned long>()(fuid.fsid_h) + 0x9e3779b97f4a7c15UL
+            + (hash << 6) + (hash >> 2);
+
+    return hash;
+}
+
+unsigned short MemoryJobStore::dictIndex(std::vector<std::string> *dict,
+        const std::string& value)
+
+{
+    int idx = findDict(*dict, value);
+
+    if (idx != Const::UNSET)
+        return idx;
+
+    dict->push_back(value);
+
+    return dict->size() - 1;
+}
+
+int MemoryJobStore::findDict(const std::vector<std::string>& dict,
+        const std::string& value)
+
+{
+    for (unsigned int i = 0; i < dict.size(); i++)
+        if (dict[i].compare(value) == 0)
+            return i;
+
+    return Const::UNSET;
+}
+
+unsigned short MemoryJobStore::fsidIndex(const fuid_t& fuid)
+
+{
+    for (unsigned int i = 0; i < fsids.size(); i++)
+        if (fsids[i].first == fuid.fsid_h && fsids[i].second == fuid.fsid_l)
+            return i;
+
+    fsids.push_back(std::make_pair(fuid.fsid_h, fuid.fsid_l));
+
+    return fsids.size() - 1;
+}
+
+unsigned int MemoryJobStore::dirIndex(const std::string& dir)
+
+{
+    std::unordered_map<std::string, unsigned int>::iterator it = dirIds.find(
+            dir);
+
+    if (it != dirIds.end())
+        return it->second;
+
+    dirs.push_back(dir);
+    dirIds[dir] = dirs.size() - 1;
+
+    return dirs.size() - 1;
+}
+
+std::string MemoryJobStore::fileName(const MemoryJobStore::Segment& seg,
+        unsigned int row)
+
+{
+    unsigned long start = row ? seg.leafEnd[row - 1] : 0;
+
+    if (seg.dir[row] == NO_DIR)
+        return "";
+
+    return dirs[seg.dir[row]]
+            + seg.leaves.substr(start, seg.leafEnd[row] - start);
+}
+
+bool MemoryJobStore::nameEquals(const MemoryJobStore::Segment& seg,
+        unsigned int row, const std::string& name)
+
+{
+    unsigned long start = row ? seg.leafEnd[row - 1] : 0;
+    unsigned long length = seg.leafEnd[row] - start;
+
+    if (seg.dir[row] == NO_DIR)
+        return name.compare("") == 0;
+
+    const std::string& dir = dirs[seg.dir[row]];
+
+    return name.size() == dir.size() + length
+            && name.compare(0, dir.size(), dir) == 0
+            && name.compare(dir.size(), length, seg.leaves, start, length) == 0;
+}
+
+void MemoryJobStore::appendName(MemoryJobStore::Segment *seg,
+        const std::string& name)
+
+{
+    std::string dir;
+    std::string leaf;
+
+    if (name.compare("") == 0) {
+        seg->dir.push_back(NO_DIR);
+    } else {
+        splitName(name, &dir, &leaf);
+        seg->dir.push_back(dirIndex(dir));
+        seg->leaves.append(leaf);
+    }
+    seg->leafEnd.push_back(seg->leaves.size());
+}
+
+bool MemoryJobStore::uidEquals(const MemoryJobStore::Segment& seg,
+        unsigned int row, const fuid_t& fuid)
+
+{
+    return seg.inum[row] == fuid.inum && seg.igen[row] == fuid.igen
+            && fsids[seg.fsid[row]].first == fuid.fsid_h
+            && fsids[seg.fsid[row]].second == fuid.fsid_l;
+}
+
+bool MemoryJobStore::exists(const JobStore::job_t& job)
+
+{
+    size_t uidHash = hashUid(job.fuid);
+    size_t nameHash = hashName(job.fileName);
+
+    if (job.replNum == JobStore::NO_REPL)
+        return false;
+
+    for (std::pair<const long, std::shared_ptr<Segment>>& entry : segments) {
+        Segment& seg = *entry.second;
+        auto uids = seg.byUid.equal_range(uidHash);
+        for (auto it = uids.first; it != uids.second; ++it)
+            if (seg.replNum[it->second] == job.replNum
+                    && uidEquals(seg, it->second, job.fuid))
+                return true;
+        if (job.fileName.compare("") == 0)
+            continue;
+        auto names = seg.byName.equal_range(nameHash);
+        for (auto it = names.first; it != names.second; ++it)
+            if (seg.replNum[it->second] == job.replNum
+                    && nameEquals(seg, it->second, job.fileName))
+                return true;
+    }
+
+    return false;
+}
+
+std::shared_ptr<MemoryJobStore::Segment> MemoryJobStore::find(long reqNumber)
+
+{
+    auto it = segments.find(reqNumber);
+
+    if (it == segments.end())
+        return nullptr;
+
+    return it->second;
+}
+
+void MemoryJobStore::setState(MemoryJobStore::Segment *seg, unsigned int row,
+        FsObj::file_state state)
+
+{
+    seg->states[seg->state[row]].reset(row);
+    seg->num[seg->state[row]]--;
+    seg->state[row] = state;
+    seg->states[state].set(row);
+    seg->num[state]++;
+}
+
+void MemoryJobStore::removeRow(MemoryJobStore::Segment *seg, unsigned int row)
+
+{
+    std::string name = fileName(*seg, row);
+    fuid_t fuid;
+
+    seg->states[seg->state[row]].reset(row);
+    seg->num[seg->state[row]]--;
+    seg->state[row] = DELETED;
+    seg->live--;
+
+    if (name.compare("") != 0) {
+        auto names = seg->byName.equal_range(hashName(name));
+        for (auto it = names.first; it != names.second; ++it) {
+            if (it->second == row) {
+                seg->byName.erase(it);
+                break;
+            }
+        }
+    }
+
+    fuid.fsid_h = fsids[seg->fsid[row]].first;
+    fuid.fsid_l = fsids[seg->fsid[row]].second;
+    fuid.igen = seg->igen[row];
+    fuid.inum = seg->inum[row];
+    auto uids = seg->byUid.equal_range(hashUid(fuid));
+    for (auto it = uids.first; it != uids.second; ++it) {
+        if (it->second == row) {
+            seg->byUid.erase(it);
+            break;
+        }
+    }
+}
+
+/*
+ * Returns the row of a job id or Const::UNSET if the job has been
+ * deleted. Unless the segment has been compacted the id is the row,
+ * otherwise the row is searched since the ids remain ascending.
+ */
+long MemoryJobStore::rowOf(const MemoryJobStore::Segment& seg, long id)
+
+{
+    std::vector<unsigned int>::const_iterator it;
+
+    if (id < 0)
+        return Const::UNSET;
+
+    if (static_cast<unsigned long>(id) < seg.jobId.size()
+            && seg.jobId[id] == id)
+        return id;
+
+    it = std::lower_bound(seg.jobId.begin(), seg.jobId.end(), id);
+    if (it == seg.jobId.end() || *it != id)
+        return Const::UNSET;
+
+    return it - seg.jobId.begin();
+}
+
+/*
+ * Drops a segment without jobs or compacts it if the majority of its
+ * rows have been deleted. Nothing is done while another thread iterates
+ * over the segment since this changes the row numbers.
+ */
+void MemoryJobStore::cleanup(long reqNumber, MemoryJobStore::Segment *seg)
+
+{
+    unsigned long deleted = seg->state.size() - seg->live;
+
+    if (seg->visitors > 0 || seg->removed)
+        return;
+
+    if (seg->live == 0) {
+        seg->removed = true;
+        segments.erase(reqNumber);
+    } else if (deleted >= COMPACT_MIN && deleted > seg->live) {
+        compact(reqNumber, seg);
+    }
+}
+
+void MemoryJobStore::compact(long reqNumber, MemoryJobStore::Segment *seg)
+
+{
+    Segment cseg;
+    unsigned int crow = 0;
+
+    TRACE(Trace::normal, reqNumber, seg->state.size(), seg->live);
+
+    cseg.operation = seg->operation;
+    cseg.tapeIds = seg->tapeIds;
+    cseg.pools = seg->pools;
+    cseg.nextId = seg->nextId;
+
+    for (unsigned int row = 0; row < seg->state.size(); row++) {
+        if (seg->state[row] == DELETED)
+            continue;
+
+        std::string name = fileName(*seg, row);
+        fuid_t fuid = { fsids[seg->fsid[row]].first,
+                fsids[seg->fsid[row]].second, seg->igen[row], seg->inum[row] };
+
+        cseg.targetState.push_back(seg->targetState[row]);
+        cseg.replNum.push_back(seg->replNum[row]);
+        cseg.pool.push_back(seg->pool[row]);
+        cseg.fileSize.push_back(seg->fileSize[row]);
+        cseg.fsid.push_back(seg->fsid[row]);
+        cseg.igen.push_back(seg->igen[row]);
+        cseg.inum.push_back(seg->inum[row]);
+        cseg.mtimeSec.push_back(seg->mtimeSec[row]);
+        cseg.mtimeNsec.push_back(seg->mtimeNsec[row]);
+        cseg.lastUpd.push_back(seg->lastUpd[row]);
+        cseg.tape.push_back(seg->tape[row]);
+        cseg.state.push_back(seg->state[row]);
+        cseg.startBlock.push_back(seg->startBlock[row]);
+        cseg.connInfo.push_back(seg->connInfo[row]);
+        cseg.jobId.push_back(seg->jobId[row]);
+        appendName(&cseg, name);
+        cseg.states[seg->state[row]].set(crow);
+        cseg.num[seg->state[row]]++;
+        if (name.compare("") != 0)
+            cseg.byName.insert(std::make_pair(hashName(name), crow));
+        cseg.byUid.insert(std::make_pair(hashUid(fuid), crow));
+        cseg.live++;
+        crow++;
+    }
+
+    *seg = std::move(cseg);
+}
+
+void MemoryJobStore::read(const MemoryJobStore::Segment& seg, long reqNumber,
+        unsigned int row, JobStore::job_t *job)
+
+{
+    job->operation = seg.operation;
+    job->fileName = fileName(seg, row);
+    job->reqNumber = reqNumber;
+    job->targetState = seg.targetState[row];
+    job->replNum = seg.replNum[row];
+    job->pool = seg.pools[seg.pool[row]];
+    job->fileSize = seg.fileSize[row];
+    job->fuid.fsid_h = fsids[seg.fsid[row]].first;
+    job->fuid.fsid_l = fsids[seg.fsid[row]].second;
+    job->fuid.igen = seg.igen[row];
+    job->fuid.inum = seg.inum[row];
+    job->mtimeSec = seg.mtimeSec[row];
+    job->mtimeNsec = seg.mtimeNsec[row];
+    job->lastUpd = seg.lastUpd[row];
+    job->tapeId = seg.tapeIds[seg.tape[row]];
+    job->state = static_cast<FsObj::file_state>(seg.state[row]);
+    job->startBlock = seg.startBlock[row];
+    job->connInfo = seg.connInfo[row];
+}
+
+/*
+ * Copies the jobs of the rows in chunks and calls the visitor without
+ * holding the lock. Jobs that have been deleted in the meantime are
+ * skipped. Returns false if the visitor stopped the iteration.
+ *
+ * The caller has to increment the visitors of the segment within the
+ * critical section that determines the rows. Otherwise the segment
+ * could be compacted before and the rows would be stale. The visitors
+ * are decremented here and a cleanup that has been deferred because of
+ * this iteration is done by the last visitor.
+ */
+bool MemoryJobStore::visitRows(long reqNumber,
+        std::shared_ptr<MemoryJobStore::Segment> seg,
+        const std::vector<unsigned int>& rows, JobStore::visitor_t visit)
+
+{
+    std::vector<job_t> jobs;
+    unsigned long pos = 0;
+    bool cont = true;
+
+    try {
+        while (cont && pos < rows.size()) {
+            jobs.clear();
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                if (seg->removed)
+                    break;
+                for (; pos < rows.size() && jobs.size() < VISIT_CHUNK; pos++) {
+                    if (seg->state[rows[pos]] == DELETED)
+                        continue;
+                    jobs.push_back(job_t());
+                    read(*seg, reqNumber, rows[pos], &jobs.back());
+                }
+            }
+            for (const job_t& job : jobs) {
+                if (visit(job) == false) {
+                    cont = false;
+                    break;
+                }
+            }
+        }
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (--seg->visitors == 0)
+            cleanup(reqNumber, seg.get());
+        throw;
+    }
+
+    std::lock_guard<std::mutex> lock(mtx);
+    if (--seg->visitors == 0)
+        cleanup(reqNumber, seg.get());
+
+    return cont;
+}
+
+void MemoryJobStore::open()
+
+{
+}
+
+void MemoryJobStore::begin()
+
+{
+}
+
+void MemoryJobStore::commit()
+
+{
+}
+
+void MemoryJobStore::add(const JobStore::job_t& job)
+
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    std::shared_ptr<Segment> seg;
+    unsigned int row;
+
+    if (exists(job)) {
+        TRACE(Trace::error, job.fileName, job.fuid.inum, job.replNum);
+        errno = SQLITE_CONSTRAINT_UNIQUE;
+        THROW(Error::GENERAL_ERROR, job.fileName, job.replNum);
+    }
+
+    seg = find(job.reqNumber);
+    if (seg == nullptr) {
+        seg = std::make_shared<Segment>();
+        seg->operation = job.operation;
+        segments[job.reqNumber] = seg;
+    }
+
+    row = seg->state.size();
+
+    seg->targetState.push_back(job.targetState);
+    seg->replNum.push_back(job.replNum);
+    seg->pool.push_back(dictIndex(&seg->pools, job.pool));
+    seg->fileSize.push_back(job.fileSize);
+    seg->fsid.push_back(fsidIndex(job.fuid));
+    seg->igen.push_back(job.fuid.igen);
+    seg->inum.push_back(job.fuid.inum);
+    seg->mtimeSec.push_back(job.mtimeSec);
+    seg->mtimeNsec.push_back(job.mtimeNsec);
+    seg->lastUpd.push_back(job.lastUpd);
+    seg->tape.push_back(dictIndex(&seg->tapeIds, job.tapeId));
+    seg->state.push_back(job.state);
+    seg->startBlock.push_back(job.startBlock);
+    seg->connInfo.push_back(job.connInfo);
+    seg->jobId.push_back(seg->nextId++);
+    appendName(seg.get(), job.fileName);
+    seg->states[job.state].set(row);
+    seg->num[job.state]++;
+    if (job.fileName.compare("") != 0)
+        seg->byName.insert(std::make_pair(hashName(job.fileName), row));
+    seg->byUid.insert(std::make_pair(hashUid(job.fuid), row));
+    seg->live++;
+
+}
+
+void MemoryJobStore::fail(long reqNumber, std::string fileName, int replNum)
+
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    std::shared_ptr<Segment> seg = find(reqNumber);
+
+    if (seg == nullptr)
+        return;
+
+    auto names = seg->byName.equal_range(hashName(fileName));
+    for (auto it = names.first; it != names.second; ++it)
+        if ((replNum == JobStore::NO_REPL
+                || seg->replNum[it->second] == replNum)
+                && nameEquals(*seg, it->second, fileName))
+            setState(seg.get(), it->second, FsObj::FAILED);
+
+}
+
+void MemoryJobStore::pending(long reqNumber, FsObj::file_state state,
+        int replNum, std::vector<std::pair<unsigned long, long>> *jobs)
+
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    std::shared_ptr<Segment> seg = find(reqNumber);
+
+    if (seg == nullptr)
+        return;
+
+    seg->states[state].forEach([&seg, replNum, jobs] (unsigned long row) {
+        if (seg->replNum[row] == replNum)
+        jobs->push_back(std::make_pair(seg->fileSize[row], seg->jobId[row]));
+    });
+}
+
+void MemoryJobStore::assign(long reqNumber, const std::vector<long>& ids,
+        FsObj::file_state state, std::string tapeId)
+
+{
+    std::vector<long>::const_iterator it = ids.begin();
+
+    while (it != ids.end()) {
+        std::lock_guard<std::mutex> lock(mtx);
+        std::shared_ptr<Segment> seg = find(reqNumber);
+
+        if (seg == nullptr)
+            return;
+
+        unsigned short tape = dictIndex(&seg->tapeIds, tapeId);
+
+        for (int i = 0; i < Const::JOB_UPDATE_BATCH && it != ids.end();
+                i++, ++it) {
+            long row = rowOf(*seg, *it);
+            if (row == Const::UNSET || seg->state[row] == DELETED)
+                continue;
+            setState(seg.get(), row, state);
+            seg->tape[row] = tape;
+        }
+    }
+}
+
+void MemoryJobStore::changeState(long reqNumber, std::string tapeId,
+        int replNum, FsObj::file_state from, FsObj::file_state to)
+
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    std::shared_ptr<Segment> seg = find(reqNumber);
+    std::vector<unsigned int> rows;
+    int tape;
+
+    if (seg == nullptr || from == to)
+        return;
+
+    if ((tape = findDict(seg->tapeIds, tapeId)) == Const::UNSET)
+        return;
+
+    seg->states[from].forEach([&seg, &rows, tape, replNum] (unsigned long row) {
+        if (seg->tape[row] == tape
+                && (replNum == JobStore::NO_REPL || seg->replNum[row] == replNum))
+        rows.push_back(row);
+    });
+
+    for (unsigned int row : rows)
+        setState(seg.get(), row, to);
+}
+
+void MemoryJobStore::changeState(long reqNumber, std::string tapeId,
+        int replNum, const std::vector<FsObj::file_state>& from,
+        FsObj::file_state to, const std::vector<fuid_t>& uids)
+
+{
+    std::vector<fuid_t>::const_iterator it = uids.begin();
+
+    while (it != uids.end()) {
+        std::lock_guard<std::mutex> lock(mtx);
+        std::shared_ptr<Segment> seg = find(reqNumber);
+        int tape;
+
+        if (seg == nullptr)
+            return;
+
+        if ((tape = findDict(seg->tapeIds, tapeId)) == Const::UNSET)
+            return;
+
+        for (int i = 0; i < Const::JOB_UPDATE_BATCH && it != uids.end();
+                i++, ++it) {
+            auto rows = seg->byUid.equal_range(hashUid(*it));
+            for (auto rit = rows.first; rit != rows.second; ++rit) {
+                unsigned int row = rit->second;
+                if (seg->tape[row] == tape
+                        && (replNum == JobStore::NO_REPL
+                                || seg->replNum[row] == replNum)
+                        && std::find(from.begin(), from.end(), seg->state[row])
+                                != from.end() && uidEquals(*seg, row, *it))
+                    setState(seg.get(), row, to);
+            }
+        }
+    }
+}
+
+/*
+ * The jobs are ordered by their starting block. For the selection of a
+ * limited number of jobs only the first ones need to be sorted.
+ */
+void MemoryJobStore::select(long reqNumber, std::string tapeId,
+        const std::vector<FsObj::file_state>& states, unsigned long limit,
+        JobStore::visitor_t visit)
+
+{
+    std::shared_ptr<Segment> seg;
+    std::vector<unsigned int> rows;
+
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        int tape;
+
+        if ((seg = find(reqNumber)) == nullptr)
+            return;
+
+        if ((tape = findDict(seg->tapeIds, tapeId)) == Const::UNSET)
+            return;
+
+        for (FsObj::file_state state : states)
+            seg->states[state].forEach([&seg, &rows, tape] (unsigned long row) {
+                if (seg->tape[row] == tape)
+                rows.push_back(row);
+            });
+
+        auto cmp =
+                [&seg] (unsigned int a, unsigned int b) {
+                    return seg->startBlock[a] < seg->startBlock[b]
+                    || (seg->startBlock[a] == seg->startBlock[b] && a < b);
+                };
+
+        if (limit != 0 && limit < rows.size()) {
+            std::nth_element(rows.begin(), rows.begin() + limit, rows.end(),
+                    cmp);
+            rows.resize(limit);
+        }
+        std::sort(rows.begin(), rows.end(), cmp);
+        seg->visitors++;
+    }
+
+    visitRows(reqNumber, seg, rows, visit);
+}
+
+void MemoryJobStore::list(long reqNumber, JobStore::visitor_t visit)
+
+{
+    std::vector<std::pair<long, std::shared_ptr<Segment>>> segs;
+
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+
+        if (reqNumber != Const::UNSET) {
+            std::shared_ptr<Segment> seg = find(reqNumber);
+            if (seg != nullptr)
+                segs.push_back(std::make_pair(reqNumber, seg));
+        } else {
+            for (std::pair<const long, std::shared_ptr<Segment>>& entry : segments)
+                segs.push_back(entry);
+        }
+    }
+
+    for (std::pair<long, std::shared_ptr<Segment>>& entry : segs) {
+        std::vector<unsigned int> rows;
+
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            for (unsigned int row = 0; row < entry.second->state.size(); row++)
+                if (entry.second->state[row] != DELETED)
+                    rows.push_back(row);
+            entry.second->visitors++;
+        }
+
+        if (visitRows(entry.first, entry.second, rows, visit) == false)
+            return;
+    }
+}
+
+void MemoryJobStore::countStates(long reqNumber,
+        std::map<FsObj::file_state, long> *num)
+
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    std::shared_ptr<Segment> seg = find(reqNumber);
+
+    if (seg == nullptr)
+        return;
+
+    for (int state = 0; state < NUM_STATES; state++)
+        if (seg->num[state] > 0)
+            (*num)[static_cast<FsObj::file_state>(state)] = seg->num[state];
+}
+
+long MemoryJobStore::count(long reqNumber, std::string tapeId)
+
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    std::shared_ptr<Segment> seg = find(reqNumber);
+    long count = 0;
+    int tape;
+
+    if (seg == nullptr)
+        return 0;
+
+    if ((tape = findDict(seg->tapeIds, tapeId)) == Const::UNSET)
+        return 0;
+
+    for (unsigned int row = 0; row < seg->state.size(); row++)
+        if (seg->state[row] != DELETED && seg->tape[row] == tape)
+            count++;
+
+    return count;
+}
+
+void MemoryJobStore::tapes(long reqNumber, std::vector<std::string> *tapeIds)
+
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    std::shared_ptr<Segment> seg = find(reqNumber);
+
+    if (seg == nullptr)
+        return;
+
+    std::vector<bool> used(seg->tapeIds.size(), false);
+
+    for (unsigned int row = 0; row < seg->state.size(); row++)
+        if (seg->state[row] != DELETED)
+            used[seg->tape[row]] = true;
+
+    for (unsigned int tape = 0; tape < used.size(); tape++)
+        if (used[tape])
+            tapeIds->push_back(seg->tapeIds[tape]);
+}
+
+void MemoryJobStore::remove(long reqNumber)
+
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    std::shared_ptr<Segment> seg = find(reqNumber);
+
+    if (seg == nullptr)
+        return;
+
+    seg->removed = true;
+    segments.erase(reqNumber);
+}
+
+void MemoryJobStore::remove(long reqNumber, std::string tapeId,
+        const std::vector<FsObj::file_state>& states)
+
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    std::shared_ptr<Segment> seg = find(reqNumber);
+    std::vector<unsigned int> rows;
+    int tape;
+
+    if (seg == nullptr)
+        return;
+
+    if ((tape = findDict(seg->tapeIds, tapeId)) == Const::UNSET)
+        return;
+
+    for (FsObj::file_state state : states)
+        seg->states[state].forEach([&seg, &rows, tape] (unsigned long row) {
+            if (seg->tape[row] == tape)
+            rows.push_back(row);
+        });
+
+    for (unsigned int row : rows)
+        removeRow(seg.get(), row);
+
+    cleanup(reqNumber, seg.get());
+}
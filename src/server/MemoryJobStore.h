@@ -0,0 +1,140 @@
+/*******************************************************************************
+ * Copyright 2018 IBM Corp. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *******************************************************************************/
+#pragma once
+
+class MemoryJobStore: public JobStore
+{
+private:
+    static const int NUM_STATES = FsObj::RECALLING_PREMIG + 1;
+    static const unsigned char DELETED = 0xff;
+    static const unsigned int NO_DIR = 0xffffffff;
+    static const unsigned int VISIT_CHUNK = 1024;
+    static const unsigned int COMPACT_MIN = 1024;
+
+    class Bitmap
+    {
+    private:
+        std::vector<unsigned long> words;
+    public:
+        void set(unsigned long pos);
+        void reset(unsigned long pos);
+        template<typename F>
+        void forEach(F func) const
+        {
+            for (unsigned long i = 0; i < words.size(); i++) {
+                unsigned long word = words[i];
+                while (word != 0) {
+                    func(i * 64 + __builtin_ctzl(word));
+                    word &= word - 1;
+                }
+            }
+        }
+    };
+
+    struct Segment
+    {
+        DataBase::operation operation;
+        std::vector<std::string> tapeIds;
+        std::vector<std::string> pools;
+        std::vector<signed char> targetState;
+        std::vector<signed char> replNum;
+        std::vector<unsigned short> pool;
+        std::vector<unsigned long> fileSize;
+        std::vector<unsigned short> fsid;
+        std::vector<unsigned int> igen;
+        std::vector<unsigned long> inum;
+        std::vector<long> mtimeSec;
+        std::vector<int> mtimeNsec;
+        std::vector<long> lastUpd;
+        std::vector<unsigned short> tape;
+        std::vector<unsigned char> state;
+        std::vector<unsigned long> startBlock;
+        std::vector<long> connInfo;
+        std::vector<unsigned int> dir;
+        std::vector<unsigned int> jobId;
+        std::string leaves;
+        std::vector<unsigned long> leafEnd;
+        Bitmap states[NUM_STATES];
+        long num[NUM_STATES] = { };
+        std::unordered_multimap<size_t, unsigned int> byName;
+        std::unordered_multimap<size_t, unsigned int> byUid;
+        unsigned int nextId = 0;
+        unsigned long live = 0;
+        int visitors = 0;
+        bool removed = false;
+    };
+
+    std::map<long, std::shared_ptr<Segment>> segments;
+    std::vector<std::pair<unsigned long, unsigned long>> fsids;
+    std::vector<std::string> dirs;
+    std::unordered_map<std::string, unsigned int> dirIds;
+    std::mutex mtx;
+
+    static size_t hashName(const std::string& name);
+    static size_t hashUid(const fuid_t& fuid);
+    static unsigned short dictIndex(std::vector<std::string> *dict,
+            const std::string& value);
+    static int findDict(const std::vector<std::string>& dict,
+            const std::string& value);
+    unsigned short fsidIndex(const fuid_t& fuid);
+    unsigned int dirIndex(const std::string& dir);
+    std::string fileName(const Segment& seg, unsigned int row);
+    bool nameEquals(const Segment& seg, unsigned int row,
+            const std::string& name);
+    void appendName(Segment *seg, const std::string& name);
+    bool uidEquals(const Segment& seg, unsigned int row, const fuid_t& fuid);
+    bool exists(const job_t& job);
+    std::shared_ptr<Segment> find(long reqNumber);
+    static long rowOf(const Segment& seg, long id);
+    static void setState(Segment *seg, unsigned int row,
+            FsObj::file_state state);
+    void removeRow(Segment *seg, unsigned int row);
+    void cleanup(long reqNumber, Segment *seg);
+    void compact(long reqNumber, Segment *seg);
+    void read(const Segment& seg, long reqNumber, unsigned int row,
+            job_t *job);
+    bool visitRows(long reqNumber, std::shared_ptr<Segment> seg,
+            const std::vector<unsigned int>& rows, visitor_t visit);
+public:
+    MemoryJobStore()
+    {
+    }
+    void open();
+    void begin();
+    void commit();
+    void add(const job_t& job);
+    void fail(long reqNumber, std::string fileName, int replNum);
+    void pending(long reqNumber, FsObj::file_state state, int replNum,
+            std::vector<std::pair<unsigned long, long>> *jobs);
+    void assign(long reqNumber, const std::vector<long>& ids,
+            FsObj::file_state state, std::string tapeId);
+    void changeState(long reqNumber, std::string tapeId, int replNum,
+            FsObj::file_state from, FsObj::file_state to);
+    void changeState(long reqNumber, std::string tapeId, int replNum,
+            const std::vector<FsObj::file_state>& from, FsObj::file_state to,
+            const std::vector<fuid_t>& uids);
+    void select(long reqNumber, std::string tapeId,
+            const std::vector<FsObj::file_state>& states, unsigned long limit,
+            visitor_t visit);
+    void list(long reqNumber, visitor_t visit);
+    void countStates(long reqNumber, std::map<FsObj::file_state, long> *num);
+    long count(long reqNumber, std::string tapeId);
+    void tapes(long reqNumber, std::vector<std::string> *tapeIds);
+    void remove(long reqNumber);
+    void remove(long reqNumber, std::string tapeId,
+            const std::vector<FsObj::file_state>& states);
+};
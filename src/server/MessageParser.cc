@@ -52,11 +52,19 @@
     MessageParser::infoPoolsMessage | info pools command
     MessageParser::retrieveMessage | retrieve command
 
-    For selective recall and migration the file names need to be transferred
-    from the client to the backend. This is handled within the MessageParser::getObjects
-    method. Sending the objects and querying the migration and recall status
-    is performed over same connection like the initial migration and recall
-    requests to be followed and not processed by the Receiver.
+    MessageParser::run processes a single message. For selective recall
+    and migration the file names need to be transferred from the client
+    to the backend and the client queries the status of the request
+    thereafter. Both is performed over the same connection like the
+    initial migration and recall request. The state of such a connection
+    is kept within its MessageParser::session_t: after the initial request
+    the messages are passed to MessageParser::getObjects, after the end of
+    the file names to MessageParser::reqStatusMessage. Between these
+    messages no thread is used (see @ref receiver_and_message_processing).
+    The jobs for all file names of a single message are added within one
+    batch of the job store (see JobStore::Batch). A job that cannot be
+    added (e.g. a duplicate file name) is reported individually and does
+    not affect the other jobs of that message.
 
     The following graph provides an overview of the complete client message processing:
 
@@ -70,7 +78,7 @@
         listen [fontname="courier bold", fontcolor=dodgerblue4, label="command.listen", URL="@ref LTFSDmCommServer::listen"];
         subgraph cluster_loop {
             label="while not terminated"
-            accept [fontname="courier bold", fontcolor=dodgerblue4, label="command.accept", URL="@ref LTFSDmCommServer::accept"];
+            receive [fontname="courier bold", fontcolor=dodgerblue4, label="Receiver::receive", URL="@ref Receiver::receive"];
             run [fontname="courier bold", fontcolor=dodgerblue4, label="MessageParser::run", URL="@ref MessageParser::run"];
             msg [label="MessageParser::...Message"];
             mig_msg [fontname="courier bold", fontcolor=dodgerblue4, label="MessageParser::migrationMessage", URL="@ref MessageParser::migrationMessage"];
@@ -78,184 +86,220 @@
             get_objects [fontname="courier bold", fontcolor=dodgerblue4, label="MessageParser::getObjects", URL="@ref MessageParser::getObjects"];
             req_status_msg [fontname="courier bold", fontcolor=dodgerblue4, label="MessageParser::reqStatusMessage", URL="@ref MessageParser::reqStatusMessage"];
         }
-        listen -> accept [lhead=cluster_loop, minlen=2];
-        accept -> run [fontname="courier bold", fontsize=8, fontcolor=dodgerblue4, label="wqm.enqueue", URL="@ref ThreadPool::enqueue"];
+        listen -> receive [lhead=cluster_loop, minlen=2];
+        receive -> run [fontname="courier bold", fontsize=8, fontcolor=dodgerblue4, label="wqm.enqueue", URL="@ref ThreadPool::enqueue"];
         run -> msg [];
-        run -> mig_msg [];
-        run -> rec_msg [];
-        mig_msg -> get_objects [fontsize=8, label="1st"];
-        mig_msg -> req_status_msg [fontsize=8, label="2nd"];
-        rec_msg -> get_objects [fontsize=8, label="1st"];
-        rec_msg -> req_status_msg [fontsize=8, label="2nd"];
+        run -> mig_msg [fontsize=8, label="MessageParser::NEW_MESSAGE"];
+        run -> rec_msg [fontsize=8, label="MessageParser::NEW_MESSAGE"];
+        run -> get_objects [fontsize=8, label="MessageParser::SEND_OBJECTS"];
+        run -> req_status_msg [fontsize=8, label="MessageParser::REQ_STATUS"];
     }
     @enddot
 
 
  */
 
-void MessageParser::getObjects(LTFSDmCommServer *command, long localReqNumber,
-        unsigned long pid, long requestNumber, FileOperation *fopt,
-        std::set<std::string> pools)
+/*
+ * Processes a single message of file names. The connection waits for
+ * the next message until the end of the list has been reached and the
+ * request has been added. The file information is retrieved before the
+ * jobs are added: a batch (i.e. a database transaction) is kept short
+ * by containing at most Const::JOB_UPDATE_BATCH jobs and no file system
+ * access.
+ */
+MessageParser::next_action MessageParser::getObjects(session_t *session)
 
 {
+    LTFSDmCommServer *command = &session->command;
     bool cont = true;
     int error = static_cast<int>(Error::OK);
 
     TRACE(Trace::full, __PRETTY_FUNCTION__);
 
-    while (cont) {
-        if (Server::forcedTerminate)
-            return;
+    if (Server::forcedTerminate) {
+        cleanup(session);
+        return MessageParser::CLOSE;
+    }
 
-        try {
-            command->recv();
-        } catch (const std::exception& e) {
-            TRACE(Trace::error, e.what());
-            MSG(LTFSDMS0006E);
-            THROW(Error::GENERAL_ERROR);
-        }
+    if (!command->has_sendobjects()) {
+        TRACE(Trace::error, command->has_sendobjects());
+        MSG(LTFSDMS0011E);
+        cleanup(session);
+        return MessageParser::CLOSE;
+    }
 
-        if (!command->has_sendobjects()) {
-            TRACE(Trace::error, command->has_sendobjects());
-            MSG(LTFSDMS0011E);
-            return;
-        }
+    const LTFSDmProtocol::LTFSDmSendObjects sendobjects =
+            command->sendobjects();
 
-        const LTFSDmProtocol::LTFSDmSendObjects sendobjects =
-                command->sendobjects();
+    std::vector<JobStore::job_t> jobs;
 
-        for (int j = 0; j < sendobjects.filenames_size(); j++) {
-            if (Server::terminate == true) {
-                command->closeAcc();
-                return;
+    for (int j = 0; j < sendobjects.filenames_size(); j++) {
+        if (Server::terminate == true) {
+            cleanup(session);
+            return MessageParser::CLOSE;
+        }
+        const LTFSDmProtocol::LTFSDmSendObjects::FileName& filename =
+                sendobjects.filenames(j);
+        if (filename.filename().compare("") != 0) {
+            try {
+                session->fopt->prepareJob(filename.filename(), &jobs);
+            } catch (const std::exception& e) {
+                TRACE(Trace::error, e.what());
             }
-            const LTFSDmProtocol::LTFSDmSendObjects::FileName& filename =
-                    sendobjects.filenames(j);
-            if (filename.filename().compare("") != 0) {
-                try {
-                    fopt->addJob(filename.filename());
-                } catch (const LTFSDMException& e) {
-                    TRACE(Trace::error, e.what());
-                    if (e.getErrno() == SQLITE_CONSTRAINT_PRIMARYKEY
-                            || e.getErrno() == SQLITE_CONSTRAINT_UNIQUE)
-                        MSG(LTFSDMS0019E, filename.filename().c_str());
-                    else
-                        MSG(LTFSDMS0015E, filename.filename().c_str(),
-                                e.what());
-                } catch (const std::exception& e) {
-                    TRACE(Trace::error, e.what());
-                }
-            } else {
-                cont = false; // END
+        } else {
+            cont = false; // END
+        }
+    }
+
+    std::vector<JobStore::job_t>::const_iterator it = jobs.begin();
+
+    while (it != jobs.end()) {
+        JobStore::Batch batch;
+
+        for (int i = 0; i < Const::JOB_UPDATE_BATCH && it != jobs.end();
+                i++, ++it) {
+            try {
+                session->fopt->addJob(*it);
+            } catch (const LTFSDMException& e) {
+                TRACE(Trace::error, e.what());
+                if (e.getErrno() == SQLITE_CONSTRAINT_PRIMARYKEY
+                        || e.getErrno() == SQLITE_CONSTRAINT_UNIQUE)
+                    MSG(LTFSDMS0019E, it->fileName.c_str());
+                else
+                    MSG(LTFSDMS0015E, it->fileName.c_str(), e.what());
+            } catch (const std::exception& e) {
+                TRACE(Trace::error, e.what());
             }
         }
+    }
 
-        if (cont == false) {
-            for (std::string pool : pools) {
-                unsigned long free = 0;
-                for (std::string cartridgeid : Server::conf.getPool(pool)) {
-                    std::shared_ptr<LTFSDMCartridge> cart =
-                            inventory->getCartridge(cartridgeid);
-                    if (cart != nullptr)
-                        free += cart->get_le()->get_remaining_cap();
-                }
-                free *= (1024*1024);
-                if (fopt->getRequestSize() > free) {
-                    TRACE(Trace::always, fopt->getRequestSize(), free);
-                    error = static_cast<int>(Error::POOL_TOO_SMALL);
-                }
+    if (cont == false) {
+        int replNum = Const::UNSET;
+        for (std::string pool : session->pools) {
+            unsigned long free = 0;
+            unsigned long pending = jobStats.sizePending(
+                    session->requestNumber, ++replNum);
+            for (std::string cartridgeid : Server::conf.getPool(pool)) {
+                std::shared_ptr<LTFSDMCartridge> cart =
+                        inventory->getCartridge(cartridgeid);
+                if (cart != nullptr)
+                    free += cart->get_le()->get_remaining_cap();
+            }
+            free *= (1024*1024);
+            if (pending > free) {
+                TRACE(Trace::always, pool, pending, free);
+                error = static_cast<int>(Error::POOL_TOO_SMALL);
             }
         }
+    }
 
-        command->Clear();
+    command->Clear();
 
-        LTFSDmProtocol::LTFSDmSendObjectsResp *sendobjresp =
-                command->mutable_sendobjectsresp();
+    LTFSDmProtocol::LTFSDmSendObjectsResp *sendobjresp =
+            command->mutable_sendobjectsresp();
 
-        sendobjresp->set_error(error);
-        sendobjresp->set_reqnumber(requestNumber);
-        sendobjresp->set_pid(pid);
+    sendobjresp->set_error(error);
+    sendobjresp->set_reqnumber(session->requestNumber);
+    sendobjresp->set_pid(session->pid);
 
-        try {
-            command->send();
-        } catch (const std::exception& e) {
-            TRACE(Trace::error, e.what());
-            MSG(LTFSDMS0007E);
-            return;
-        }
-        sendobjresp->Clear();
+    try {
+        command->send();
+    } catch (const std::exception& e) {
+        TRACE(Trace::error, e.what());
+        MSG(LTFSDMS0007E);
+        cleanup(session);
+        return MessageParser::CLOSE;
+    }
+    sendobjresp->Clear();
+
+    if (cont == false) {
+        session->fopt->addRequest();
+        session->state = MessageParser::REQ_STATUS;
     }
+
+    return MessageParser::WAIT_MESSAGE;
 }
 
-void MessageParser::reqStatusMessage(long key, LTFSDmCommServer *command,
-        FileOperation *fopt)
+/*
+ * Responds a status request as soon as the request has been completed
+ * or Const::REQ_STATUS_INTERVAL seconds after the status request has
+ * been received. Until then the connection waits for updates of the
+ * request without occupying a thread (see
+ * @ref receiver_and_message_processing).
+ */
+MessageParser::next_action MessageParser::reqStatusMessage(long key,
+        session_t *session)
 
 {
-    TRACE(Trace::always, __PRETTY_FUNCTION__);
+    TRACE(Trace::full, __PRETTY_FUNCTION__);
 
+    LTFSDmCommServer *command = &session->command;
     long resident = 0;
     long transferred = 0;
     long premigrated = 0;
     long migrated = 0;
     long failed = 0;
     bool done;
-    unsigned long pid;
-    long requestNumber;
     long keySent;
 
-    do {
-        try {
-            command->recv();
-        } catch (const std::exception& e) {
-            TRACE(Trace::error, e.what());
-            MSG(LTFSDMS0006E);
-            return;
-        }
-
+    if (session->statusTime == 0) {
         const LTFSDmProtocol::LTFSDmReqStatusRequest reqstatus =
                 command->reqstatusrequest();
 
         keySent = reqstatus.key();
         if (key != keySent) {
             MSG(LTFSDMS0008E, keySent);
-            return;
+            return MessageParser::CLOSE;
         }
 
-        requestNumber = reqstatus.reqnumber();
-        pid = reqstatus.pid();
+        session->requestNumber = reqstatus.reqnumber();
+        session->pid = reqstatus.pid();
+        session->statusTime = time(NULL);
+    }
 
-        done = fopt->queryResult(requestNumber, &resident, &transferred,
-                &premigrated, &migrated, &failed);
+    done = session->fopt->queryResult(session->requestNumber, &resident,
+            &transferred, &premigrated, &migrated, &failed);
 
-        LTFSDmProtocol::LTFSDmReqStatusResp *reqstatusresp =
-                command->mutable_reqstatusresp();
+    if (done == false
+            && time(NULL) - session->statusTime < Const::REQ_STATUS_INTERVAL)
+        return MessageParser::WAIT_UPDATE;
 
-        reqstatusresp->set_success(true);
-        reqstatusresp->set_reqnumber(requestNumber);
-        reqstatusresp->set_pid(pid);
-        reqstatusresp->set_resident(resident);
-        reqstatusresp->set_transferred(transferred);
-        reqstatusresp->set_premigrated(premigrated);
-        reqstatusresp->set_migrated(migrated);
-        reqstatusresp->set_failed(failed);
-        reqstatusresp->set_done(done);
+    session->statusTime = 0;
 
-        try {
-            command->send();
-        } catch (const std::exception& e) {
-            TRACE(Trace::error, e.what());
-            MSG(LTFSDMS0007E);
-            return;
-        }
-    } while (!done);
+    LTFSDmProtocol::LTFSDmReqStatusResp *reqstatusresp =
+            command->mutable_reqstatusresp();
+
+    reqstatusresp->set_success(true);
+    reqstatusresp->set_reqnumber(session->requestNumber);
+    reqstatusresp->set_pid(session->pid);
+    reqstatusresp->set_resident(resident);
+    reqstatusresp->set_transferred(transferred);
+    reqstatusresp->set_premigrated(premigrated);
+    reqstatusresp->set_migrated(migrated);
+    reqstatusresp->set_failed(failed);
+    reqstatusresp->set_done(done);
+
+    try {
+        command->send();
+    } catch (const std::exception& e) {
+        TRACE(Trace::error, e.what());
+        MSG(LTFSDMS0007E);
+        return MessageParser::CLOSE;
+    }
+
+    if (done)
+        return MessageParser::CLOSE;
+    else
+        return MessageParser::WAIT_MESSAGE;
 }
 
-void MessageParser::migrationMessage(long key, LTFSDmCommServer *command,
-        long localReqNumber)
+MessageParser::next_action MessageParser::migrationMessage(long key,
+        session_t *session)
 
 {
     TRACE(Trace::always, __PRETTY_FUNCTION__);
 
+    LTFSDmCommServer *command = &session->command;
     unsigned long pid;
     long requestNumber;
     const LTFSDmProtocol::LTFSDmMigRequest migreq = command->migrequest();
@@ -263,14 +307,13 @@ void MessageParser::migrationMessage(long key, LTFSDmCommServer *command,
     std::set<std::string> pools;
     std::string pool;
     int error = static_cast<int>(Error::OK);
-    Migration *mig = nullptr;
     std::set<std::string> allpools;
 
     TRACE(Trace::normal, keySent);
 
     if (key != keySent) {
         MSG(LTFSDMS0008E, keySent);
-        return;
+        return MessageParser::CLOSE;
     }
 
     requestNumber = migreq.reqnumber();
@@ -296,8 +339,9 @@ void MessageParser::migrationMessage(long key, LTFSDmCommServer *command,
             error = static_cast<int>(Error::WRONG_POOLNUM);
         }
 
-        mig = new Migration(pid, requestNumber, pools, pools.size(),
-                migreq.state());
+        session->fopt = std::unique_ptr<FileOperation>(
+                new Migration(pid, requestNumber, pools, pools.size(),
+                        migreq.state()));
     } else {
         error = static_cast<int>(Error::TERMINATING);
     }
@@ -314,51 +358,45 @@ void MessageParser::migrationMessage(long key, LTFSDmCommServer *command,
     } catch (const std::exception& e) {
         TRACE(Trace::error, e.what());
         MSG(LTFSDMS0007E);
-        return;
+        return MessageParser::CLOSE;
     }
 
-    if (!error) {
-        try {
-            getObjects(command, localReqNumber, pid, requestNumber,
-                    dynamic_cast<FileOperation*>(mig), pools);
-        } catch (const std::exception& e) {
-            SQLStatement stmt;
-            stmt(FileOperation::DELETE_JOBS) << requestNumber;
-            stmt.doall();
-            return;
-        }
-        mig->addRequest();
-        reqStatusMessage(key, command, dynamic_cast<FileOperation*>(mig));
-    }
+    if (error)
+        return MessageParser::CLOSE;
+
+    session->requestNumber = requestNumber;
+    session->pid = pid;
+    session->pools = pools;
+    session->state = MessageParser::SEND_OBJECTS;
 
-    if (mig != nullptr)
-        delete (mig);
+    return MessageParser::WAIT_MESSAGE;
 }
 
-void MessageParser::selRecallMessage(long key, LTFSDmCommServer *command,
-        long localReqNumber)
+MessageParser::next_action MessageParser::selRecallMessage(long key,
+        session_t *session)
 
 {
     TRACE(Trace::always, __PRETTY_FUNCTION__);
+    LTFSDmCommServer *command = &session->command;
     unsigned long pid;
     long requestNumber;
     const LTFSDmProtocol::LTFSDmSelRecRequest recreq = command->selrecrequest();
     long keySent = recreq.key();
     int error = static_cast<int>(Error::OK);
-    SelRecall *srec = nullptr;
 
     TRACE(Trace::normal, keySent);
 
     if (key != keySent) {
         MSG(LTFSDMS0008E, keySent);
-        return;
+        return MessageParser::CLOSE;
     }
 
     requestNumber = recreq.reqnumber();
     pid = recreq.pid();
 
     if (Server::terminate == false)
-        srec = new SelRecall(pid, requestNumber, recreq.state());
+        session->fopt = std::unique_ptr<FileOperation>(
+                new SelRecall(pid, requestNumber, recreq.state()));
     else
         error = static_cast<int>(Error::TERMINATING);
 
@@ -374,25 +412,17 @@ void MessageParser::selRecallMessage(long key, LTFSDmCommServer *command,
     } catch (const std::exception& e) {
         TRACE(Trace::error, e.what());
         MSG(LTFSDMS0007E);
-        return;
+        return MessageParser::CLOSE;
     }
 
-    if (!error) {
-        try {
-            getObjects(command, localReqNumber, pid, requestNumber,
-                    dynamic_cast<FileOperation*>(srec));
-        } catch (const std::exception& e) {
-            SQLStatement stmt;
-            stmt(FileOperation::DELETE_JOBS) << requestNumber;
-            stmt.doall();
-            return;
-        }
-        srec->addRequest();
-        reqStatusMessage(key, command, dynamic_cast<FileOperation*>(srec));
-    }
+    if (error)
+        return MessageParser::CLOSE;
 
-    if (srec != nullptr)
-        delete (srec);
+    session->requestNumber = requestNumber;
+    session->pid = pid;
+    session->state = MessageParser::SEND_OBJECTS;
+
+    return MessageParser::WAIT_MESSAGE;
 }
 
 void MessageParser::requestNumber(long key, LTFSDmCommServer *command,
@@ -429,85 +459,83 @@ void MessageParser::requestNumber(long key, LTFSDmCommServer *command,
 
 }
 
-void MessageParser::stopMessage(long key, LTFSDmCommServer *command,
-        std::unique_lock<std::mutex> *reclock, long localReqNumber)
+/*
+ * The client repeats the stop request until no request is in progress
+ * anymore. The termination is initiated with the first stop request of
+ * a connection.
+ */
+MessageParser::next_action MessageParser::stopMessage(long key,
+        session_t *session)
 
 {
     TRACE(Trace::always, __PRETTY_FUNCTION__);
+    LTFSDmCommServer *command = &session->command;
     const LTFSDmProtocol::LTFSDmStopRequest stopreq = command->stoprequest();
     long keySent = stopreq.key();
     SQLStatement stmt;
     int state;
-    int numreqs;
+    int numreqs = 0;
 
     TRACE(Trace::normal, keySent);
 
     if (key != keySent) {
         MSG(LTFSDMS0008E, keySent);
-        return;
+        return MessageParser::CLOSE;
     }
 
-    MSG(LTFSDMS0009I);
-
-    Server::terminate = true;
+    if (session->state != MessageParser::STOPPING) {
+        MSG(LTFSDMS0009I);
 
-    if (stopreq.forced()) {
-        Server::forcedTerminate = true;
-        Connector::forcedTerminate = true;
-    }
+        Server::terminate = true;
 
-    if (stopreq.finish()) {
-        Server::finishTerminate = true;
-        std::lock_guard<std::mutex> updlock(Scheduler::updmtx);
-        Scheduler::updcond.notify_all();
-    }
+        if (stopreq.forced()) {
+            Server::forcedTerminate = true;
+            Connector::forcedTerminate = true;
+        }
 
-    Server::termcond.notify_one();
-    reclock->unlock();
+        if (stopreq.finish()) {
+            Server::finishTerminate = true;
+            std::lock_guard<std::mutex> updlock(Scheduler::updmtx);
+            Scheduler::updcond.notify_all();
+        }
 
-    do {
-        numreqs = 0;
+        session->state = MessageParser::STOPPING;
+    }
 
-        if (Server::forcedTerminate == false && Server::finishTerminate == false) {
-            stmt(MessageParser::ALL_REQUESTS);
-            stmt.prepare();
-            while (stmt.step(&state)) {
-                if (state == DataBase::REQ_INPROGRESS) {
-                    numreqs++;
-                }
+    if (Server::forcedTerminate == false && Server::finishTerminate == false) {
+        stmt(MessageParser::ALL_REQUESTS);
+        stmt.prepare();
+        while (stmt.step(&state)) {
+            if (state == DataBase::REQ_INPROGRESS) {
+                numreqs++;
             }
-            stmt.finalize();
-            TRACE(Trace::always, numreqs);
         }
+        stmt.finalize();
+        TRACE(Trace::always, numreqs);
+    }
 
-        LTFSDmProtocol::LTFSDmStopResp *stopresp = command->mutable_stopresp();
+    LTFSDmProtocol::LTFSDmStopResp *stopresp = command->mutable_stopresp();
 
-        stopresp->set_success(numreqs == 0);
+    stopresp->set_success(numreqs == 0);
 
-        try {
-            command->send();
-        } catch (const std::exception& e) {
-            TRACE(Trace::error, e.what());
-            MSG(LTFSDMS0007E);
-            return;
-        }
+    try {
+        command->send();
+    } catch (const std::exception& e) {
+        TRACE(Trace::error, e.what());
+        MSG(LTFSDMS0007E);
+        return MessageParser::CLOSE;
+    }
 
-        if (numreqs > 0) {
-            try {
-                command->recv();
-            } catch (const std::exception& e) {
-                TRACE(Trace::error, e.what());
-                MSG(LTFSDMS0006E);
-                return;
-            }
-        }
-    } while (numreqs > 0);
+    if (numreqs > 0)
+        return MessageParser::WAIT_MESSAGE;
 
     TRACE(Trace::always, numreqs);
 
     Scheduler::invoke();
 
     kill(getpid(), SIGUSR1);
+
+    return MessageParser::CLOSE;
 }
 
 void MessageParser::statusMessage(long key, LTFSDmCommServer *command,
@@ -679,14 +707,7 @@ void MessageParser::infoJobsMessage(long key, LTFSDmCommServer *command,
             command->infojobsrequest();
     long keySent = infojobs.key();
     int requestNumber = infojobs.reqnumber();
-    SQLStatement stmt;
-    DataBase::operation op;
-    std::string fileName;
-    int reqNum;
-    std::string pool;
-    unsigned long fileSize;
-    std::string tapeId;
-    FsObj::file_state state;
+    bool sent = true;
 
     TRACE(Trace::normal, keySent);
 
@@ -697,35 +718,31 @@ void MessageParser::infoJobsMessage(long key, LTFSDmCommServer *command,
 
     TRACE(Trace::normal, requestNumber);
 
-    if (requestNumber != Const::UNSET)
-        stmt(MessageParser::INFO_SEL_JOBS) << requestNumber;
-    else
-        stmt(MessageParser::INFO_ALL_JOBS);
-
-    stmt.prepare();
-
-    while (stmt.step(&op, &fileName, &reqNum, &pool, &fileSize, &tapeId, &state)) {
-        LTFSDmProtocol::LTFSDmInfoJobsResp *infojobsresp =
+    jobStore->list(requestNumber,
+            [command, &sent] (const JobStore::job_t& job) {
+                LTFSDmProtocol::LTFSDmInfoJobsResp *infojobsresp =
                 command->mutable_infojobsresp();
 
-        infojobsresp->set_operation(DataBase::opStr(op));
-        infojobsresp->set_filename(fileName);
-        infojobsresp->set_reqnumber(reqNum);
-        infojobsresp->set_pool(pool);
-        infojobsresp->set_filesize(fileSize);
-        infojobsresp->set_tapeid(tapeId);
-        infojobsresp->set_state(state);
+                infojobsresp->set_operation(DataBase::opStr(job.operation));
+                infojobsresp->set_filename(job.fileName);
+                infojobsresp->set_reqnumber(job.reqNumber);
+                infojobsresp->set_pool(job.pool);
+                infojobsresp->set_filesize(job.fileSize);
+                infojobsresp->set_tapeid(job.tapeId);
+                infojobsresp->set_state(job.state);
 
-        try {
-            command->send();
-        } catch (const std::exception& e) {
-            TRACE(Trace::error, e.what());
-            MSG(LTFSDMS0007E);
-            stmt.finalize();
-            return;
-        }
-    }
-    stmt.finalize();
+                try {
+                    command->send();
+                } catch (const std::exception& e) {
+                    TRACE(Trace::error, e.what());
+                    MSG(LTFSDMS0007E);
+                    sent = false;
+                }
+                return sent;
+            });
+
+    if (sent == false)
+        return;
 
     LTFSDmProtocol::LTFSDmInfoJobsResp *infojobsresp =
             command->mutable_infojobsresp();
@@ -1092,6 +1109,7 @@ void MessageParser::poolAddMessage(long key, LTFSDmCommServer *command)
                 response = static_cast<int>(Error::TAPE_NOT_EXISTS);
                 break;
             }
+            Executor::Blocker blocker;
             std::unique_lock<std::mutex> lock(cartridge->mtx);
             Scheduler::invoke();
             cartridge->cond.wait(lock);
@@ -1275,75 +1293,205 @@ void MessageParser::retrieveMessage(long key, LTFSDmCommServer *command)
     }
 }
 
-void MessageParser::run(long key, LTFSDmCommServer command,
-        std::shared_ptr<Connector> connector)
+void MessageParser::infoStatsMessage(long key, LTFSDmCommServer *command)
 
 {
     TRACE(Trace::always, __PRETTY_FUNCTION__);
+    const LTFSDmProtocol::LTFSDmInfoStatsRequest infostats =
+            command->infostatsrequest();
+    long keySent = infostats.key();
+    std::string category = infostats.category();
 
-    std::unique_lock<std::mutex> lock(Server::termmtx);
-    bool firstTime = true;
-    long localReqNumber = Const::UNSET;
+    TRACE(Trace::normal, keySent, category);
+
+    if (key != keySent) {
+        MSG(LTFSDMS0008E, keySent);
+        return;
+    }
+
+    for (Metrics::metric_t metric : metrics.get(category)) {
+        LTFSDmProtocol::LTFSDmInfoStatsResp *infostatsresp =
+                command->mutable_infostatsresp();
+
+        infostatsresp->set_name(metric.name);
+        infostatsresp->set_counter(metric.isCounter);
+        infostatsresp->set_count(metric.hist.count);
+        infostatsresp->set_sum(metric.hist.sum);
+        infostatsresp->set_min(metric.hist.min);
+        infostatsresp->set_max(metric.hist.max);
+        if (metric.isCounter == false)
+            for (int i = 0; i < Metrics::NUM_BUCKETS; i++)
+                infostatsresp->add_buckets(metric.hist.buckets[i]);
 
-    while (true) {
         try {
-            command.recv();
+            command->send();
         } catch (const std::exception& e) {
             TRACE(Trace::error, e.what());
-            MSG(LTFSDMS0006E);
-            Server::termcond.notify_one();
-            lock.unlock();
+            MSG(LTFSDMS0007E);
             return;
         }
+        infostatsresp->Clear();
+    }
 
-        TRACE(Trace::full, "new message received");
+    LTFSDmProtocol::LTFSDmInfoStatsResp *infostatsresp =
+            command->mutable_infostatsresp();
 
-        if (command.has_reqnum()) {
-            requestNumber(key, &command, &localReqNumber);
-        } else {
-            if (command.has_stoprequest()) {
-                stopMessage(key, &command, &lock, localReqNumber);
-            } else {
-                if (firstTime) {
-                    Server::termcond.notify_one();
-                    lock.unlock();
-                    firstTime = false;
-                }
-                if (command.has_migrequest()) {
-                    migrationMessage(key, &command, localReqNumber);
-                } else if (command.has_selrecrequest()) {
-                    selRecallMessage(key, &command, localReqNumber);
-                } else if (command.has_statusrequest()) {
-                    statusMessage(key, &command, localReqNumber);
-                } else if (command.has_addrequest()) {
-                    addMessage(key, &command, localReqNumber, connector);
-                } else if (command.has_inforequestsrequest()) {
-                    infoRequestsMessage(key, &command, localReqNumber);
-                } else if (command.has_infojobsrequest()) {
-                    infoJobsMessage(key, &command, localReqNumber);
-                } else if (command.has_infodrivesrequest()) {
-                    infoDrivesMessage(key, &command);
-                } else if (command.has_infotapesrequest()) {
-                    infoTapesMessage(key, &command);
-                } else if (command.has_poolcreaterequest()) {
-                    poolCreateMessage(key, &command);
-                } else if (command.has_pooldeleterequest()) {
-                    poolDeleteMessage(key, &command);
-                } else if (command.has_pooladdrequest()) {
-                    poolAddMessage(key, &command);
-                } else if (command.has_poolremoverequest()) {
-                    poolRemoveMessage(key, &command);
-                } else if (command.has_infopoolsrequest()) {
-                    infoPoolsMessage(key, &command);
-                } else if (command.has_retrieverequest()) {
-                    retrieveMessage(key, &command);
-                } else {
-                    TRACE(Trace::error, "unkown command\n");
-                }
-            }
-            break;
+    infostatsresp->set_name("");
+    infostatsresp->set_counter(false);
+    infostatsresp->set_count(0);
+    infostatsresp->set_sum(0);
+    infostatsresp->set_min(0);
+    infostatsresp->set_max(0);
+
+    try {
+        command->send();
+    } catch (const std::exception& e) {
+        TRACE(Trace::error, e.what());
+        MSG(LTFSDMS0007E);
+    }
+}
+
+void MessageParser::infoSqlMessage(long key, LTFSDmCommServer *command)
+
+{
+    TRACE(Trace::always, __PRETTY_FUNCTION__);
+    const LTFSDmProtocol::LTFSDmInfoSqlRequest infosql =
+            command->infosqlrequest();
+    long keySent = infosql.key();
+
+    TRACE(Trace::normal, keySent);
+
+    if (key != keySent) {
+        MSG(LTFSDMS0008E, keySent);
+        return;
+    }
+
+    for (const auto& entry : SQLStatement::getProfiles()) {
+        LTFSDmProtocol::LTFSDmInfoSqlResp *infosqlresp =
+                command->mutable_infosqlresp();
+
+        infosqlresp->set_profiling(SQLStatement::profiling);
+        infosqlresp->set_statement(entry.first);
+        infosqlresp->set_executions(entry.second.executions);
+        infosqlresp->set_prepares(entry.second.prepares);
+        infosqlresp->set_preparens(entry.second.prepareNs);
+        infosqlresp->set_stepns(entry.second.stepNs);
+        infosqlresp->set_lockwaitns(entry.second.lockWaitNs);
+        infosqlresp->set_rows(entry.second.rows);
+        infosqlresp->set_changes(entry.second.changes);
+
+        try {
+            command->send();
+        } catch (const std::exception& e) {
+            TRACE(Trace::error, e.what());
+            MSG(LTFSDMS0007E);
+            return;
         }
-        command.Clear();
+        infosqlresp->Clear();
     }
-    command.closeAcc();
+
+    LTFSDmProtocol::LTFSDmInfoSqlResp *infosqlresp =
+            command->mutable_infosqlresp();
+
+    infosqlresp->set_profiling(SQLStatement::profiling);
+    infosqlresp->set_statement("");
+    infosqlresp->set_executions(0);
+    infosqlresp->set_prepares(0);
+    infosqlresp->set_preparens(0);
+    infosqlresp->set_stepns(0);
+    infosqlresp->set_lockwaitns(0);
+    infosqlresp->set_rows(0);
+    infosqlresp->set_changes(0);
+
+    try {
+        command->send();
+    } catch (const std::exception& e) {
+        TRACE(Trace::error, e.what());
+        MSG(LTFSDMS0007E);
+    }
+}
+
+/*
+ * Processes a single message that has been received by the Receiver.
+ * The return value tells the Receiver how to continue with the
+ * connection.
+ */
+MessageParser::next_action MessageParser::run(long key, session_t *session,
+        std::shared_ptr<Connector> connector)
+
+{
+    TRACE(Trace::full, __PRETTY_FUNCTION__);
+
+    LTFSDmCommServer *command = &session->command;
+
+    TRACE(Trace::full, "new message received", (int) session->state);
+
+    switch (session->state) {
+        case MessageParser::SEND_OBJECTS:
+            return getObjects(session);
+        case MessageParser::REQ_STATUS:
+            return reqStatusMessage(key, session);
+        default:
+            break;
+    }
+
+    if (command->has_reqnum()) {
+        requestNumber(key, command, &session->localReqNumber);
+        return MessageParser::WAIT_MESSAGE;
+    } else if (command->has_stoprequest()) {
+        return stopMessage(key, session);
+    } else if (command->has_migrequest()) {
+        return migrationMessage(key, session);
+    } else if (command->has_selrecrequest()) {
+        return selRecallMessage(key, session);
+    } else if (command->has_statusrequest()) {
+        statusMessage(key, command, session->localReqNumber);
+    } else if (command->has_addrequest()) {
+        addMessage(key, command, session->localReqNumber, connector);
+    } else if (command->has_inforequestsrequest()) {
+        infoRequestsMessage(key, command, session->localReqNumber);
+    } else if (command->has_infojobsrequest()) {
+        infoJobsMessage(key, command, session->localReqNumber);
+    } else if (command->has_infodrivesrequest()) {
+        infoDrivesMessage(key, command);
+    } else if (command->has_infotapesrequest()) {
+        infoTapesMessage(key, command);
+    } else if (command->has_poolcreaterequest()) {
+        poolCreateMessage(key, command);
+    } else if (command->has_pooldeleterequest()) {
+        poolDeleteMessage(key, command);
+    } else if (command->has_pooladdrequest()) {
+        poolAddMessage(key, command);
+    } else if (command->has_poolremoverequest()) {
+        poolRemoveMessage(key, command);
+    } else if (command->has_infopoolsrequest()) {
+        infoPoolsMessage(key, command);
+    } else if (command->has_infostatsrequest()) {
+        infoStatsMessage(key, command);
+    } else if (command->has_infosqlrequest()) {
+        infoSqlMessage(key, command);
+    } else if (command->has_retrieverequest()) {
+        retrieveMessage(key, command);
+    } else {
+        TRACE(Trace::error, "unkown command\n");
+    }
+
+    return MessageParser::CLOSE;
+}
+
+/*
+ * Removes the jobs of a migration or recall request if the connection
+ * is closed before all file names have been received.
+ */
+void MessageParser::cleanup(session_t *session)
+
+{
+    if (session->state != MessageParser::SEND_OBJECTS)
+        return;
+
+    TRACE(Trace::always, session->requestNumber);
+
+    jobStore->remove(session->requestNumber);
+    jobStats.remove(session->requestNumber);
+    session->state = MessageParser::NEW_MESSAGE;
 }
@@ -19,26 +19,54 @@
 class MessageParser
 
 {
+public:
+    enum session_state
+    {
+        NEW_MESSAGE,
+        SEND_OBJECTS,
+        REQ_STATUS,
+        STOPPING
+    };
+
+    enum next_action
+    {
+        WAIT_MESSAGE,
+        WAIT_UPDATE,
+        CLOSE
+    };
+
+    struct session_t
+    {
+        LTFSDmCommServer command;
+        std::string buffer;
+        std::atomic<session_state> state;
+        long localReqNumber;
+        long requestNumber;
+        unsigned long pid;
+        std::unique_ptr<FileOperation> fopt;
+        std::set<std::string> pools;
+        time_t statusTime;
+        session_t(int fd) :
+                command(Const::CLIENT_SOCKET_FILE), state(NEW_MESSAGE), localReqNumber(
+                        Const::UNSET), requestNumber(Const::UNSET), pid(0), statusTime(
+                        0)
+        {
+            command.setAccFd(fd);
+        }
+    };
+
 private:
     static const std::string ALL_REQUESTS;
     static const std::string INFO_ALL_REQUESTS;
     static const std::string INFO_ONE_REQUEST;
-    static const std::string INFO_ALL_JOBS;
-    static const std::string INFO_SEL_JOBS;
 
-    static void getObjects(LTFSDmCommServer *command, long localReqNumber,
-            unsigned long pid, long requestNumber, FileOperation *fopt,
-            std::set<std::string> pools = {});
-    static void reqStatusMessage(long key, LTFSDmCommServer *command,
-            FileOperation *fopt);
-    static void migrationMessage(long key, LTFSDmCommServer *command,
-            long localReqNumber);
-    static void selRecallMessage(long key, LTFSDmCommServer *command,
-            long localReqNumber);
+    static next_action getObjects(session_t *session);
+    static next_action reqStatusMessage(long key, session_t *session);
+    static next_action migrationMessage(long key, session_t *session);
+    static next_action selRecallMessage(long key, session_t *session);
     static void requestNumber(long key, LTFSDmCommServer *command,
             long *localReqNumber);
-    static void stopMessage(long key, LTFSDmCommServer *command,
-            std::unique_lock<std::mutex> *reclock, long localReqNumber);
+    static next_action stopMessage(long key, session_t *session);
     static void statusMessage(long key, LTFSDmCommServer *command,
             long localReqNumber);
     static void addMessage(long key, LTFSDmCommServer *command,
@@ -54,6 +82,8 @@ private:
     static void poolAddMessage(long key, LTFSDmCommServer *command);
     static void poolRemoveMessage(long key, LTFSDmCommServer *command);
     static void infoPoolsMessage(long key, LTFSDmCommServer *command);
+    static void infoStatsMessage(long key, LTFSDmCommServer *command);
+    static void infoSqlMessage(long key, LTFSDmCommServer *command);
     static void retrieveMessage(long key, LTFSDmCommServer *command);
 public:
     MessageParser()
@@ -62,6 +92,7 @@ public:
     ~MessageParser()
     {
     }
-    static void run(long key, LTFSDmCommServer command,
+    static next_action run(long key, session_t *session,
             std::shared_ptr<Connector> connector);
+    static void cleanup(session_t *session);
 };
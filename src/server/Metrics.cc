@@ -0,0 +1,207 @@
+/*******************************************************************************
+ * Copyright 2018 IBM Corp. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *******************************************************************************/
+#include "ServerIncludes.h"
+
+/** @page metrics Metrics
+
+    # Metrics
+
+    The backend keeps latency histograms and counters that can be queried
+    by the client (e.g. @ref ltfsdm_info_scheduler "ltfsdm info scheduler").
+    Each histogram or counter belongs to a category (e.g. "scheduler") and
+    has a name that describes what is measured. For each histogram the
+    number of values, the sum, the minimum, the maximum, and the number of
+    values per bucket are provided. Values are in milliseconds. Bucket 0
+    counts values smaller than 1 ms, bucket i (i > 0) values from 2^(i-1)
+    up to 2^i ms. The last bucket additionally counts all larger values.
+
+    Durations are recorded
+
+    - by using a Metrics::Timer object that records the time from its
+      creation until it goes out of scope,
+    - by Metrics::startTimer and Metrics::stopTimer for durations
+      that start and end within different code parts (e.g. the time a
+      suspended migration is waiting to be continued), or
+    - by providing the value directly (Metrics::add).
+
+    The following metrics are available for the "scheduler" category:
+
+    name | description
+    ---|---
+    queue wait @<operation@> | time from adding a request or queueing it again (Scheduler::requeued) until it gets scheduled
+    exec @<operation@> | processing time of a scheduled request
+    mount @<drive id@> | time to mount a cartridge into the drive
+    move @<drive id@> | time to move a cartridge into the drive
+    unmount @<drive id@> | time to unmount a cartridge from the drive
+    suspend to resume | time a suspended operation is waiting to be continued
+    mounts, moves, unmounts | number of cartridge movements (counter)
+    suspend requests | number of requests to suspend an operation (counter)
+    suspensions | number of suspended operations (counter)
+    prestaged mounts, prestaged unmounts | number of cartridge movements initiated by Scheduler::prestage (counter)
+    assigned mounts, assigned unmounts | number of cartridge movements to a drive assigned by the MountPlanner (counter)
+    planned moves | robot moves of the drive assignment of a scheduler pass that assigned drives, see @ref mount_planner
+
+    The "transfers" category contains the following counters per drive
+    (see @ref drive_placement):
+
+    name | description
+    ---|---
+    bytes written @<drive id@> | number of bytes written to cartridges by premigration
+    write us @<drive id@> | time spent writing these bytes in microseconds
+    bytes read @<drive id@> | number of bytes read from cartridges by selective and transparent recalls
+    read us @<drive id@> | time spent reading these bytes in microseconds
+
+    The "threads" category is not recorded within the Metrics object but
+    is provided by the Executor (Executor::getMetrics) for the executor
+    threads and for each task group, i.e. for each ThreadPool and the
+    SubServer objects. Groups are named like the ThreadPool (e.g.
+    "stub2-wq", "pmig0-wq", "trec-wq", "msg-wq"):
+
+    name | description
+    ---|---
+    threads live | number of executor threads (counter)
+    threads peak | maximum number of executor threads (counter)
+    threads spawned | number of executor threads that have been started (counter)
+    threads reaped | number of spare threads that terminated after Const::IDLE_THREAD_LIVE_TIME of inactivity (counter)
+    threads blocked | number of threads executing a task of a blocking group (counter)
+    @<group@> running | number of tasks of the group that are currently executed (counter)
+    @<group@> running peak | maximum number of tasks of the group executed concurrently (counter)
+    @<group@> queue wait | time from submitting a task until it is executed
+    @<group@> run time | execution time of the tasks
+    @<group@> enqueue wait | time ThreadPool::enqueue blocked since the queue was full
+
+    Thread counts and running tasks are current values and not
+    accumulated. These values help sizing the number of threads of the
+    pools (e.g. Const::MAX_PREMIG_THREADS, Const::MAX_STUBBING_THREADS):
+    a large queue wait while the running peak is at the limit of the
+    pool shows that the pool would benefit from more threads.
+ */
+
+Metrics metrics;
+
+Metrics::Timer::~Timer()
+
+{
+    metrics.add(category, name, std::chrono::steady_clock::now() - start);
+}
+
+void Metrics::add(std::string category, std::string name, unsigned long value)
+
+{
+    std::lock_guard<std::mutex> lock(mtx);
+
+    record(&histograms[category][name], value);
+}
+
+void Metrics::add(std::string category, std::string name,
+        std::chrono::steady_clock::duration duration)
+
+{
+    std::lock_guard<std::mutex> lock(mtx);
+
+    record(&histograms[category][name], duration);
+}
+
+void Metrics::increment(std::string category, std::string name,
+        unsigned long value)
+
+{
+    std::lock_guard<std::mutex> lock(mtx);
+
+    counters[category][name] += value;
+}
+
+void Metrics::startTimer(std::string category, std::string name,
+        std::string key)
+
+{
+    std::lock_guard<std::mutex> lock(mtx);
+
+    started[category + "/" + name + "/" + key] =
+            std::chrono::steady_clock::now();
+}
+
+bool Metrics::stopTimer(std::string category, std::string name,
+        std::string key)
+
+{
+    std::chrono::steady_clock::time_point start;
+
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+
+        auto it = started.find(category + "/" + name + "/" + key);
+        if (it == started.end())
+            return false;
+        start = it->second;
+        started.erase(it);
+    }
+
+    add(category, name, std::chrono::steady_clock::now() - start);
+
+    return true;
+}
+
+/*
+ * Removes the started timers of a category with a key starting with
+ * keyPrefix without recording them, e.g. for a request that has been
+ * removed while it was suspended.
+ */
+void Metrics::cancelTimers(std::string category, std::string keyPrefix)
+
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    std::string::size_type pos;
+
+    for (auto it = started.begin(); it != started.end();) {
+        // the entries are named <category>/<name>/<key>
+        if (it->first.compare(0, category.size() + 1, category + "/") == 0
+                && (pos = it->first.find('/', category.size() + 1))
+                        != std::string::npos
+                && it->first.compare(pos + 1, keyPrefix.size(), keyPrefix)
+                        == 0)
+            it = started.erase(it);
+        else
+            ++it;
+    }
+}
+
+std::list<Metrics::metric_t> Metrics::get(std::string category)
+
+{
+    std::list<metric_t> metricList;
+
+    if (category.compare("threads") == 0) {
+        Executor::instance().getMetrics(&metricList);
+        return metricList;
+    }
+
+    std::lock_guard<std::mutex> lock(mtx);
+
+    for (auto counter : counters[category]) {
+        metric_t metric;
+        metric.name = counter.first;
+        metric.isCounter = true;
+        metric.hist.count = counter.second;
+        metricList.push_back(metric);
+    }
+
+    for (auto hist : histograms[category])
+        metricList.push_back( { hist.first, false, hist.second });
+
+    return metricList;
+}
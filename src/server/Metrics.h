@@ -0,0 +1,94 @@
+/*******************************************************************************
+ * Copyright 2018 IBM Corp. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *******************************************************************************/
+#pragma once
+
+class Metrics
+{
+public:
+    static const int NUM_BUCKETS = 32;
+    struct histogram_t
+    {
+        unsigned long count = 0;
+        unsigned long sum = 0;
+        unsigned long min = 0;
+        unsigned long max = 0;
+        unsigned long buckets[NUM_BUCKETS] = { };
+    };
+    struct metric_t
+    {
+        std::string name;
+        bool isCounter;
+        histogram_t hist;
+    };
+    class Timer
+    {
+    private:
+        std::string category;
+        std::string name;
+        std::chrono::steady_clock::time_point start;
+    public:
+        Timer(std::string _category, std::string _name) :
+                category(_category), name(_name), start(
+                        std::chrono::steady_clock::now())
+        {
+        }
+        ~Timer();
+    };
+private:
+    std::map<std::string, std::map<std::string, histogram_t>> histograms;
+    std::map<std::string, std::map<std::string, unsigned long>> counters;
+    std::map<std::string, std::chrono::steady_clock::time_point> started;
+    std::mutex mtx;
+public:
+    Metrics()
+    {
+    }
+    // also used by the Executor that keeps the histograms of its groups
+    static void record(histogram_t *hist, unsigned long value)
+    {
+        int bucket = 0;
+
+        while (bucket < NUM_BUCKETS - 1 && value >= (1UL << bucket))
+            bucket++;
+
+        if (hist->count == 0 || value < hist->min)
+            hist->min = value;
+        if (value > hist->max)
+            hist->max = value;
+        hist->count++;
+        hist->sum += value;
+        hist->buckets[bucket]++;
+    }
+    static void record(histogram_t *hist,
+            std::chrono::steady_clock::duration duration)
+    {
+        record(hist,
+                std::chrono::duration_cast<std::chrono::milliseconds>(
+                        duration).count());
+    }
+    void add(std::string category, std::string name, unsigned long value);
+    void add(std::string category, std::string name,
+            std::chrono::steady_clock::duration duration);
+    void increment(std::string category, std::string name,
+            unsigned long value = 1);
+    void startTimer(std::string category, std::string name, std::string key);
+    bool stopTimer(std::string category, std::string name, std::string key);
+    void cancelTimers(std::string category, std::string keyPrefix);
+    std::list<metric_t> get(std::string category);
+};
+
+extern Metrics metrics;
@@ -88,7 +88,8 @@
 
     Thereafter the file names of the files to be migrated are sent to the backend.
     When receiving this information corresponding entries are added to the SQL
-    table JOB_QUEUE. For each file name one or more jobs are created based
+    table JOB_QUEUE (or to the in-memory job store, see @ref job_store).
+    For each file name one or more jobs are created based
     on the number of tape storage pools being specified. After that: entries are added
     to the SQL table REQUEST_QUEUE. For each storage pool being specified a
     corresponding entry is added to that table.
@@ -130,6 +131,7 @@
     - create a Migration object
     - respond back to the client with a request number
     - MessageParser::getObjects: retrieving file names to migrate
+        - Migration::prepareJob: retrieve the file information
         - Migration::addJob: add migration information the the SQLite table JOB_QUEUE
     - Migration::addRequest: add a request to the SQLite table REQUEST_QUEUE
     - MessageParser::reqStatusMessage: provide updates of the migration processing to the client
@@ -165,6 +167,26 @@
     necessary for the client that initiated the request to receive progress
     information.
 
+    The thread executing Migration::execRequest is not occupied while the
+    files are transferred or stubbed by the ThreadPool objects. The
+    request is processed by a sequence of continuations that are executed
+    on the @ref executor "Executor" when all tasks of the preceding step
+    have completed (see SubServer::continueAfter):
+
+    <TT>
+      - Migration::execRequest: enqueue the data transfer
+      - Migration::transferred: synchronize the tape index, release the
+        cartridge and the drive, enqueue the change of the file states
+        (Migration::changeStates)
+      - Migration::complete: update the request
+    </TT>
+
+    The steps share a copy of the Migration object that is owned by a
+    std::shared_ptr. Until the last step has completed the Scheduler
+    counts the request as running. If the request is executed by the
+    Migration::swq ThreadPool (no cartridge required) the steps are
+    executed one after the other by the same thread.
+
     ### Migration::processFiles
 
     The Migration::processFiles method is called twice first to transfer the
@@ -179,7 +201,14 @@
     steps:
 
     -# All corresponding jobs are changed to FsObj::TRANSFERRING or
-       FsObj::CHANGINGFSTATE depending on the migration phase. The following
+       FsObj::CHANGINGFSTATE depending on the migration phase. For the
+       data transfer only these jobs are changed that fit onto the
+       cartridge (see Migration::assignJobs). They are selected by
+       first-fit decreasing: the largest files are assigned first and
+       smaller ones fill the remaining space. The size of a file on tape
+       (Migration::tapeSize) is rounded up to Const::LTFS_BLOCK_SIZE and
+       includes Const::LTFS_FILE_OVERHEAD for the index entry. The
+       remaining jobs are written to a further cartridge. The following
        example shows this change for the first phase of six files:
        @dot
        digraph step_1 {
@@ -195,6 +224,8 @@
        @enddot
     -# Process all these jobs in FsObj::TRANSFERRING or FsObj::CHANGINGFSTATE state
        which results in the data transfer or stubbing of all corresponding files.
+       Failures are written via the write-behind queue (see @ref job_state_queue)
+       which is flushed after all files have been processed.
        The following change indicates that the data transfer of file file.4 failed:
        @dot
        digraph step_1 {
@@ -208,10 +239,12 @@
             before -> after [];
        }
        @enddot
-    -# A list is returned containing the inode numbers of these files where
+    -# A list is returned containing the file uids of these files where
        the previous operation was successful. Change all corresponding jobs
        to FsObj::TRANSFERRED or FsObj::MIGRATED depending of the migration
-       phase. The following changed indicates that data transfer stopped
+       phase. The jobs are updated by their file uid in transactions of
+       Const::JOB_UPDATE_BATCH files (see JobStore::changeState).
+       The following changed indicates that data transfer stopped
        before file file.5:
        @dot
        digraph step_1 {
@@ -225,7 +258,7 @@
             before -> after [];
        }
        @enddot
-    -# The remaining jobs (those where no corresponding inode numbers were
+    -# The remaining jobs (those where no corresponding file uids were
        in the list) have not been processed and need to be changed to the
        original state if these were still in FsObj::TRANSFERRING or
        FsObj::CHANGINGFSTATE state. Jobs that failed in the second step already
@@ -330,6 +363,14 @@
     doing the reads and writes this loop is serialized by
     a std::mutex LTFSDMDrive::mtx.
 
+    Before each chunk of Const::READ_BUFFER_SIZE bytes is copied it is
+    checked if an operation with a higher priority (e.g. a recall) is
+    waiting for the drive (LTFSDMDrive::getToUnblock). In this case the
+    transfer is stopped, the partially written data file is removed from
+    tape, and the job is put back to its previous state to be migrated
+    again later. This way a waiting recall does not need to wait until a
+    large file has been copied completely.
+
     ### Migration::changeFileState
 
     For the change of the migration state (includes stubbing in the case that
@@ -406,14 +447,16 @@ FsObj::file_state Migration::checkState(std::string fileName, FsObj *fso)
     return state;
 }
 
-void Migration::addJob(std::string fileName)
+void Migration::prepareJob(std::string fileName,
+        std::vector<JobStore::job_t> *jobs)
 
 {
-    int replNum;
     struct stat statbuf;
-    FsObj::file_state state;
-    SQLStatement stmt;
-    fuid_t fuid;
+    JobStore::job_t job = { DataBase::MIGRATION, fileName, reqNumber,
+            targetState, Const::UNSET, "", 0, { (unsigned long) Const::UNSET,
+                    (unsigned long) Const::UNSET, (unsigned int) Const::UNSET,
+                    (unsigned long) Const::UNSET }, 0, 0, time(NULL), "",
+            FsObj::FAILED, 0, 0 };
 
     try {
         FsObj fso(fileName);
@@ -424,49 +467,45 @@ void Migration::addJob(std::string fileName)
             return;
         }
 
-        state = checkState(fileName, &fso);
-
-        fuid = fso.getfuid();
-        stmt(Migration::ADD_JOB) << DataBase::MIGRATION << fileName << reqNumber
-                << targetState << statbuf.st_size << fuid.fsid_h << fuid.fsid_l
-                << fuid.igen << fuid.inum << statbuf.st_mtim.tv_sec
-                << statbuf.st_mtim.tv_nsec << time(NULL) << state;
-        requestSize += fso.stat().st_size;
+        job.state = checkState(fileName, &fso);
+        job.fileSize = statbuf.st_size;
+        job.fuid = fso.getfuid();
+        job.mtimeSec = statbuf.st_mtim.tv_sec;
+        job.mtimeNsec = statbuf.st_mtim.tv_nsec;
     } catch (const std::exception& e) {
         MSG(LTFSDMS0077E, fileName);
         TRACE(Trace::error, e.what());
-        stmt(Migration::ADD_JOB) << DataBase::MIGRATION << fileName << reqNumber
-                << targetState << Const::UNSET << Const::UNSET << Const::UNSET
-                << Const::UNSET << Const::UNSET << 0 << 0 << time(NULL)
-                << FsObj::FAILED;
+        job.state = FsObj::FAILED;
     }
 
-    replNum = Const::UNSET;
+    jobs->push_back(job);
+}
+
+/*
+ * A job is added for each tape storage pool, i.e. for each replica.
+ */
+void Migration::addJob(const JobStore::job_t& job)
+
+{
+    JobStore::job_t repl = job;
 
     if (pools.size() == 0)
         pools.insert("");
 
-    TRACE(Trace::normal, stmt.str());
-
     for (std::string pool : pools) {
-        TRACE(Trace::full, stmt.str());
         try {
-            replNum++;
-            stmt.prepare();
-            stmt.bind(1, replNum);
-            stmt.bind(2, pool);
-            stmt.step();
-            stmt.finalize();
+            repl.replNum++;
+            repl.pool = pool;
+            jobStore->add(repl);
+            jobStats.add(reqNumber, repl.replNum, repl.state, repl.fileSize);
         } catch (const std::exception& e) {
             TRACE(Trace::error, e.what());
-            MSG(LTFSDMS0028E, fileName);
+            MSG(LTFSDMS0028E, repl.fileName);
         }
-        TRACE(Trace::always, fileName, replNum, pool);
+        TRACE(Trace::always, repl.fileName, repl.replNum, pool);
     }
 
     jobnum++;
-
-    return;
 }
 
 void Migration::addRequest()
@@ -491,7 +530,8 @@ void Migration::addRequest()
         replNum++;
 
         stmt(Migration::ADD_REQUEST) << DataBase::MIGRATION << reqNumber
-                << targetState << numReplica << replNum << pool << time(NULL)
+                << targetState << numReplica << replNum << pool
+                << DataBase::timeAdded()
                 << (needsTape ? DataBase::REQ_NEW : DataBase::REQ_INPROGRESS);
 
         TRACE(Trace::normal, stmt.str());
@@ -514,18 +554,20 @@ void Migration::addRequest()
 
 unsigned long Migration::transferData(std::string tapeId, std::string driveId,
         long secs, long nsecs, Migration::mig_info_t mig_info,
-        std::shared_ptr<std::list<unsigned long>> inumList,
+        std::shared_ptr<std::vector<fuid_t>> uidList,
         std::shared_ptr<bool> suspended)
 
 {
     struct stat statbuf, statbuf_changed;
     std::string tapeName;
-    char buffer[Const::READ_BUFFER_SIZE];
+    std::shared_ptr<LTFSDMDrive> drive = inventory->getDrive(driveId);
+    char *buffer;
     long rsize;
     long wsize;
     int fd = -1;
     long offset = 0;
     bool failed = false;
+    bool preempted = false;
 
     try {
         FsObj source(mig_info.fileName);
@@ -565,21 +607,25 @@ unsigned long Migration::transferData(std::string tapeId, std::string driveId,
         }
 
         {
-            std::lock_guard<std::mutex> writelock(
-                    *inventory->getDrive(driveId)->mtx);
-
-            if (inventory->getDrive(driveId)->getToUnblock()
-                    < DataBase::MIGRATION) {
-                TRACE(Trace::always, mig_info.fileName, tapeId);
-                std::lock_guard<std::mutex> lock(Migration::pmigmtx);
-                *suspended = true;
-                THROW(Error::OK);
-            }
+            LTFSDMDrive::Affinity affinity(drive);
+            std::lock_guard<std::mutex> writelock(*drive->mtx);
+            std::chrono::steady_clock::time_point start =
+                    std::chrono::steady_clock::now();
+
+            buffer = drive->getBuffer();
 
             while (offset < statbuf.st_size) {
                 if (Server::forcedTerminate)
                     THROW(Error::OK);
 
+                if (drive->getToUnblock() < DataBase::MIGRATION) {
+                    TRACE(Trace::always, mig_info.fileName, tapeId, offset);
+                    std::lock_guard<std::mutex> lock(Migration::pmigmtx);
+                    *suspended = true;
+                    preempted = true;
+                    THROW(Error::OK);
+                }
+
                 rsize = source.read(offset,
                         statbuf.st_size - offset > Const::READ_BUFFER_SIZE ?
                                 Const::READ_BUFFER_SIZE :
@@ -614,6 +660,9 @@ unsigned long Migration::transferData(std::string tapeId, std::string driveId,
                     THROW(Error::GENERAL_ERROR, mig_info.fileName);
                 }
             }
+
+            drive->transferred(true, offset,
+                    std::chrono::steady_clock::now() - start);
         }
 
         if (fsetxattr(fd, Const::LTFS_ATTR.c_str(), mig_info.fileName.c_str(),
@@ -627,11 +676,13 @@ unsigned long Migration::transferData(std::string tapeId, std::string driveId,
 
         mrStatus.updateSuccess(mig_info.reqNumber, mig_info.fromState,
                 mig_info.toState);
+        jobStats.update(mig_info.reqNumber, mig_info.replNum,
+                mig_info.fromState, mig_info.toState, mig_info.fileSize);
 
         source.addTapeAttr(tapeId, Server::getStartBlock(tapeName, fd));
 
         std::lock_guard<std::mutex> lock(Migration::pmigmtx);
-        inumList->push_back(mig_info.inum);
+        uidList->push_back(mig_info.fuid);
     } catch (const LTFSDMException& e) {
         TRACE(Trace::error, e.what());
         if (e.getError() != Error::OK)
@@ -645,22 +696,26 @@ unsigned long Migration::transferData(std::string tapeId, std::string driveId,
         TRACE(Trace::error, mig_info.fileName);
         MSG(LTFSDMS0050E, mig_info.fileName);
         mrStatus.updateFailed(mig_info.reqNumber, mig_info.fromState);
+        jobStats.update(mig_info.reqNumber, mig_info.replNum,
+                mig_info.fromState, FsObj::FAILED, mig_info.fileSize);
 
-        SQLStatement stmt = SQLStatement(Migration::FAIL_PREMIGRATION)
-                << FsObj::FAILED << mig_info.reqNumber << mig_info.fileName
-                << mig_info.replNum;
-
-        stmt.doall();
+        jobStateQueue.add([mig_info]() {
+            jobStore->fail(mig_info.reqNumber, mig_info.fileName,
+                    mig_info.replNum);
+        });
     }
 
     if (fd != -1)
         close(fd);
 
+    if (preempted && unlink(tapeName.c_str()) == -1)
+        TRACE(Trace::error, tapeName, errno);
+
     return statbuf.st_size;
 }
 
 void Migration::changeFileState(Migration::mig_info_t mig_info,
-        std::shared_ptr<std::list<unsigned long>> inumList,
+        std::shared_ptr<std::vector<fuid_t>> uidList,
         FsObj::file_state toState)
 
 {
@@ -698,46 +753,107 @@ void Migration::changeFileState(Migration::mig_info_t mig_info,
         }
 
         std::lock_guard<std::mutex> lock(Migration::pmigmtx);
-        inumList->push_back(mig_info.inum);
+        uidList->push_back(mig_info.fuid);
     } catch (const std::exception& e) {
         TRACE(Trace::error, e.what());
         MSG(LTFSDMS0089E, mig_info.fileName);
 
-        for (int i = 0; i < mig_info.numRepl; i++)
+        for (int i = 0; i < mig_info.numRepl; i++) {
             mrStatus.updateFailed(mig_info.reqNumber, mig_info.fromState);
+            jobStats.update(mig_info.reqNumber, i, mig_info.fromState,
+                    FsObj::FAILED, mig_info.fileSize);
+        }
 
-        SQLStatement stmt = SQLStatement(Migration::FAIL_STUBBING)
-                << FsObj::FAILED << mig_info.reqNumber << mig_info.fileName;
-
-        stmt.doall();
+        jobStateQueue.add([mig_info]() {
+            jobStore->fail(mig_info.reqNumber, mig_info.fileName,
+                    JobStore::NO_REPL);
+        });
         return;
     }
 
-    for (int i = 0; i < (mig_info.numRepl ? mig_info.numRepl : 1); i++)
+    for (int i = 0; i < (mig_info.numRepl ? mig_info.numRepl : 1); i++) {
         mrStatus.updateSuccess(mig_info.reqNumber, mig_info.fromState,
                 mig_info.toState);
+        jobStats.update(mig_info.reqNumber, i, mig_info.fromState,
+                mig_info.toState, mig_info.fileSize);
+    }
 }
 
-Migration::req_return_t Migration::processFiles(int replNum, std::string tapeId,
-        FsObj::file_state fromState, FsObj::file_state toState)
+/**
+ * Returns the space a file of the given size occupies on tape: LTFS
+ * starts each file at a new block and adds an entry to the index.
+ */
+unsigned long Migration::tapeSize(unsigned long fileSize)
+
+{
+    return ((fileSize + Const::LTFS_BLOCK_SIZE - 1) / Const::LTFS_BLOCK_SIZE)
+            * Const::LTFS_BLOCK_SIZE + Const::LTFS_FILE_OVERHEAD;
+}
+
+/**
+ * Selects the jobs of a replica to be written to a cartridge using
+ * first-fit decreasing: the jobs are sorted by their size on tape and
+ * the largest ones that still fit into the free space are assigned
+ * first. Smaller files fill the space that remains. The assigned jobs
+ * are changed to newState in transactions of Const::JOB_UPDATE_BATCH
+ * jobs. Returns true if there are jobs left that did not fit.
+ */
+bool Migration::assignJobs(int replNum, std::string tapeId,
+        FsObj::file_state fromState, FsObj::file_state newState,
+        unsigned long freeSpace)
+
+{
+    std::vector<std::pair<unsigned long, long>> jobs;
+    std::vector<long> assigned;
+
+    jobStore->pending(reqNumber, fromState, replNum, &jobs);
+    for (std::pair<unsigned long, long>& job : jobs)
+        job.first = tapeSize(job.first);
+
+    std::sort(jobs.begin(), jobs.end(),
+            [] (const std::pair<unsigned long, long>& a,
+                    const std::pair<unsigned long, long>& b) {
+                return a.first > b.first || (a.first == b.first && a.second < b.second);
+            });
+
+    for (std::pair<unsigned long, long> job : jobs) {
+        // the smallest jobs are at the end
+        if (freeSpace < jobs.back().first)
+            break;
+        if (job.first > freeSpace)
+            continue;
+        freeSpace -= job.first;
+        assigned.push_back(job.second);
+    }
+
+    TRACE(Trace::always, jobs.size(), assigned.size(), freeSpace);
+
+    jobStore->assign(reqNumber, assigned, newState, tapeId);
+
+    return assigned.size() < jobs.size();
+}
+
+/*
+ * The jobs are processed by the tasks of a ThreadPool. When all of them
+ * have completed the remaining steps are performed by a continuation
+ * (see SubServer::continueAfter) that finally calls next. The object
+ * needs to be owned by a std::shared_ptr.
+ */
+void Migration::processFiles(int replNum, std::string tapeId,
+        FsObj::file_state fromState, FsObj::file_state toState,
+        std::function<void(Migration::req_return_t)> next)
 
 {
-    SQLStatement stmt;
-    std::string fileName;
     Migration::req_return_t retval = (Migration::req_return_t ) { false, false };
     time_t start;
-    long secs;
-    long nsecs;
-    unsigned long inum;
     time_t steptime;
-    std::shared_ptr<std::list<unsigned long>> inumList = std::make_shared<
-            std::list<unsigned long>>();
+    std::shared_ptr<std::vector<fuid_t>> uidList = std::make_shared<
+            std::vector<fuid_t>>();
     std::shared_ptr<bool> suspended = std::make_shared<bool>(false);
     unsigned long freeSpace = 0;
-    int num_found = 0;
-    int total = 0;
     FsObj::file_state newState;
     std::shared_ptr<LTFSDMDrive> drive = nullptr;
+    std::shared_ptr<Migration> self = shared_from_this();
 
     TRACE(Trace::always, reqNumber);
 
@@ -762,191 +878,186 @@ Migration::req_return_t Migration::processFiles(int replNum, std::string tapeId,
             (toState == FsObj::TRANSFERRED) ?
                     FsObj::TRANSFERRING : FsObj::CHANGINGFSTATE);
 
+    steptime = time(NULL);
     if (toState == FsObj::TRANSFERRED) {
         freeSpace =
                 1024 * 1024
                         * inventory->getCartridge(tapeId)->get_le()->get_remaining_cap();
-        stmt(Migration::SET_TRANSFERRING) << newState << tapeId << reqNumber
-                << fromState << replNum << (unsigned long) &freeSpace
-                << (unsigned long) &num_found << (unsigned long) &total;
+        retval.remaining = assignJobs(replNum, tapeId, fromState, newState,
+                freeSpace);
     } else {
-        stmt(Migration::SET_CHANGE_STATE) << newState << reqNumber << fromState
-                << tapeId << replNum;
+        jobStore->changeState(reqNumber, tapeId, replNum, fromState, newState);
     }
-    TRACE(Trace::normal, stmt.str());
-    steptime = time(NULL);
-    stmt.doall();
-
-    TRACE(Trace::always, time(NULL) - steptime, num_found, total);
-    if (total > num_found)
-        retval.remaining = true;
+    TRACE(Trace::always, time(NULL) - steptime, retval.remaining);
 
-    stmt(Migration::SELECT_JOBS) << reqNumber << newState << tapeId;
-    TRACE(Trace::normal, stmt.str());
-    stmt.prepare();
     start = time(NULL);
-    while (stmt.step(&fileName, &secs, &nsecs, &inum)) {
-        if (Server::terminate == true)
-            break;
+    jobStore->select(reqNumber, tapeId, { newState }, 0,
+            [this, replNum, tapeId, fromState, toState, drive, uidList, suspended, &retval, &start] (const JobStore::job_t& job) {
+                if (Server::terminate == true)
+                return false;
 
-        try {
-            Migration::mig_info_t mig_info = { fileName, reqNumber, numReplica,
-                    replNum, inum, "", fromState, toState };
+                try {
+                    Migration::mig_info_t mig_info = {job.fileName, reqNumber, numReplica,
+                        replNum, job.fuid, job.fileSize, "", fromState, toState};
 
-            TRACE(Trace::always, fileName, reqNumber);
+                    TRACE(Trace::always, job.fileName, reqNumber);
 
-            if (toState == FsObj::TRANSFERRED) {
-                if (drive->getToUnblock() < DataBase::MIGRATION) {
-                    retval.suspended = true;
-                    break;
+                    if (toState == FsObj::TRANSFERRED) {
+                        if (drive->getToUnblock() < DataBase::MIGRATION) {
+                            retval.suspended = true;
+                            return false;
+                        }
+                        TRACE(Trace::full, job.mtimeSec, job.mtimeNsec);
+                        drive->wqp->enqueue(reqNumber, tapeId,
+                                drive->get_le()->GetObjectID(), job.mtimeSec,
+                                job.mtimeNsec, mig_info, uidList, suspended);
+                    } else {
+                        Server::wqs->enqueue(reqNumber, mig_info, uidList, toState);
+                    }
+                } catch (const std::exception& e) {
+                    TRACE(Trace::error, e.what());
+                    return true;
                 }
-                TRACE(Trace::full, secs, nsecs);
-                drive->wqp->enqueue(reqNumber, tapeId,
-                        drive->get_le()->GetObjectID(), secs, nsecs, mig_info,
-                        inumList, suspended);
-            } else {
-                Server::wqs->enqueue(reqNumber, mig_info, inumList, toState);
-            }
-        } catch (const std::exception& e) {
-            TRACE(Trace::error, e.what());
-            continue;
-        }
 
-        if (time(NULL) - start < 10)
-            continue;
+                if (time(NULL) - start < 10)
+                return true;
 
-        start = time(NULL);
+                start = time(NULL);
 
-        std::lock_guard<std::mutex> lock(Scheduler::updmtx);
-        Scheduler::updReq[reqNumber] = true;
-        Scheduler::updcond.notify_all();
-    }
+                std::lock_guard<std::mutex> lock(Scheduler::updmtx);
+                Scheduler::updReq[reqNumber] = true;
+                Scheduler::updcond.notify_all();
+                return true;
+            });
     {
         std::lock_guard<std::mutex> lock(Scheduler::updmtx);
         Scheduler::updReq[reqNumber] = true;
         Scheduler::updcond.notify_all();
     }
-    stmt.finalize();
 
-    if (toState == FsObj::TRANSFERRED) {
-        drive->wqp->waitCompletion(reqNumber);
-    } else {
-        Server::wqs->waitCompletion(reqNumber);
-    }
+    std::function<void()> finish =
+            [self, replNum, tapeId, fromState, newState, toState, uidList, suspended, retval, next] () {
+                Migration::req_return_t result = retval;
+                time_t steptime;
 
-    if (*suspended == true)
-        retval.suspended = true;
+                jobStateQueue.flush();
 
-    stmt(Migration::SET_JOB_SUCCESS) << toState << reqNumber << newState
-            << tapeId << genInumString(*inumList);
-    TRACE(Trace::normal, stmt.str());
-    steptime = time(NULL);
-    stmt.doall();
-    TRACE(Trace::always, time(NULL) - steptime);
+                if (*suspended == true)
+                result.suspended = true;
 
-    stmt(Migration::RESET_JOB_STATE) << fromState << reqNumber << newState
-            << tapeId;
-    TRACE(Trace::normal, stmt.str());
-    steptime = time(NULL);
-    stmt.doall();
-    TRACE(Trace::always, time(NULL) - steptime);
+                TRACE(Trace::normal, uidList->size());
+                steptime = time(NULL);
+                jobStore->changeState(self->reqNumber, tapeId, replNum, {newState},
+                        toState, *uidList);
+                TRACE(Trace::always, time(NULL) - steptime);
+
+                steptime = time(NULL);
+                jobStore->changeState(self->reqNumber, tapeId, JobStore::NO_REPL,
+                        newState, fromState);
+                TRACE(Trace::always, time(NULL) - steptime);
 
-    return retval;
+                next(result);
+            };
+
+    if (toState == FsObj::TRANSFERRED)
+        SubServer::continueAfter(drive->wqp, reqNumber, finish);
+    else
+        SubServer::continueAfter(Server::wqs, reqNumber, finish);
 }
 
-/**
- *
- * @param replNum
- * @param driveId
- * @param pool
- * @param tapeId
- * @param needsTape
- *
- * @bug needsTape vs. Migration::needsTape
- *
+/*
+ * Continuation after the data transfer: synchronizes the index and
+ * releases the cartridge and the drive before the files are stubbed.
  */
-void Migration::execRequest(int replNum, std::string driveId, std::string pool,
-        std::string tapeId,
-        bool needsTape)
+void Migration::transferred(int replNum, std::string driveId,
+        std::string tapeId, Migration::req_return_t retval)
 
 {
-    TRACE(Trace::full, __PRETTY_FUNCTION__);
-
-    SQLStatement stmt;
-    Migration::req_return_t retval = (Migration::req_return_t ) { false, false };
     bool failed = false;
     int rc;
 
-    mrStatus.add(reqNumber);
-
-    TRACE(Trace::always, reqNumber, needsTape, tapeId);
-
-    if (needsTape) {
-        retval = processFiles(replNum, tapeId, FsObj::RESIDENT,
-                FsObj::TRANSFERRED);
+    try {
+        if ((rc = inventory->getCartridge(tapeId)->get_le()->Sync()) != 0)
+            THROW(Error::GENERAL_ERROR, rc);
+    } catch (const std::exception& e) {
+        TRACE(Trace::error, errno);
+        MSG(LTFSDMS0024E, tapeId);
 
-        try {
-            if ((rc = inventory->getCartridge(tapeId)->get_le()->Sync()) != 0)
-                THROW(Error::GENERAL_ERROR, rc);
-        } catch (const std::exception& e) {
-            TRACE(Trace::error, errno);
-            MSG(LTFSDMS0024E, tapeId);
+        TRACE(Trace::error, reqNumber, tapeId, replNum);
+        jobStore->changeState(reqNumber, tapeId, replNum, FsObj::PREMIGRATED,
+                FsObj::FAILED);
 
-            stmt(Migration::FAIL_PREMIGRATED) << FsObj::FAILED << reqNumber
-                    << FsObj::PREMIGRATED << tapeId << replNum;
+        std::unique_lock<std::mutex> lock(Scheduler::updmtx);
+        TRACE(Trace::error, reqNumber);
+        Scheduler::updReq[reqNumber] = true;
+        Scheduler::updcond.notify_all();
 
-            TRACE(Trace::error, stmt.str());
+        failed = true;
+    }
 
-            stmt.doall();
+    {
+        inventory->update(inventory->getCartridge(tapeId));
 
-            std::unique_lock<std::mutex> lock(Scheduler::updmtx);
-            TRACE(Trace::error, reqNumber);
-            Scheduler::updReq[reqNumber] = true;
-            Scheduler::updcond.notify_all();
+        std::lock_guard<std::recursive_mutex> lock(LTFSDMInventory::mtx);
+        if (inventory->getCartridge(tapeId)->getState()
+                == LTFSDMCartridge::TAPE_INUSE)
+            inventory->getCartridge(tapeId)->setState(
+                    LTFSDMCartridge::TAPE_MOUNTED);
 
-            failed = true;
-        }
+        inventory->getDrive(driveId)->setFree();
+        inventory->getDrive(driveId)->clearToUnblock();
+    }
 
-        {
-            inventory->update(inventory->getCartridge(tapeId));
+    Scheduler::invoke();
 
-            std::lock_guard<std::recursive_mutex> lock(LTFSDMInventory::mtx);
-            if (inventory->getCartridge(tapeId)->getState()
-                    == LTFSDMCartridge::TAPE_INUSE)
-                inventory->getCartridge(tapeId)->setState(
-                        LTFSDMCartridge::TAPE_MOUNTED);
+    changeStates(replNum, tapeId, true, retval, failed);
+}
 
-            inventory->getDrive(driveId)->setFree();
-            inventory->getDrive(driveId)->clearToUnblock();
-        }
+void Migration::changeStates(int replNum, std::string tapeId, bool needsTape,
+        Migration::req_return_t retval, bool failed)
 
-        Scheduler::invoke();
-    }
+{
+    std::shared_ptr<Migration> self = shared_from_this();
+    FsObj::file_state fromState =
+            needsTape ? FsObj::TRANSFERRED : FsObj::PREMIGRATED;
+    std::function<void(Migration::req_return_t)> next =
+            [self, replNum, tapeId, retval] (Migration::req_return_t) {
+                self->complete(replNum, tapeId, retval);
+            };
 
     if (!failed) {
         if (targetState == FsObj::MIGRATED) {
-            if (needsTape)
-                processFiles(replNum, tapeId, FsObj::TRANSFERRED,
-                        FsObj::MIGRATED);
-            else
-                processFiles(replNum, tapeId, FsObj::PREMIGRATED,
-                        FsObj::MIGRATED);
-        } else {
-            if (needsTape)
-                processFiles(replNum, tapeId, FsObj::TRANSFERRED,
-                        FsObj::PREMIGRATED);
+            processFiles(replNum, tapeId, fromState, FsObj::MIGRATED, next);
+            return;
+        } else if (needsTape) {
+            processFiles(replNum, tapeId, fromState, FsObj::PREMIGRATED, next);
+            return;
         }
     }
 
+    complete(replNum, tapeId, retval);
+}
+
+void Migration::complete(int replNum, std::string tapeId,
+        Migration::req_return_t retval)
+
+{
+    SQLStatement stmt;
+
     std::unique_lock<std::mutex> updlock(Scheduler::updmtx);
 
-    if (retval.suspended)
+    if (retval.suspended) {
+        metrics.increment("scheduler", "suspensions");
+        metrics.startTimer("scheduler", "suspend to resume",
+                Scheduler::timerKey(DataBase::MIGRATION, reqNumber, replNum,
+                        tapeId));
         stmt(Migration::UPDATE_REQUEST) << DataBase::REQ_NEW << reqNumber
                 << replNum;
-    else if (retval.remaining)
+    } else if (retval.remaining) {
+        Scheduler::requeued(DataBase::MIGRATION, reqNumber, replNum, "");
         stmt(Migration::UPDATE_REQUEST_RESET_TAPE) << DataBase::REQ_NEW
                 << reqNumber << replNum;
-    else
+    } else
         stmt(Migration::UPDATE_REQUEST) << DataBase::REQ_COMPLETED << reqNumber
                 << replNum;
 
@@ -964,3 +1075,43 @@ void Migration::execRequest(int replNum, std::string driveId, std::string pool,
     if (retval.suspended || retval.remaining)
         Scheduler::invoke();
 }
+
+/**
+ *
+ * @param replNum
+ * @param driveId
+ * @param pool
+ * @param tapeId
+ * @param needsTape
+ *
+ * @bug needsTape vs. Migration::needsTape
+ *
+ * The request is processed by a copy of this object that is owned by a
+ * std::shared_ptr and passed to the continuations (see @ref migration).
+ * Its execution time is recorded when the last continuation completes.
+ */
+void Migration::execRequest(int replNum, std::string driveId, std::string pool,
+        std::string tapeId,
+        bool needsTape)
+
+{
+    TRACE(Trace::full, __PRETTY_FUNCTION__);
+
+    std::shared_ptr<Migration> self = std::make_shared<Migration>(*this);
+
+    self->execTimer = std::make_shared<Metrics::Timer>("scheduler",
+            std::string("exec ") + DataBase::opStr(DataBase::MIGRATION));
+
+    mrStatus.add(reqNumber);
+
+    TRACE(Trace::always, reqNumber, needsTape, tapeId);
+
+    if (needsTape)
+        self->processFiles(replNum, tapeId, FsObj::RESIDENT,
+                FsObj::TRANSFERRED,
+                [self, replNum, driveId, tapeId] (Migration::req_return_t retval) {
+                    self->transferred(replNum, driveId, tapeId, retval);
+                });
+    else
+        self->changeStates(replNum, tapeId, false, { false, false }, false);
+}
@@ -16,7 +16,8 @@
  *******************************************************************************/
 #pragma once
 
-class Migration: public FileOperation
+class Migration: public FileOperation,
+        public std::enable_shared_from_this<Migration>
 {
 private:
     unsigned long pid;
@@ -26,6 +27,7 @@ private:
     int targetState;
     int jobnum;
     bool needsTape = false;
+    std::shared_ptr<Metrics::Timer> execTimer;
 
     struct req_return_t
     {
@@ -35,24 +37,24 @@ private:
 
     FsObj::file_state checkState(std::string fileName, FsObj *fso);
 
-    static const std::string ADD_JOB;
     static const std::string ADD_REQUEST;
-    static const std::string FAIL_PREMIGRATION;
-    static const std::string FAIL_STUBBING;
-    static const std::string SET_TRANSFERRING;
-    static const std::string SET_CHANGE_STATE;
-    static const std::string SELECT_JOBS;
-    static const std::string SET_JOB_SUCCESS;
-    static const std::string RESET_JOB_STATE;
-    static const std::string FAIL_PREMIGRATED;
     static const std::string UPDATE_REQUEST;
     static const std::string UPDATE_REQUEST_RESET_TAPE;
 
     static ThreadPool<Migration, int, std::string, std::string, std::string,
             bool> swq;
 
-    req_return_t processFiles(int replNum, std::string tapeId,
-            FsObj::file_state fromState, FsObj::file_state toState);
+    bool assignJobs(int replNum, std::string tapeId,
+            FsObj::file_state fromState, FsObj::file_state newState,
+            unsigned long freeSpace);
+    void processFiles(int replNum, std::string tapeId,
+            FsObj::file_state fromState, FsObj::file_state toState,
+            std::function<void(req_return_t)> next);
+    void transferred(int replNum, std::string driveId, std::string tapeId,
+            req_return_t retval);
+    void changeStates(int replNum, std::string tapeId, bool needsTape,
+            req_return_t retval, bool failed);
+    void complete(int replNum, std::string tapeId, req_return_t retval);
 public:
     struct mig_info_t
     {
@@ -60,7 +62,8 @@ public:
         int reqNumber;
         int numRepl;
         int replNum;
-        unsigned long inum;
+        fuid_t fuid;
+        unsigned long fileSize;
         std::string poolName;
         FsObj::file_state fromState;
         FsObj::file_state toState;
@@ -69,11 +72,12 @@ public:
 
     static unsigned long transferData(std::string tapeId, std::string driveId,
             long secs, long nsecs, mig_info_t miginfo,
-            std::shared_ptr<std::list<unsigned long>> inumList,
+            std::shared_ptr<std::vector<fuid_t>> uidList,
             std::shared_ptr<bool>);
     static void changeFileState(mig_info_t mig_info,
-            std::shared_ptr<std::list<unsigned long>> inumList,
+            std::shared_ptr<std::vector<fuid_t>> uidList,
             FsObj::file_state toState);
+    static unsigned long tapeSize(unsigned long fileSize);
 
     Migration(unsigned long _pid, long _reqNumber, std::set<std::string> _pools,
             int _numReplica, int _targetState) :
@@ -81,7 +85,8 @@ public:
                     _numReplica), targetState(_targetState), jobnum(0)
     {
     }
-    void addJob(std::string fileName);
+    void prepareJob(std::string fileName, std::vector<JobStore::job_t> *jobs);
+    void addJob(const JobStore::job_t& job);
     void addRequest();
     void execRequest(int replNum, std::string driveId, std::string pool,
             std::string tapeId, bool needsTape);
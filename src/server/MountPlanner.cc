@@ -0,0 +1,257 @@
+/*******************************************************************************
+ * Copyright 2018 IBM Corp. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *******************************************************************************/
+#include "ServerIncludes.h"
+
+/** @page mount_planner Mount planning
+
+    # Mount planning
+
+    Within each scheduler pass (see @ref scheduler) all new requests are
+    read from the REQUEST_QUEUE table at once and handed over to the
+    MountPlanner. Before these requests are evaluated the planner changes
+    the order of them to reduce the number of cartridge moves:
+
+    -# The operation priority is preserved: the requests are still ordered
+       by their operation (see DataBase::operation).
+    -# For the same operation requests for cartridges that already are
+       mounted come first, followed by requests for cartridges that are
+       currently moving, followed by requests for unmounted cartridges.
+    -# Requests that refer to the same cartridge are grouped together.
+    -# Otherwise the order the requests have been added is kept.
+
+    Therefore a cartridge that already is mounted is used as long as there
+    are requests for it and unmounted cartridges are mounted on free drives
+    while data is transferred on the others.
+
+    To bound the time a request for an unmounted cartridge can be
+    overtaken, a request that is waiting for more than
+    Const::MOUNT_PLAN_AGING seconds is ranked like a request for a mounted
+    cartridge. Since the order of the requests added is the order of their
+    arrival it is evaluated ahead of the newer requests and can claim a
+    drive by an unmount or by suspending another operation (see @ref
+    scheduler).
+
+    ## Drive assignment
+
+    After the requests have been ordered the unmounted cartridges they
+    refer to are assigned to the idle drives (MountPlanner::assignDrives)
+    in this order. Cartridges that are mounted or moving already need no
+    robot move. For the others the number of moves depends on the drive
+    only:
+
+    drive | moves
+    ---|---
+    empty | 1 (mount)
+    holds a cartridge not wanted by any pending request | 2 (unmount, mount)
+    holds a cartridge wanted by a pending request | 3 (unmount, mount, and a later mount of the unmounted cartridge)
+
+    Therefore the cartridges are assigned to the empty drives first and
+    then to the drives with cartridges that are not wanted anymore. Drives
+    with wanted cartridges are not assigned, which keeps these cartridges
+    mounted for the requests that will use them. The number of moves of
+    the assignment (MountPlanner::getMoves) is minimal for the given order.
+
+    When the scheduler has to mount a cartridge, either to schedule a
+    request (Scheduler::tapeResAvail) or ahead of time (@ref scheduler,
+    pre-staging), it uses the drive assigned (MountPlanner::getDrive,
+    Scheduler::useAssignedDrive): the cartridge is mounted if the drive is
+    empty or the cartridge within the drive is unmounted first. If the
+    assigned drive is not usable anymore, e.g. since it has been claimed
+    by a request evaluated earlier within the same pass, the scheduler
+    falls back to the first suitable drive. Migrations are not assigned
+    since they can use any cartridge of a tape storage pool.
+
+    If a cartridge needs to be unmounted to free a drive without an
+    assignment the scheduler asks the planner (MountPlanner::isWanted) to
+    prefer a cartridge that is not required by any of the pending
+    requests.
+ */
+
+void MountPlanner::clear()
+
+{
+    requests.clear();
+    wanted.clear();
+    assigned.clear();
+    moves = 0;
+}
+
+void MountPlanner::add(MountPlanner::request_t req)
+
+{
+    if (req.tapeId.compare("") != 0)
+        wanted.insert(req.tapeId);
+
+    req.scheduled = false;
+    requests.push_back(req);
+}
+
+int MountPlanner::mountRank(const MountPlanner::request_t& req, long now)
+
+{
+    std::shared_ptr<LTFSDMCartridge> cart;
+
+    if (req.op == DataBase::MOUNT || req.op == DataBase::MOVE
+            || req.op == DataBase::UNMOUNT || req.tapeId.compare("") == 0)
+        return 0;
+
+    if (now - req.timeAdded >= 1000L * Const::MOUNT_PLAN_AGING) {
+        TRACE(Trace::normal, req.reqNum, req.tapeId, now - req.timeAdded);
+        return 0;
+    }
+
+    if ((cart = inventory->getCartridge(req.tapeId)) == nullptr)
+        return 2;
+
+    switch (cart->getState()) {
+        case LTFSDMCartridge::TAPE_INUSE:
+        case LTFSDMCartridge::TAPE_MOUNTED:
+            return 0;
+        case LTFSDMCartridge::TAPE_MOVING:
+            return 1;
+        default:
+            return 2;
+    }
+}
+
+void MountPlanner::plan()
+
+{
+    struct key_t
+    {
+        DataBase::operation op;
+        int rank;
+        unsigned long group;
+        unsigned long pos;
+    };
+    std::map<std::string, unsigned long> firstPos;
+    std::vector<key_t> keys;
+    std::vector<request_t> planned;
+    long now = DataBase::timeAdded();
+
+    std::lock_guard<std::recursive_mutex> lock(LTFSDMInventory::mtx);
+
+    for (unsigned long i = 0; i < requests.size(); i++) {
+        const request_t& req = requests[i];
+        unsigned long group = i;
+
+        if (req.tapeId.compare("") != 0) {
+            auto it = firstPos.find(req.tapeId);
+            if (it == firstPos.end())
+                firstPos[req.tapeId] = i;
+            else
+                group = it->second;
+        }
+        keys.push_back( { req.op, mountRank(req, now), group, i });
+    }
+
+    std::sort(keys.begin(), keys.end(), [](const key_t& a, const key_t& b) {
+        if (a.op != b.op)
+            return a.op < b.op;
+        if (a.rank != b.rank)
+            return a.rank < b.rank;
+        if (a.group != b.group)
+            return a.group < b.group;
+        return a.pos < b.pos;
+    });
+
+    for (key_t key : keys) {
+        TRACE(Trace::full, key.op, key.rank, requests[key.pos].reqNum,
+                requests[key.pos].tapeId);
+        planned.push_back(requests[key.pos]);
+    }
+
+    requests.swap(planned);
+
+    assignDrives();
+}
+
+/*
+ * Assigns the unmounted cartridges of the requests in the planned order
+ * to the idle drives: empty drives first, then drives with a cartridge
+ * that is not wanted by any pending request.
+ */
+void MountPlanner::assignDrives()
+
+{
+    std::list<std::string> empty;
+    std::list<std::string> replaceable;
+    std::shared_ptr<LTFSDMCartridge> cart;
+    std::shared_ptr<LTFSDMCartridge> loaded;
+
+    for (std::shared_ptr<LTFSDMDrive> drive : inventory->getDrives()) {
+        if (drive->isBusy() || drive->getMoveReqNum() != Const::UNSET)
+            continue;
+        loaded = nullptr;
+        for (std::shared_ptr<LTFSDMCartridge> c : inventory->getCartridges()) {
+            if (drive->get_le()->get_slot() == c->get_le()->get_slot()) {
+                loaded = c;
+                break;
+            }
+        }
+        if (loaded == nullptr)
+            empty.push_back(drive->get_le()->GetObjectID());
+        else if (loaded->getState() == LTFSDMCartridge::TAPE_MOUNTED
+                && isWanted(loaded->get_le()->GetObjectID()) == false)
+            replaceable.push_back(drive->get_le()->GetObjectID());
+    }
+
+    for (const request_t& req : requests) {
+        if (empty.empty() && replaceable.empty())
+            break;
+
+        if (req.op == DataBase::MOUNT || req.op == DataBase::MOVE
+                || req.op == DataBase::UNMOUNT || req.tapeId.compare("") == 0
+                || assigned.count(req.tapeId) != 0)
+            continue;
+
+        if ((cart = inventory->getCartridge(req.tapeId)) == nullptr
+                || cart->getState() != LTFSDMCartridge::TAPE_UNMOUNTED)
+            continue;
+
+        if (empty.empty() == false) {
+            assigned[req.tapeId] = empty.front();
+            empty.pop_front();
+            moves += 1;
+        } else {
+            assigned[req.tapeId] = replaceable.front();
+            replaceable.pop_front();
+            moves += 2;
+        }
+
+        TRACE(Trace::normal, req.tapeId, assigned[req.tapeId]);
+    }
+
+    TRACE(Trace::normal, assigned.size(), moves);
+}
+
+bool MountPlanner::isWanted(std::string tapeId)
+
+{
+    return wanted.count(tapeId) != 0;
+}
+
+std::string MountPlanner::getDrive(std::string tapeId)
+
+{
+    std::map<std::string, std::string>::iterator it = assigned.find(tapeId);
+
+    if (it == assigned.end())
+        return "";
+
+    return it->second;
+}
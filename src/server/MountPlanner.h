@@ -0,0 +1,65 @@
+/*******************************************************************************
+ * Copyright 2018 IBM Corp. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *******************************************************************************/
+#pragma once
+
+class MountPlanner
+{
+public:
+    struct request_t
+    {
+        DataBase::operation op;
+        int reqNum;
+        int tgtState;
+        int numRepl;
+        int replNum;
+        std::string pool;
+        std::string tapeId;
+        std::string driveId;
+        long timeAdded;
+        bool scheduled;
+    };
+private:
+    std::vector<request_t> requests;
+    std::set<std::string> wanted;
+    std::map<std::string, std::string> assigned;
+    int moves;
+
+    int mountRank(const request_t& req, long now);
+    void assignDrives();
+public:
+    MountPlanner() :
+            moves(0)
+    {
+    }
+    void clear();
+    void add(request_t req);
+    void plan();
+    const std::vector<request_t>& getRequests()
+    {
+        return requests;
+    }
+    void setScheduled(unsigned long pos)
+    {
+        requests[pos].scheduled = true;
+    }
+    bool isWanted(std::string tapeId);
+    std::string getDrive(std::string tapeId);
+    int getMoves()
+    {
+        return moves;
+    }
+};
@@ -20,17 +20,38 @@
     that are processing such a message:
 
     - The Receiver listens on a socket and provides the information sent to
-    - a MessageParser object that is evaluating the message in a separate thread.
+    - the MessageParser that is evaluating the message in a separate thread.
 
     For details about parsing client messages see @subpage message_parsing.
 
     The Receiver is started by calling the Receiver::run method. This method
-    is executed within a separate thread and it is listening for messages
-    sent by a client. If a new message is received further processing is
-    performed within another thread to keep the Receiver listening for further
-    messages. For these threads a ThreadPool wqm is available calling
-    MessageParser::run with message specific parameters: the key number,
-    the LTFSDmCommServer command, and a pointer to the Connector.
+    is executed within a separate thread. It does not wait for a single
+    client: the listening socket, all client connections and an eventfd
+    are multiplexed by an epoll instance. The connections are registered
+    with EPOLLONESHOT and only are enabled again if the next message of a
+    client is expected. Messages are read without blocking and are
+    assembled within the MessageParser::session_t of the connection (see
+    LTFSDmComm::recv). The session also keeps the state of a migration or
+    recall request between the messages of a client.
+
+    If a message is complete it is processed by the ThreadPool wqm
+    calling MessageParser::run for this single message. The thread only
+    is occupied while a message is processed. The result
+    (MessageParser::next_action) is passed back to the Receiver that is
+    woken up by the eventfd:
+
+    result | description
+    ---|---
+    MessageParser::WAIT_MESSAGE | the connection waits for the next message of the client
+    MessageParser::WAIT_UPDATE | a status request of a migration or recall request is not responded yet
+    MessageParser::CLOSE | the connection is closed
+
+    Connections that wait for an update are checked every
+    Const::RECEIVER_POLL_INTERVAL milliseconds (see FileOperation::updated)
+    and the status request is processed again if the request has been
+    updated or Const::REQ_STATUS_INTERVAL seconds have passed. Therefore
+    hundreds of clients that follow the progress of their requests do
+    not require a thread each.
 
     @dot
     digraph receiver {
@@ -42,7 +63,10 @@
         listen [fontname="courier bold", fontcolor=dodgerblue4, label="command.listen", URL="@ref LTFSDmCommServer::listen"];
         subgraph cluster_loop {
             label="while not terminated"
-            accept [fontname="courier bold", fontcolor=dodgerblue4, label="command.accept", URL="@ref LTFSDmCommServer::accept"];
+            wait [label="epoll_wait"];
+            accept [fontname="courier bold", fontcolor=dodgerblue4, label="Receiver::accept", URL="@ref Receiver::accept"];
+            receive [fontname="courier bold", fontcolor=dodgerblue4, label="Receiver::receive", URL="@ref Receiver::receive"];
+            complete [fontname="courier bold", fontcolor=dodgerblue4, label="Receiver::complete", URL="@ref Receiver::complete"];
             subgraph cluster_thread_pool {
                 fontname="courier bold";
                 fontcolor=dodgerblue4;
@@ -51,28 +75,206 @@
                 wqm [label="...|...|<mpo> MessageParser::run|...|..."];
             }
         }
-        listen -> accept [lhead=cluster_loop, minlen=2];
-        accept -> wqm:mpo[fontname="courier bold", fontsize=8, fontcolor=dodgerblue4, label="wqm.enqueue", URL="@ref ThreadPool::enqueue"];
+        listen -> wait [lhead=cluster_loop, minlen=2];
+        wait -> accept [fontsize=8, label="listening socket"];
+        wait -> receive [fontsize=8, label="connection"];
+        wait -> complete [fontsize=8, label="eventfd"];
+        receive -> wqm:mpo [fontname="courier bold", fontsize=8, fontcolor=dodgerblue4, label="wqm.enqueue", URL="@ref ThreadPool::enqueue"];
+        wqm:mpo -> complete [style=dashed, fontsize=8, label="result"];
     }
     @enddot
 
+    If the backend is stopped the Receiver continues until all
+    connections of status requests are closed such that the clients are
+    informed about the end of their requests.
  */
 
 #include "ServerIncludes.h"
 
 std::atomic<long> globalReqNumber;
 
-void Receiver::run(long key, std::shared_ptr<Connector> connector)
+void Receiver::accept(int listenFd)
+
+{
+    struct epoll_event event;
+    int fd;
+
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN | EPOLLONESHOT;
+
+    while ((fd = accept4(listenFd, NULL, NULL, SOCK_CLOEXEC)) != -1) {
+        event.data.fd = fd;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) == -1) {
+            TRACE(Trace::error, errno);
+            ::close(fd);
+            continue;
+        }
+        sessions[fd] = std::make_shared<MessageParser::session_t>(fd);
+    }
+
+    if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        TRACE(Trace::error, errno);
+        MSG(LTFSDMS0005E);
+    }
+}
+
+/*
+ * Reads the data available for a session. If the message is incomplete
+ * the connection is enabled again within the epoll instance.
+ */
+void Receiver::receive(session_ptr session)
+
+{
+    struct epoll_event event;
+    bool complete;
+
+    try {
+        complete = session->command.recv(&session->buffer);
+    } catch (const std::exception& e) {
+        TRACE(Trace::error, e.what());
+        MSG(LTFSDMS0006E);
+        MessageParser::cleanup(session.get());
+        release(session);
+        return;
+    }
+
+    if (complete) {
+        dispatch(session);
+        return;
+    }
+
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN | EPOLLONESHOT;
+    event.data.fd = session->command.getAccFd();
+
+    if (epoll_ctl(epollFd, EPOLL_CTL_MOD, event.data.fd, &event) == -1) {
+        TRACE(Trace::error, errno);
+        MessageParser::cleanup(session.get());
+        release(session);
+    }
+}
+
+void Receiver::dispatch(session_ptr session)
+
+{
+    try {
+        wqm->enqueue(Const::UNSET, this, session);
+    } catch (const std::exception& e) {
+        TRACE(Trace::error, e.what());
+        MSG(LTFSDMS0010E);
+        MessageParser::cleanup(session.get());
+        release(session);
+    }
+}
+
+void Receiver::release(session_ptr session)
+
+{
+    int fd = session->command.getAccFd();
+
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, NULL);
+    sessions.erase(fd);
+    session->command.closeAcc();
+}
+
+/*
+ * Executed by the ThreadPool wqm. The session is passed back to the
+ * Receiver thread that is the only one to modify the epoll instance.
+ */
+void Receiver::process(session_ptr session)
+
+{
+    MessageParser::next_action action;
+    uint64_t one = 1;
+
+    try {
+        action = MessageParser::run(key, session.get(), connector);
+    } catch (const std::exception& e) {
+        TRACE(Trace::error, e.what());
+        MessageParser::cleanup(session.get());
+        action = MessageParser::CLOSE;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        finished.push_back(std::make_pair(session, action));
+    }
+
+    if (write(wakeFd, &one, sizeof(one)) == -1)
+        TRACE(Trace::error, errno);
+}
+
+void Receiver::complete()
 
 {
-    MessageParser mproc;
-    std::unique_lock<std::mutex> lock(Server::termmtx);
-    ThreadPool<long, LTFSDmCommServer, std::shared_ptr<Connector>> wqm(
-            &MessageParser::run, Const::MAX_RECEIVER_THREADS, "msg-wq");
+    std::list<std::pair<session_ptr, MessageParser::next_action>> done;
+    uint64_t num;
+
+    if (::read(wakeFd, &num, sizeof(num)) == -1 && errno != EAGAIN)
+        TRACE(Trace::error, errno);
+
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        done.swap(finished);
+    }
+
+    for (std::pair<session_ptr, MessageParser::next_action>& entry : done) {
+        switch (entry.second) {
+            case MessageParser::WAIT_MESSAGE:
+                receive(entry.first);
+                break;
+            case MessageParser::WAIT_UPDATE:
+                waiting.push_back(entry.first);
+                break;
+            default:
+                release(entry.first);
+        }
+    }
+}
+
+void Receiver::checkWaiting()
+
+{
+    std::list<session_ptr>::iterator it = waiting.begin();
+
+    while (it != waiting.end()) {
+        if (FileOperation::updated((*it)->requestNumber)
+                || time(NULL) - (*it)->statusTime
+                        >= Const::REQ_STATUS_INTERVAL) {
+            dispatch(*it);
+            it = waiting.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+bool Receiver::statusPending()
+
+{
+    for (std::pair<const int, session_ptr>& session : sessions)
+        if (session.second->state == MessageParser::REQ_STATUS)
+            return true;
+
+    return false;
+}
+
+void Receiver::run(long key_, std::shared_ptr<Connector> connector_)
+
+{
+    ThreadPool<Receiver *, session_ptr> wq(&Receiver::process,
+            Const::MAX_RECEIVER_THREADS, "msg-wq",
+            Const::THREAD_POOL_QUEUE_SIZE, Executor::HIGH, false);
     LTFSDmCommServer command(Const::CLIENT_SOCKET_FILE);
+    struct epoll_event events[Const::RECEIVER_EVENTS_PER_WAIT];
+    struct epoll_event event;
+    int num;
 
     TRACE(Trace::full, __PRETTY_FUNCTION__);
 
+    key = key_;
+    connector = connector_;
+    wqm = &wq;
     globalReqNumber = 0;
 
     try {
@@ -83,34 +285,73 @@ void Receiver::run(long key, std::shared_ptr<Connector> connector)
         THROW(Error::GENERAL_ERROR);
     }
 
-    while (Server::finishTerminate == false) {
-        try {
-            command.accept();
-        } catch (const std::exception& e) {
-            TRACE(Trace::error, e.what());
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+
+    if (fcntl(command.getRefFd(), F_SETFL, O_NONBLOCK) == -1
+            || (epollFd = epoll_create1(EPOLL_CLOEXEC)) == -1
+            || (wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) == -1) {
+        TRACE(Trace::error, errno);
+        MSG(LTFSDMS0004E);
+        THROW(Error::GENERAL_ERROR, errno);
+    }
+
+    for (int fd : { command.getRefFd(), wakeFd }) {
+        event.data.fd = fd;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) == -1) {
+            TRACE(Trace::error, fd, errno);
+            MSG(LTFSDMS0004E);
+            THROW(Error::GENERAL_ERROR, errno);
+        }
+    }
+
+    while (Server::finishTerminate == false || statusPending()) {
+        if ((num = epoll_wait(epollFd, events, Const::RECEIVER_EVENTS_PER_WAIT,
+                waiting.size() > 0 ? Const::RECEIVER_POLL_INTERVAL : -1))
+                == -1) {
+            if (errno == EINTR)
+                continue;
+            TRACE(Trace::error, errno);
             MSG(LTFSDMS0005E);
             break;
         }
 
-        try {
-            wqm.enqueue(Const::UNSET, key, command, connector);
-        } catch (const std::exception& e) {
-            TRACE(Trace::error, e.what());
-            MSG(LTFSDMS0010E);
-            continue;
+        for (int i = 0; i < num; i++) {
+            if (events[i].data.fd == command.getRefFd()) {
+                accept(events[i].data.fd);
+            } else if (events[i].data.fd == wakeFd) {
+                complete();
+            } else {
+                std::map<int, session_ptr>::iterator it = sessions.find(
+                        events[i].data.fd);
+                if (it != sessions.end())
+                    receive(it->second);
+            }
         }
 
-        if (Server::finishTerminate == false)
-            Server::termcond.wait_for(lock, std::chrono::seconds(30));
+        checkWaiting();
     }
 
     MSG(LTFSDMS0075I);
 
-    TRACE(Trace::always, (bool) Server::finishTerminate);
+    TRACE(Trace::always, (bool) Server::finishTerminate, sessions.size());
+
+    wq.waitCompletion(Const::UNSET);
 
-    lock.unlock();
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        finished.clear();
+    }
+    waiting.clear();
+
+    while (sessions.size() > 0) {
+        MessageParser::cleanup(sessions.begin()->second.get());
+        release(sessions.begin()->second);
+    }
 
-    wqm.waitCompletion(Const::UNSET);
+    wqm = nullptr;
+    ::close(wakeFd);
+    ::close(epollFd);
 
     command.closeRef();
 
@@ -21,8 +21,31 @@ extern std::atomic<long> globalReqNumber;
 class Receiver
 
 {
+private:
+    typedef std::shared_ptr<MessageParser::session_t> session_ptr;
+
+    long key;
+    std::shared_ptr<Connector> connector;
+    int epollFd;
+    int wakeFd;
+    std::map<int, session_ptr> sessions;
+    std::list<session_ptr> waiting;
+    std::mutex mtx;
+    std::list<std::pair<session_ptr, MessageParser::next_action>> finished;
+    ThreadPool<Receiver *, session_ptr> *wqm;
+
+    void accept(int listenFd);
+    void receive(session_ptr session);
+    void dispatch(session_ptr session);
+    void release(session_ptr session);
+    void process(session_ptr session);
+    void complete();
+    void checkWaiting();
+    bool statusPending();
 public:
-    Receiver()
+    Receiver() :
+            key(Const::UNSET), epollFd(Const::UNSET), wakeFd(Const::UNSET), wqm(
+                    nullptr)
     {
     }
     ~Receiver()
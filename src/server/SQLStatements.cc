@@ -36,17 +36,19 @@
     For each request one or more files can be processed. For each
     file one jobs is created (for migration up to three jobs
     depending on the number of tape storage pools being specified).
-    Jobs are stored within the SQlite table JOB_QUEUE.
+    Jobs are stored within the SQlite table JOB_QUEUE if the
+    SQLiteJobStore is used (see @ref job_store).
 
     ## JOB_QUEUE
 
     column | data type | details
     ---|---|---
     OPERATION | INT | operation: see DataBase::operation
-    FILE_NAME | CHAR(4096) | file name
+    DIR_ID | INT | directory of the file: see JOB_DIRECTORIES, NULL if the file name is unknown
+    LEAF_NAME | VARCHAR | file name without its directory
     REQ_NUM | INT | for each new request incremented by one
     TARGET_STATE | INT | target state for migration and recall: FsObj::state
-    REPL_NUM | INT | 0, for migration 0,1,2 depending of the number of tape storage pools
+    REPL_NUM | INT | 0, for migration 0,1,2 depending of the number of tape storage pools, NULL for selective recall
     TAPE_POOL | VARCHAR | name of the tape storage pool
     FILE_SIZE | BIGINT | file size
     FS_ID_H | BIGINT | higher 64 bit part of the 128 bit file system id
@@ -61,6 +63,23 @@
     START_BLOCK | INT | starting block of the data on tape of a (pre)migrated file
     CONN_INFO | BIGINT | address of connector specific information
 
+    ## JOB_DIRECTORIES
+
+    column | data type | details
+    ---|---|---
+    DIR_ID | INTEGER | row id
+    DIR_NAME | VARCHAR | directory name including the trailing slash
+
+    The jobs of a directory tree share long path prefixes and for
+    migration each file name is stored once per replica. Therefore
+    JOB_QUEUE only contains the last part of the file name and a
+    reference to the directory that is stored once within
+    JOB_DIRECTORIES. The file name is reconstructed by the statements
+    that read the jobs (DIR_NAME || LEAF_NAME). The SQLiteJobStore
+    caches the directory ids (see SQLiteJobStore::dirId). Directories
+    are not removed while the backend is running, the table is created
+    new with the database.
+
     ## REQUEST_QUEUE
 
     column | data type | details
@@ -73,17 +92,97 @@
     TAPE_POOL | VARCHAR | name of the tape storage pool
     TAPE_ID | CHAR(9) | id of the cartridge that is being used
     DRIVE_ID | VARCHAR | id of the drive that is being used mount or unmount requests
-    TIME_ADDED | INT | time the request has been added (need to check if really used)
+    TIME_ADDED | INT | time the request has been added in milliseconds, see DataBase::timeAdded
     STATE | INT | request state, see DataBase::req_state
 
+    ## Indexes
+
+    Beside the indexes for the unique constraints the following
+    indexes are created:
+
+    index | columns | used for
+    ---|---|---
+    JOB_QUEUE_STATE | REQ_NUM, FILE_STATE, TAPE_ID, REPL_NUM | selecting and updating the jobs of a request, request status
+    JOB_QUEUE_BLOCK | REQ_NUM, TAPE_ID, START_BLOCK | selecting recall jobs in the order of their position on tape
+    REQUEST_QUEUE_STATE | STATE, OPERATION, TIME_ADDED | selecting new requests by the Scheduler
+
+    The script test/queryplan.py runs EXPLAIN QUERY PLAN for all
+    statements within this file and fails if a statement that is
+    not expected to read a whole table performs a full table scan.
+
+    ## Statement cache
+
+    Most of the statements for the REQUEST_QUEUE table are formatted
+    with the values of the current operation and prepared each time
+    they are executed. The statements of the SQLiteJobStore use SQLite
+    parameters (?1, ?2, ...) instead. These are used with
+    SQLStatement::cached: the statement is prepared only once per thread
+    and the values are bound in the order they are passed with
+    operator<< or by SQLStatement::bind. Strings are bound with the same
+    encoding as the formatted statements use. A parameter that is
+    compared in the form "(?N OR COLUMN=?M)" is set to true if the
+    corresponding column should not be evaluated, e.g. to select the
+    jobs of all replicas.
+
+    ## Statement profiling
+
+    If the backend is started with option -p the following values are
+    recorded per statement template, i.e. per string within this file
+    independently of the values it is formatted with or bound to:
+
+    value | description
+    ---|---
+    executions | number of executions, an execution ends when the statement is finalized or reset
+    prepares | number of times the statement has been prepared (once per thread for cached statements)
+    prepare time | time to format and to prepare the statement
+    step time | time within sqlite3_step
+    lock wait time | time waiting for the connection mutex if it is shared by all threads, for BEGIN_TRANSACTION the time waiting for DataBase::trans_mutex, for COMMIT_TRANSACTION the time waiting for busy retries
+    rows | number of rows returned
+    changes | number of rows inserted, updated, or deleted
+
+    Times are recorded in nanoseconds. The values can be listed by
+    @ref ltfsdm_info_sql "ltfsdm info sql".
+
  */
 
 /* ======== DataBase ======== */
 
-const std::string DataBase::CREATE_JOB_QUEUE =
+const std::string DataBase::CREATE_REQUEST_QUEUE =
+        "CREATE TABLE REQUEST_QUEUE("
+                " OPERATION INT NOT NULL,"
+                " REQ_NUM INT NOT NULL,"
+                " TARGET_STATE INT,"
+                " NUM_REPL,"
+                " REPL_NUM INT,"
+                " TAPE_POOL VARCHAR,"
+                " TAPE_ID CHAR(9),"
+                " DRIVE_ID VARCHAR,"
+                " TIME_ADDED INT NOT NULL,"
+                " STATE INT NOT NULL,"
+                " CONSTRAINT REQUEST_QUEUE_UNIQUE UNIQUE(REQ_NUM, REPL_NUM, TAPE_POOL, TAPE_ID))";
+
+const std::string DataBase::CREATE_REQUEST_QUEUE_STATE_INDEX =
+        "CREATE INDEX REQUEST_QUEUE_STATE ON REQUEST_QUEUE("
+                " STATE, OPERATION, TIME_ADDED)";
+
+const std::string DataBase::BEGIN_TRANSACTION = "BEGIN IMMEDIATE TRANSACTION";
+
+const std::string DataBase::COMMIT_TRANSACTION = "COMMIT TRANSACTION";
+
+const std::string DataBase::ROLLBACK_TRANSACTION = "ROLLBACK TRANSACTION";
+
+/* ======== SQLiteJobStore ======== */
+
+const std::string SQLiteJobStore::CREATE_JOB_DIRECTORIES =
+        "CREATE TABLE JOB_DIRECTORIES("
+                " DIR_ID INTEGER PRIMARY KEY,"
+                " DIR_NAME VARCHAR NOT NULL UNIQUE)";
+
+const std::string SQLiteJobStore::CREATE_JOB_QUEUE =
         "CREATE TABLE JOB_QUEUE("
                 " OPERATION INT NOT NULL,"
-                " FILE_NAME CHAR(4096),"
+                " DIR_ID INT,"
+                " LEAF_NAME VARCHAR,"
                 " REQ_NUM INT NOT NULL,"
                 " TARGET_STATE INT NOT NULL,"
                 " REPL_NUM INT,"
@@ -100,28 +199,118 @@ const std::string DataBase::CREATE_JOB_QUEUE =
                 " FILE_STATE INT NOT NULL,"
                 " START_BLOCK INT,"
                 " CONN_INFO BIGINT,"
-                " CONSTRAINT JOB_QUEUE_UNIQUE_FILE_NAME UNIQUE (FILE_NAME, REPL_NUM),"
+                " CONSTRAINT JOB_QUEUE_UNIQUE_FILE_NAME UNIQUE (DIR_ID, LEAF_NAME, REPL_NUM),"
                 " CONSTRAINT JOB_QUEUE_UNIQUE_UID UNIQUE (FS_ID_H, FS_ID_L, I_GEN, I_NUM, REPL_NUM))";
 
-const std::string DataBase::CREATE_REQUEST_QUEUE =
-        "CREATE TABLE REQUEST_QUEUE("
-                " OPERATION INT NOT NULL,"
-                " REQ_NUM INT NOT NULL,"
-                " TARGET_STATE INT,"
-                " NUM_REPL,"
-                " REPL_NUM INT,"
-                " TAPE_POOL VARCHAR,"
-                " TAPE_ID CHAR(9),"
-                " DRIVE_ID VARCHAR,"
-                " TIME_ADDED INT NOT NULL,"
-                " STATE INT NOT NULL,"
-                " CONSTRAINT REQUEST_QUEUE_UNIQUE UNIQUE(REQ_NUM, REPL_NUM, TAPE_POOL, TAPE_ID))";
+const std::string SQLiteJobStore::CREATE_JOB_QUEUE_STATE_INDEX =
+        "CREATE INDEX JOB_QUEUE_STATE ON JOB_QUEUE("
+                " REQ_NUM, FILE_STATE, TAPE_ID, REPL_NUM)";
+
+const std::string SQLiteJobStore::CREATE_JOB_QUEUE_BLOCK_INDEX =
+        "CREATE INDEX JOB_QUEUE_BLOCK ON JOB_QUEUE("
+                " REQ_NUM, TAPE_ID, START_BLOCK)";
+
+const std::string SQLiteJobStore::ADD_DIRECTORY =
+        "INSERT OR IGNORE INTO JOB_DIRECTORIES (DIR_NAME) VALUES (?1)";
+
+const std::string SQLiteJobStore::GET_DIRECTORY =
+        "SELECT DIR_ID FROM JOB_DIRECTORIES WHERE DIR_NAME=?1";
+
+const std::string SQLiteJobStore::ADD_JOB =
+        "INSERT INTO JOB_QUEUE (OPERATION, DIR_ID, LEAF_NAME, REQ_NUM, TARGET_STATE, REPL_NUM,"
+                " TAPE_POOL, FILE_SIZE, FS_ID_H, FS_ID_L, I_GEN, I_NUM, MTIME_SEC, MTIME_NSEC, LAST_UPD,"
+                " TAPE_ID, FILE_STATE, START_BLOCK, CONN_INFO)"
+                " VALUES (" /* OPERATION */"?1, " /* DIR_ID */"?2, " /* LEAF_NAME */"?3, "
+                /* REQ_NUM */"?4, " /* TARGET_STATE */"?5, " /* REPL_NUM */"?6, " /* TAPE_POOL */"?7, "
+                /* FILE_SIZE */"?8, " /* FS_ID_H */"?9, " /* FS_ID_L */"?10, " /* I_GEN */"?11, "
+                /* I_NUM */"?12, " /* MTIME_SEC */"?13, " /* MTIME_NSEC */"?14, " /* LAST_UPD */"?15, "
+                /* TAPE_ID */"?16, " /* FILE_STATE */"?17, " /* START_BLOCK */"?18, " /* CONN_INFO */"?19)";
+
+const std::string SQLiteJobStore::FAIL_JOB =
+        "UPDATE JOB_QUEUE SET FILE_STATE=?1"
+                " WHERE DIR_ID=?2"
+                " AND LEAF_NAME=?3"
+                " AND REQ_NUM=?4"
+                " AND (?5 OR REPL_NUM=?6)";
+
+const std::string SQLiteJobStore::SELECT_PENDING =
+        "SELECT ROWID, FILE_SIZE FROM JOB_QUEUE"
+                " WHERE REQ_NUM=?1"
+                " AND FILE_STATE=?2"
+                " AND REPL_NUM=?3";
+
+const std::string SQLiteJobStore::ASSIGN_JOB =
+        "UPDATE JOB_QUEUE SET FILE_STATE=?1,"
+                " TAPE_ID=?2"
+                " WHERE REQ_NUM=?3"
+                " AND ROWID=?4";
+
+const std::string SQLiteJobStore::CHANGE_STATE =
+        "UPDATE JOB_QUEUE SET FILE_STATE=?1"
+                " WHERE REQ_NUM=?2"
+                " AND FILE_STATE=?3"
+                " AND TAPE_ID=?4"
+                " AND (?5 OR REPL_NUM=?6)";
+
+const std::string SQLiteJobStore::SET_JOB_STATE =
+        "UPDATE JOB_QUEUE SET FILE_STATE=?1"
+                " WHERE REQ_NUM=?2"
+                " AND TAPE_ID=?3"
+                " AND (FILE_STATE=?4 OR FILE_STATE=?5)"
+                " AND (?6 OR REPL_NUM=?7)"
+                " AND FS_ID_H=?8 AND FS_ID_L=?9 AND I_GEN=?10 AND I_NUM=?11";
+
+//! [select_jobs_sql_qry]
+const std::string SQLiteJobStore::SELECT_JOBS =
+        "SELECT OPERATION, DIR_NAME || LEAF_NAME, REQ_NUM, TARGET_STATE, REPL_NUM, TAPE_POOL,"
+                " FILE_SIZE, FS_ID_H, FS_ID_L, I_GEN, I_NUM, MTIME_SEC, MTIME_NSEC, LAST_UPD, TAPE_ID,"
+                " FILE_STATE, START_BLOCK, CONN_INFO FROM JOB_QUEUE"
+                " LEFT JOIN JOB_DIRECTORIES ON JOB_DIRECTORIES.DIR_ID=JOB_QUEUE.DIR_ID"
+                " WHERE REQ_NUM=?1"
+                " AND TAPE_ID=?2"
+                " AND (FILE_STATE=?3 OR FILE_STATE=?4)"
+                " ORDER BY START_BLOCK LIMIT ?5";
+//! [select_jobs_sql_qry]
+
+const std::string SQLiteJobStore::ALL_JOBS =
+        "SELECT OPERATION, DIR_NAME || LEAF_NAME, REQ_NUM, TARGET_STATE, REPL_NUM, TAPE_POOL,"
+                " FILE_SIZE, FS_ID_H, FS_ID_L, I_GEN, I_NUM, MTIME_SEC, MTIME_NSEC, LAST_UPD, TAPE_ID,"
+                " FILE_STATE, START_BLOCK, CONN_INFO FROM JOB_QUEUE"
+                " LEFT JOIN JOB_DIRECTORIES ON JOB_DIRECTORIES.DIR_ID=JOB_QUEUE.DIR_ID";
+
+const std::string SQLiteJobStore::REQUEST_JOBS =
+        "SELECT OPERATION, DIR_NAME || LEAF_NAME, REQ_NUM, TARGET_STATE, REPL_NUM, TAPE_POOL,"
+                " FILE_SIZE, FS_ID_H, FS_ID_L, I_GEN, I_NUM, MTIME_SEC, MTIME_NSEC, LAST_UPD, TAPE_ID,"
+                " FILE_STATE, START_BLOCK, CONN_INFO FROM JOB_QUEUE"
+                " LEFT JOIN JOB_DIRECTORIES ON JOB_DIRECTORIES.DIR_ID=JOB_QUEUE.DIR_ID"
+                " WHERE REQ_NUM=?1";
+
+const std::string SQLiteJobStore::COUNT_STATES =
+        "SELECT FILE_STATE, COUNT(*) FROM JOB_QUEUE WHERE REQ_NUM=?1"
+                " GROUP BY FILE_STATE";
+
+const std::string SQLiteJobStore::COUNT_JOBS =
+        "SELECT COUNT(*) FROM JOB_QUEUE WHERE REQ_NUM=?1"
+                " AND TAPE_ID=?2";
+
+const std::string SQLiteJobStore::GET_TAPES =
+        "SELECT TAPE_ID FROM JOB_QUEUE WHERE REQ_NUM=?1"
+                " GROUP BY TAPE_ID";
+
+const std::string SQLiteJobStore::DELETE_REQUEST_JOBS =
+        "DELETE FROM JOB_QUEUE WHERE REQ_NUM=?1";
+
+const std::string SQLiteJobStore::DELETE_JOBS =
+        "DELETE FROM JOB_QUEUE"
+                " WHERE REQ_NUM=?1"
+                " AND TAPE_ID=?2"
+                " AND (FILE_STATE=?3 OR FILE_STATE=?4)";
 
 /* ======== Scheduler ======== */
 
 const std::string Scheduler::SELECT_REQUEST =
         "SELECT OPERATION, REQ_NUM, TARGET_STATE, NUM_REPL,"
-                " REPL_NUM, TAPE_POOL, TAPE_ID, DRIVE_ID"
+                " REPL_NUM, TAPE_POOL, TAPE_ID, DRIVE_ID, TIME_ADDED"
                 " FROM REQUEST_QUEUE WHERE STATE=%1%"
                 " ORDER BY OPERATION,TIME_ADDED ASC";
 
@@ -140,23 +329,8 @@ const std::string Scheduler::UPDATE_REC_REQUEST =
                 " WHERE REQ_NUM=%2%"
                 " AND TAPE_ID='%3%'";
 
-const std::string Scheduler::SMALLEST_MIG_JOB =
-        "SELECT MIN(FILE_SIZE) FROM JOB_QUEUE WHERE"
-                " REQ_NUM=%1%"
-                " AND FILE_STATE=%2%"
-                " AND REPL_NUM=%3%";
-
 /* ======== Migration ======== */
 
-const std::string Migration::ADD_JOB =
-        "INSERT INTO JOB_QUEUE (OPERATION, FILE_NAME, REQ_NUM, TARGET_STATE, REPL_NUM, TAPE_POOL,"
-                " FILE_SIZE, FS_ID_H, FS_ID_L, I_GEN, I_NUM, MTIME_SEC, MTIME_NSEC, LAST_UPD, TAPE_ID, FILE_STATE)"
-                " VALUES (" /* OPERATION */"%1%, " /* FILE_NAME */"'%2%', " /* REQ_NUM */"%3%, "
-                /* TARGET_STATE */"%4%, " /* REPL_NUM */"?, " /* TAPE_POOL */"?, "
-                /* FILE_SIZE */"%5%, " /* FS_ID_H */"%6%, " /* FS_ID_L */"%7%, " /* I_GEN */"%8%,"
-                /* I_NUM */"%9%, "/* MTIME_SEC */"%10%, " /* MTIME_NSEC */"%11%, " /* LAST_UPD */"%12%, "
-                /* TAPE_ID */"'', " /* FILE_STATE */"%13%)";
-
 const std::string Migration::ADD_REQUEST =
         "INSERT INTO REQUEST_QUEUE (OPERATION, REQ_NUM, TARGET_STATE,"
                 " NUM_REPL, REPL_NUM, TAPE_POOL, TAPE_ID, TIME_ADDED, STATE)"
@@ -164,58 +338,6 @@ const std::string Migration::ADD_REQUEST =
                 /* NUM_REPL */"%4%, " /* REPL_NUM */"%5%, " /* TAPE_POOL */"'%6%', "
                 /* TAPE_ID */"'', " /* TIME_ADDED */"%7%, " /* STATE */"%8%);";
 
-const std::string Migration::FAIL_PREMIGRATION =
-        "UPDATE JOB_QUEUE SET FILE_STATE=%1%"
-                " WHERE REQ_NUM=%2%"
-                " AND FILE_NAME='%3%'"
-                " AND REPL_NUM=%4%";
-
-const std::string Migration::FAIL_STUBBING =
-        "UPDATE JOB_QUEUE SET FILE_STATE=%1%"
-                " WHERE REQ_NUM=%2%"
-                " AND FILE_NAME='%3%'";
-
-const std::string Migration::SET_TRANSFERRING =
-        "UPDATE JOB_QUEUE SET FILE_STATE=%1%,"
-                " TAPE_ID='%2%'"
-                " WHERE REQ_NUM=%3%"
-                " AND FILE_STATE=%4%"
-                " AND REPL_NUM=%5%"
-                " AND FITS(I_NUM, FILE_SIZE, %6%, %7%, %8%)=1";
-
-const std::string Migration::SET_CHANGE_STATE =
-        "UPDATE JOB_QUEUE SET FILE_STATE=%1%"
-                " WHERE REQ_NUM=%2%"
-                " AND FILE_STATE=%3%"
-                " AND TAPE_ID='%4%'"
-                " AND REPL_NUM=%5%";
-
-const std::string Migration::SELECT_JOBS =
-        "SELECT FILE_NAME, MTIME_SEC, MTIME_NSEC, I_NUM FROM JOB_QUEUE WHERE"
-                " REQ_NUM=%1%"
-                " AND FILE_STATE=%2%"
-                " AND TAPE_ID='%3%'";
-
-const std::string Migration::SET_JOB_SUCCESS =
-        "UPDATE JOB_QUEUE SET FILE_STATE=%1%"
-                " WHERE REQ_NUM=%2%"
-                " AND FILE_STATE=%3%"
-                " AND TAPE_ID='%4%'"
-                " AND I_NUM IN (%5%)";
-
-const std::string Migration::RESET_JOB_STATE =
-        "UPDATE JOB_QUEUE SET FILE_STATE=%1%"
-                " WHERE REQ_NUM=%2%"
-                " AND FILE_STATE=%3%"
-                " AND TAPE_ID='%4%'";
-
-const std::string Migration::FAIL_PREMIGRATED =
-        "UPDATE JOB_QUEUE SET FILE_STATE=%1%"
-                " WHERE REQ_NUM=%2%"
-                " AND FILE_STATE=%3%"
-                " AND TAPE_ID='%4%'"
-                " AND REPL_NUM=%5%";
-
 const std::string Migration::UPDATE_REQUEST =
         "UPDATE REQUEST_QUEUE SET STATE=%1%"
                 " WHERE REQ_NUM=%2%"
@@ -228,55 +350,11 @@ const std::string Migration::UPDATE_REQUEST_RESET_TAPE =
 
 /* ======== SelRecall ======== */
 
-const std::string SelRecall::ADD_JOB =
-        "INSERT INTO JOB_QUEUE (OPERATION, FILE_NAME, REQ_NUM, TARGET_STATE, FILE_SIZE, FS_ID_H, FS_ID_L, I_GEN,"
-                " I_NUM, MTIME_SEC, MTIME_NSEC, LAST_UPD, FILE_STATE, TAPE_ID, START_BLOCK)"
-                " VALUES (" /* OPERATION */"%1%, " /* FILE_NAME */"'%2%', " /* REQ_NUM */"%3%, "
-                /* TARGET_STATE */"%4%, " /* FILE_SIZE */"%5%, " /* FS_ID_H */"%6%, " /* FS_ID_L */"%7%, "
-                /* I_GEN */"%8%, " /* I_NUM */"%9%, " /* MTIME_SEC */"%10%, " /* MTIME_NSEC */"%11%, "
-                /* LAST_UPD */"%12%, " /* FILE_STATE */"%13%, " /* TAPE_ID */"'%14%', " /* START_BLOCK */"%15%)";
-
-const std::string SelRecall::GET_TAPES =
-        "SELECT TAPE_ID FROM JOB_QUEUE WHERE REQ_NUM=%1%"
-                " GROUP BY TAPE_ID";
-
 const std::string SelRecall::ADD_REQUEST =
         "INSERT INTO REQUEST_QUEUE (OPERATION, REQ_NUM, TARGET_STATE, TAPE_ID, TIME_ADDED, STATE)"
                 " VALUES (" /* OPERATION */"%1%, " /* REQ_NUM */"%2%, " /* TARGET_STATE */"%3%, "
                 /* TAPE_ID */"'%4%', " /* TIME_ADDED */"%5%, " /* STATE */"%6%)";
 
-const std::string SelRecall::SET_RECALLING =
-        "UPDATE JOB_QUEUE SET FILE_STATE=%1%"
-                " WHERE REQ_NUM=%2%"
-                " AND FILE_STATE=%3%"
-                " AND TAPE_ID='%4%'";
-
-//! [sel_recall_sql_qry]
-const std::string SelRecall::SELECT_JOBS =
-        "SELECT FILE_NAME, FILE_STATE, I_NUM FROM JOB_QUEUE WHERE REQ_NUM=%1%"
-                " AND TAPE_ID='%2%'"
-                " AND (FILE_STATE=%3% OR FILE_STATE=%4%)"
-                " ORDER BY START_BLOCK";
-//! [sel_recall_sql_qry]
-
-const std::string SelRecall::FAIL_JOB = "UPDATE JOB_QUEUE SET FILE_STATE = %1%"
-        " WHERE FILE_NAME='%2%'"
-        " AND REQ_NUM=%3%"
-        " AND TAPE_ID='%4%'";
-
-const std::string SelRecall::SET_JOB_SUCCESS =
-        "UPDATE JOB_QUEUE SET FILE_STATE = %1%"
-                " WHERE REQ_NUM=%2%"
-                " AND TAPE_ID='%3%'"
-                " AND (FILE_STATE=%4% OR FILE_STATE=%5%)"
-                " AND I_NUM IN (%6%)";
-
-const std::string SelRecall::RESET_JOB_STATE =
-        "UPDATE JOB_QUEUE SET FILE_STATE = %1%"
-                " WHERE REQ_NUM=%2%"
-                " AND TAPE_ID='%3%'"
-                " AND FILE_STATE=%4%";
-
 const std::string SelRecall::UPDATE_REQUEST =
         "UPDATE REQUEST_QUEUE SET STATE=%1%"
                 " WHERE REQ_NUM=%2%"
@@ -284,15 +362,6 @@ const std::string SelRecall::UPDATE_REQUEST =
 
 /* ======== TransRecall ======== */
 
-const std::string TransRecall::ADD_JOB =
-        "INSERT INTO JOB_QUEUE (OPERATION, FILE_NAME, REQ_NUM, TARGET_STATE, REPL_NUM, FILE_SIZE, FS_ID_H, FS_ID_L, I_GEN,"
-                " I_NUM, MTIME_SEC, MTIME_NSEC, LAST_UPD, FILE_STATE, TAPE_ID, START_BLOCK, CONN_INFO)"
-                " VALUES (" /* OPERATION */"%1%, " /* FILE_NAME */"%2%, " /* REQ_NUM */"%3%, "
-                /* TARGET_STATE */"%4%, " /* REPL_NUM */"%5%, " /* FILE_SIZE */"%6%, " /* FS_ID */"%7%, " /* FS_ID */"%8%, "
-                /* I_GEN */"%9%, " /* I_NUM */"%10%, " /* MTIME_SEC */"%11%, " /* MTIME_NSEC */"%12%, "
-                /* LAST_UPD */"%13%, " /* FILE_STATE */"%14%, " /* TAPE_ID */"'%15%', " /* START_BLOCK */"%16%, "
-                /* CONN_INFO */"%17%)";
-
 const std::string TransRecall::CHECK_REQUEST_EXISTS =
         "SELECT STATE FROM REQUEST_QUEUE WHERE REQ_NUM=%1%";
 
@@ -305,33 +374,6 @@ const std::string TransRecall::ADD_REQUEST =
                 " VALUES (" /* OPERATION */"%1%, " /* REQ_NUMR */"%2%, " /* TARGET_STATE */"'%3%', "
                 /* TAPE_ID */"'%4%', " /* TIME_ADDED */"%5%, " /* STATE */"%6%)";
 
-const std::string TransRecall::REMAINING_JOBS =
-        "SELECT FS_ID_H, FS_ID_L, I_GEN, I_NUM, FILE_NAME, CONN_INFO  FROM JOB_QUEUE"
-                " WHERE OPERATION=%1%";
-
-const std::string TransRecall::SET_RECALLING =
-        "UPDATE JOB_QUEUE SET FILE_STATE=%1%"
-                " WHERE REQ_NUM=%2%"
-                " AND FILE_STATE=%3%"
-                " AND TAPE_ID='%4%'";
-
-//! [trans_recall_sql_qry]
-const std::string TransRecall::SELECT_JOBS =
-        "SELECT FS_ID_H, FS_ID_L, I_GEN, I_NUM, FILE_NAME, FILE_STATE, TARGET_STATE, CONN_INFO  FROM JOB_QUEUE"
-                " WHERE REQ_NUM=%1%"
-                " AND (FILE_STATE=%2% OR FILE_STATE=%3%)"
-                " AND TAPE_ID='%4%' ORDER BY START_BLOCK";
-//! [trans_recall_sql_qry]
-
-const std::string TransRecall::DELETE_JOBS = "DELETE FROM JOB_QUEUE"
-        " WHERE REQ_NUM=%1%"
-        " AND (FILE_STATE=%2% OR FILE_STATE=%3%)"
-        " AND TAPE_ID='%4%'";
-
-const std::string TransRecall::COUNT_REMAINING_JOBS =
-        "SELECT COUNT(*) FROM JOB_QUEUE WHERE REQ_NUM=%1%"
-                " AND TAPE_ID='%2%'";
-
 const std::string TransRecall::DELETE_REQUEST =
         "DELETE FROM REQUEST_QUEUE WHERE REQ_NUM=%1%"
                 " AND TAPE_ID='%2%'";
@@ -341,9 +383,6 @@ const std::string TransRecall::DELETE_REQUEST =
 const std::string FileOperation::REQUEST_STATE =
         "SELECT STATE FROM REQUEST_QUEUE WHERE REQ_NUM=%1%";
 
-const std::string FileOperation::DELETE_JOBS =
-        "DELETE FROM JOB_QUEUE WHERE REQ_NUM=%1%";
-
 const std::string FileOperation::DELETE_REQUESTS =
         "DELETE FROM REQUEST_QUEUE WHERE REQ_NUM=%1%";
 
@@ -361,21 +400,6 @@ const std::string MessageParser::INFO_ONE_REQUEST =
                 " FROM REQUEST_QUEUE"
                 " WHERE REQ_NUM=%1%";
 
-const std::string MessageParser::INFO_ALL_JOBS =
-        "SELECT OPERATION, FILE_NAME, REQ_NUM, TAPE_POOL,"
-                " FILE_SIZE, TAPE_ID, FILE_STATE FROM JOB_QUEUE";
-
-const std::string MessageParser::INFO_SEL_JOBS =
-        "SELECT OPERATION, FILE_NAME, REQ_NUM, TAPE_POOL,"
-                " FILE_SIZE, TAPE_ID, FILE_STATE FROM JOB_QUEUE"
-                " WHERE REQ_NUM=%1%";
-
-/* ======== Status ======== */
-
-const std::string Status::STATUS =
-        "SELECT FILE_STATE, COUNT(*) FROM JOB_QUEUE WHERE REQ_NUM=%1%"
-                " GROUP BY FILE_STATE";
-
 /* ======== Mount ======== */
 
 const std::string TapeMover::ADD_REQUEST =
@@ -0,0 +1,347 @@
+/*******************************************************************************
+ * Copyright 2018 IBM Corp. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *******************************************************************************/
+#include "ServerIncludes.h"
+
+/*
+ * The SQLite job store keeps the jobs within the JOB_QUEUE table
+ * (see @ref sqlite). All statements are cached. Where a method accepts
+ * one or two states the statement compares both parameters, a single
+ * state is bound twice. File names are stored as directory id and leaf
+ * name (see JOB_DIRECTORIES in @ref sqlite).
+ */
+
+/*
+ * Returns the id of a directory within the JOB_DIRECTORIES table and adds
+ * it if requested. The ids are cached since directories are never
+ * removed. The lock is not held while the database is accessed: a
+ * thread within a transaction could wait for it otherwise. Adding the
+ * same directory concurrently is ignored by the database. Returns
+ * Const::UNSET if the directory does not exist.
+ */
+long SQLiteJobStore::dirId(const std::string& dir, bool add)
+
+{
+    SQLStatement stmt;
+    long id = Const::UNSET;
+
+    {
+        std::lock_guard<std::mutex> lock(dirmtx);
+        std::unordered_map<std::string, long>::iterator it = dirs.find(dir);
+        if (it != dirs.end())
+            return it->second;
+    }
+
+    if (add) {
+        stmt.cached(SQLiteJobStore::ADD_DIRECTORY) << dir;
+        stmt.doall();
+    }
+
+    stmt.cached(SQLiteJobStore::GET_DIRECTORY) << dir;
+    while (stmt.step(&id)) {
+    }
+    stmt.finalize();
+
+    TRACE(Trace::full, dir, id);
+
+    if (id != Const::UNSET) {
+        std::lock_guard<std::mutex> lock(dirmtx);
+        dirs[dir] = id;
+    }
+
+    return id;
+}
+
+bool SQLiteJobStore::read(SQLStatement& stmt, JobStore::job_t *job)
+
+{
+    return stmt.step(&job->operation, &job->fileName, &job->reqNumber,
+            &job->targetState, &job->replNum, &job->pool, &job->fileSize,
+            &job->fuid.fsid_h, &job->fuid.fsid_l, &job->fuid.igen,
+            &job->fuid.inum, &job->mtimeSec, &job->mtimeNsec, &job->lastUpd,
+            &job->tapeId, &job->state, &job->startBlock, &job->connInfo);
+}
+
+void SQLiteJobStore::visitAll(SQLStatement& stmt, JobStore::visitor_t visit)
+
+{
+    JobStore::job_t job;
+
+    while (read(stmt, &job))
+        if (visit(job) == false)
+            break;
+    stmt.finalize();
+}
+
+void SQLiteJobStore::open()
+
+{
+    SQLStatement stmt;
+
+    stmt(SQLiteJobStore::CREATE_JOB_DIRECTORIES);
+    stmt.doall();
+
+    stmt(SQLiteJobStore::CREATE_JOB_QUEUE);
+    stmt.doall();
+
+    stmt(SQLiteJobStore::CREATE_JOB_QUEUE_STATE_INDEX);
+    stmt.doall();
+
+    stmt(SQLiteJobStore::CREATE_JOB_QUEUE_BLOCK_INDEX);
+    stmt.doall();
+}
+
+void SQLiteJobStore::begin()
+
+{
+    DB.beginTransaction();
+}
+
+void SQLiteJobStore::commit()
+
+{
+    DB.endTransaction();
+}
+
+void SQLiteJobStore::add(const JobStore::job_t& job)
+
+{
+    SQLStatement stmt;
+    std::string dir;
+    std::string leaf;
+    long id = Const::UNSET;
+
+    if (job.fileName.compare("") != 0) {
+        splitName(job.fileName, &dir, &leaf);
+        id = dirId(dir, true);
+    }
+
+    stmt.cached(SQLiteJobStore::ADD_JOB) << job.operation << id << leaf
+            << job.reqNumber << job.targetState << job.replNum << job.pool
+            << job.fileSize << job.fuid.fsid_h << job.fuid.fsid_l
+            << job.fuid.igen << job.fuid.inum << job.mtimeSec << job.mtimeNsec
+            << job.lastUpd << job.tapeId << job.state << job.startBlock
+            << job.connInfo;
+
+    if (job.fileName.compare("") == 0) {
+        stmt.bindNull(2);
+        stmt.bindNull(3);
+    }
+    if (job.replNum == JobStore::NO_REPL)
+        stmt.bindNull(6);
+
+    TRACE(Trace::full, stmt.str(), job.fileName, job.replNum);
+
+    stmt.doall();
+}
+
+void SQLiteJobStore::fail(long reqNumber, std::string fileName, int replNum)
+
+{
+    SQLStatement stmt;
+    std::string dir;
+    std::string leaf;
+    long id;
+
+    splitName(fileName, &dir, &leaf);
+    if ((id = dirId(dir, false)) == Const::UNSET)
+        return;
+
+    stmt.cached(SQLiteJobStore::FAIL_JOB) << FsObj::FAILED << id << leaf
+            << reqNumber << (replNum == JobStore::NO_REPL) << replNum;
+    TRACE(Trace::full, stmt.str(), fileName, replNum);
+    stmt.doall();
+}
+
+void SQLiteJobStore::pending(long reqNumber, FsObj::file_state state,
+        int replNum, std::vector<std::pair<unsigned long, long>> *jobs)
+
+{
+    SQLStatement stmt;
+    long rowid;
+    unsigned long fileSize;
+
+    stmt.cached(SQLiteJobStore::SELECT_PENDING) << reqNumber << state
+            << replNum;
+    TRACE(Trace::normal, stmt.str(), reqNumber, state, replNum);
+    while (stmt.step(&rowid, &fileSize))
+        jobs->push_back(std::make_pair(fileSize, rowid));
+    stmt.finalize();
+}
+
+void SQLiteJobStore::assign(long reqNumber, const std::vector<long>& ids,
+        FsObj::file_state state, std::string tapeId)
+
+{
+    SQLStatement stmt;
+    std::vector<long>::const_iterator it = ids.begin();
+
+    stmt.cached(SQLiteJobStore::ASSIGN_JOB) << state << tapeId << reqNumber;
+    TRACE(Trace::normal, stmt.str(), ids.size());
+
+    while (it != ids.end()) {
+        DataBase::Transaction trans;
+
+        for (int i = 0; i < Const::JOB_UPDATE_BATCH && it != ids.end();
+                i++, ++it) {
+            stmt.bind(4, *it);
+            stmt.step();
+            stmt.finalize();
+        }
+    }
+}
+
+void SQLiteJobStore::changeState(long reqNumber, std::string tapeId,
+        int replNum, FsObj::file_state from, FsObj::file_state to)
+
+{
+    SQLStatement stmt;
+
+    stmt.cached(SQLiteJobStore::CHANGE_STATE) << to << reqNumber << from
+            << tapeId << (replNum == JobStore::NO_REPL) << replNum;
+    TRACE(Trace::normal, stmt.str(), reqNumber, tapeId, replNum, from, to);
+    stmt.doall();
+}
+
+/*
+ * The updates are performed in transactions of Const::JOB_UPDATE_BATCH
+ * files.
+ */
+void SQLiteJobStore::changeState(long reqNumber, std::string tapeId,
+        int replNum, const std::vector<FsObj::file_state>& from,
+        FsObj::file_state to, const std::vector<fuid_t>& uids)
+
+{
+    SQLStatement stmt;
+    std::vector<fuid_t>::const_iterator it = uids.begin();
+
+    assert(from.size() == 1 || from.size() == 2);
+
+    stmt.cached(SQLiteJobStore::SET_JOB_STATE) << to << reqNumber << tapeId
+            << from.front() << from.back() << (replNum == JobStore::NO_REPL)
+            << replNum;
+    TRACE(Trace::normal, stmt.str(), reqNumber, tapeId, replNum, to,
+            uids.size());
+
+    while (it != uids.end()) {
+        DataBase::Transaction trans;
+
+        for (int i = 0; i < Const::JOB_UPDATE_BATCH && it != uids.end();
+                i++, ++it) {
+            stmt.bind(8, it->fsid_h);
+            stmt.bind(9, it->fsid_l);
+            stmt.bind(10, it->igen);
+            stmt.bind(11, it->inum);
+            stmt.step();
+            stmt.finalize();
+        }
+    }
+}
+
+void SQLiteJobStore::select(long reqNumber, std::string tapeId,
+        const std::vector<FsObj::file_state>& states, unsigned long limit,
+        JobStore::visitor_t visit)
+
+{
+    SQLStatement stmt;
+
+    assert(states.size() == 1 || states.size() == 2);
+
+    stmt.cached(SQLiteJobStore::SELECT_JOBS) << reqNumber << tapeId
+            << states.front() << states.back()
+            << (limit == 0 ? -1L : static_cast<long>(limit));
+    TRACE(Trace::normal, stmt.str(), reqNumber, tapeId, limit);
+    visitAll(stmt, visit);
+}
+
+void SQLiteJobStore::list(long reqNumber, JobStore::visitor_t visit)
+
+{
+    SQLStatement stmt;
+
+    if (reqNumber != Const::UNSET)
+        stmt.cached(SQLiteJobStore::REQUEST_JOBS) << reqNumber;
+    else
+        stmt.cached(SQLiteJobStore::ALL_JOBS);
+    TRACE(Trace::normal, stmt.str(), reqNumber);
+    visitAll(stmt, visit);
+}
+
+void SQLiteJobStore::countStates(long reqNumber,
+        std::map<FsObj::file_state, long> *num)
+
+{
+    SQLStatement stmt;
+    FsObj::file_state state;
+    long count;
+
+    stmt.cached(SQLiteJobStore::COUNT_STATES) << reqNumber;
+    while (stmt.step(&state, &count))
+        (*num)[state] = count;
+    stmt.finalize();
+}
+
+long SQLiteJobStore::count(long reqNumber, std::string tapeId)
+
+{
+    SQLStatement stmt;
+    long count = 0;
+
+    stmt.cached(SQLiteJobStore::COUNT_JOBS) << reqNumber << tapeId;
+    TRACE(Trace::normal, stmt.str(), reqNumber, tapeId);
+    while (stmt.step(&count)) {
+    }
+    stmt.finalize();
+
+    return count;
+}
+
+void SQLiteJobStore::tapes(long reqNumber, std::vector<std::string> *tapeIds)
+
+{
+    SQLStatement stmt;
+    std::string tapeId;
+
+    stmt.cached(SQLiteJobStore::GET_TAPES) << reqNumber;
+    TRACE(Trace::normal, stmt.str(), reqNumber);
+    while (stmt.step(&tapeId))
+        tapeIds->push_back(tapeId);
+    stmt.finalize();
+}
+
+void SQLiteJobStore::remove(long reqNumber)
+
+{
+    SQLStatement stmt;
+
+    stmt.cached(SQLiteJobStore::DELETE_REQUEST_JOBS) << reqNumber;
+    TRACE(Trace::normal, stmt.str(), reqNumber);
+    stmt.doall();
+}
+
+void SQLiteJobStore::remove(long reqNumber, std::string tapeId,
+        const std::vector<FsObj::file_state>& states)
+
+{
+    SQLStatement stmt;
+
+    assert(states.size() == 1 || states.size() == 2);
+
+    stmt.cached(SQLiteJobStore::DELETE_JOBS) << reqNumber << tapeId
+            << states.front() << states.back();
+    TRACE(Trace::normal, stmt.str(), reqNumber, tapeId);
+    stmt.doall();
+}
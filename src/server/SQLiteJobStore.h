@@ -0,0 +1,77 @@
+/*******************************************************************************
+ * Copyright 2018 IBM Corp. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *******************************************************************************/
+#pragma once
+
+class SQLiteJobStore: public JobStore
+{
+private:
+    static const std::string CREATE_JOB_DIRECTORIES;
+    static const std::string CREATE_JOB_QUEUE;
+    static const std::string CREATE_JOB_QUEUE_STATE_INDEX;
+    static const std::string CREATE_JOB_QUEUE_BLOCK_INDEX;
+    static const std::string ADD_DIRECTORY;
+    static const std::string GET_DIRECTORY;
+    static const std::string ADD_JOB;
+    static const std::string FAIL_JOB;
+    static const std::string SELECT_PENDING;
+    static const std::string ASSIGN_JOB;
+    static const std::string CHANGE_STATE;
+    static const std::string SET_JOB_STATE;
+    static const std::string SELECT_JOBS;
+    static const std::string ALL_JOBS;
+    static const std::string REQUEST_JOBS;
+    static const std::string COUNT_STATES;
+    static const std::string COUNT_JOBS;
+    static const std::string GET_TAPES;
+    static const std::string DELETE_REQUEST_JOBS;
+    static const std::string DELETE_JOBS;
+
+    std::unordered_map<std::string, long> dirs;
+    std::mutex dirmtx;
+
+    long dirId(const std::string& dir, bool add);
+    static bool read(SQLStatement& stmt, job_t *job);
+    static void visitAll(SQLStatement& stmt, visitor_t visit);
+public:
+    SQLiteJobStore()
+    {
+    }
+    void open();
+    void begin();
+    void commit();
+    void add(const job_t& job);
+    void fail(long reqNumber, std::string fileName, int replNum);
+    void pending(long reqNumber, FsObj::file_state state, int replNum,
+            std::vector<std::pair<unsigned long, long>> *jobs);
+    void assign(long reqNumber, const std::vector<long>& ids,
+            FsObj::file_state state, std::string tapeId);
+    void changeState(long reqNumber, std::string tapeId, int replNum,
+            FsObj::file_state from, FsObj::file_state to);
+    void changeState(long reqNumber, std::string tapeId, int replNum,
+            const std::vector<FsObj::file_state>& from, FsObj::file_state to,
+            const std::vector<fuid_t>& uids);
+    void select(long reqNumber, std::string tapeId,
+            const std::vector<FsObj::file_state>& states, unsigned long limit,
+            visitor_t visit);
+    void list(long reqNumber, visitor_t visit);
+    void countStates(long reqNumber, std::map<FsObj::file_state, long> *num);
+    long count(long reqNumber, std::string tapeId);
+    void tapes(long reqNumber, std::vector<std::string> *tapeIds);
+    void remove(long reqNumber);
+    void remove(long reqNumber, std::string tapeId,
+            const std::vector<FsObj::file_state>& states);
+};
@@ -38,6 +38,10 @@
     Within the outer while loop of Scheduler::runthe condition Scheduler::cond
     is waiting for a lock on the Scheduler::mtx mutex.
 
+    All new requests are read at once and ordered by the MountPlanner to
+    reduce the number of cartridge moves (see @ref mount_planner) before
+    each of them is checked for available resources.
+
     The scheduler also initiates mount and unmounts of cartridges. E.g. if there
     is a new request to migrate data but all available drives are empty the
     scheduler initiates a tape mount for a corresponding cartridge.
@@ -87,9 +91,16 @@
     A tape resource is checked for availability in the following way (return
     statements are performed in respect to the condition):
 
-    -# If the corresponding cartridge is moving: <b>return false</b>.
+    -# If the corresponding cartridge is in use and the current request is a
+       recall: request the operation on the drive that holds the cartridge to
+       suspend if it has a lower priority. A migration stops at the next
+       chunk of data it writes (see @ref migration).
+    -# If the corresponding cartridge is moving or in use: <b>return false</b>.
     -# If the corresponding cartridge is mounted (but not in use) it can be
        used for the current request: <b>return true</b>.
+    -# If the MountPlanner assigned a drive to the cartridge that still can
+       be used (Scheduler::useAssignedDrive): <b>mount tape</b> on it or
+       <b>unmount</b> the cartridge it holds and <b>return false</b>.
     -# If there is a free (not in use) drive: <b>mount tape</b> and <b>return false</b>.
     -# If there is a drive that has cartridge mounted that is not in use:
        <b>unmount tape</b> and <b>return false</b>.
@@ -101,6 +112,39 @@
     -# Now try to <b>suspend an operation</b>.
     -# <b>return false</b>
 
+    ## Pre-staging
+
+    A cartridge move is reserved for a drive per request and tape storage
+    pool for migration and per request and cartridge for all other
+    operations (Scheduler::moveReqKey). Therefore the cartridges of a
+    recall that spans multiple cartridges can be mounted on different
+    drives in parallel.
+
+    After all new requests have been evaluated Scheduler::prestage looks
+    ahead at the requests that could not be scheduled and that are waiting
+    for an unmounted cartridge. For each of these cartridges in the order
+    provided by the MountPlanner (Scheduler::stageTape):
+
+    -# If the MountPlanner assigned an idle drive to the cartridge:
+       <b>mount tape</b> on it or <b>unmount</b> the cartridge it holds.
+    -# If there is an empty drive that is idle: <b>mount tape</b>.
+    -# If there is an idle drive with a cartridge that is not required by
+       any pending request: <b>unmount tape</b> early.
+    -# Otherwise there is no drive left for pre-staging.
+
+    Since a pass of the scheduler is performed each time a drive gets
+    released this way a drive is prepared for the next cartridge while data
+    transfer continues on the other drives.
+
+    For recall requests the time they are waiting to be scheduled is tracked
+    (Scheduler::checkRecallWait). If a recall still is waiting after
+    Const::RECALL_WAIT_LIMIT seconds the cartridge is not considered as being
+    requested anymore so that another operation can be suspended. When the
+    recall finally gets scheduled the wait time is reported
+    (Scheduler::recallScheduled) if it exceeded this limit. Recalls that
+    are removed without having been scheduled are dropped from tracking
+    (Scheduler::recallRemoved).
+
 
     ## Scheduler::poolResAvail
 
@@ -108,8 +152,8 @@
     (return statements are performed in respect to the condition):
 
     -# If a cartridge of the specified tape storage pool is mounted but not in
-       use and the remaining space is larger than the smallest file to migrate:
-       <b>return true</b>.
+       use and the remaining space is larger than the smallest file to migrate
+       (see @ref job_stats): <b>return true</b>.
     -# If there is no cartridge that is not mounted there is no need to look
        for a cartridge from another pool to unmount: <b>return false</b>.
     -# Check if there is an empty drive to mount a tape which is part of the
@@ -139,6 +183,8 @@ std::condition_variable Scheduler::cond;
 std::mutex Scheduler::updmtx;
 std::condition_variable Scheduler::updcond;
 std::map<int, std::atomic<bool>> Scheduler::updReq;
+std::map<std::pair<int, std::string>, Scheduler::recall_wait_t> Scheduler::recallWait;
+std::mutex Scheduler::waitmtx;
 
 void Scheduler::makeUse(std::string driveId, std::string tapeId)
 
@@ -151,6 +197,20 @@ void Scheduler::makeUse(std::string driveId, std::string tapeId)
     cart->setState(LTFSDMCartridge::TAPE_INUSE);
 }
 
+std::string Scheduler::moveReqKey()
+
+{
+    /*
+     * A migration can use any cartridge of its pool whereas all other
+     * operations require a specific cartridge. This way cartridges of a
+     * request that spans multiple cartridges can be moved in parallel.
+     */
+    if (op == DataBase::MIGRATION)
+        return pool;
+    else
+        return tapeId;
+}
+
 bool Scheduler::driveIsUsable(std::shared_ptr<LTFSDMDrive> drive)
 
 {
@@ -160,7 +220,7 @@ bool Scheduler::driveIsUsable(std::shared_ptr<LTFSDMDrive> drive)
     if (drive->isBusy() == true)
         return false;
 
-    if (rn != Const::UNSET && !(rn == reqNum && p.compare(pool) == 0))
+    if (rn != Const::UNSET && !(rn == reqNum && p.compare(moveReqKey()) == 0))
         return false;
 
     return true;
@@ -179,7 +239,7 @@ void Scheduler::moveTape(std::string driveId, std::string tapeId,
             || op == DataBase::UNMOUNT)
         return;
 
-    if (inventory->requestExists(reqNum, pool) == true)
+    if (inventory->requestExists(reqNum, moveReqKey()) == true)
         return;
 
     switch (top) {
@@ -199,13 +259,170 @@ void Scheduler::moveTape(std::string driveId, std::string tapeId,
 
     TRACE(Trace::always, driveId, tapeId);
     //Scheduler::makeUse(driveId, tapeId);
-    drive->setMoveReq(reqNum, pool);
+    drive->setMoveReq(reqNum, moveReqKey());
     //drive->setBusy();
 
     subs.enqueue(std::string(opstr) + tapeId, &TapeMover::addRequest,
             TapeMover(driveId, tapeId, top));
 }
 
+bool Scheduler::unmountTape()
+
+{
+    // prefer cartridges that are not required by pending requests
+    for (int pass = 0; pass < 2; pass++) {
+        for (std::shared_ptr<LTFSDMDrive> drive : inventory->getDrives()) {
+            if (driveIsUsable(drive) == false)
+                continue;
+            for (std::shared_ptr<LTFSDMCartridge> cart : inventory->getCartridges()) {
+                if ((drive->get_le()->get_slot() == cart->get_le()->get_slot())
+                        && (cart->getState() == LTFSDMCartridge::TAPE_MOUNTED)
+                        && (pass == 1
+                                || planner.isWanted(
+                                        cart->get_le()->GetObjectID())
+                                        == false)) {
+                    Scheduler::moveTape(drive->get_le()->GetObjectID(),
+                            cart->get_le()->GetObjectID(), TapeMover::UNMOUNT);
+                    return true;
+                }
+            }
+        }
+    }
+
+    return false;
+}
+
+/*
+ * Moves the cartridge of the current request towards the drive the
+ * MountPlanner assigned to it: the cartridge is mounted if the drive is
+ * empty, otherwise the cartridge within the drive is unmounted first.
+ * Returns false if there is no assignment or if the drive cannot be used
+ * anymore.
+ */
+bool Scheduler::useAssignedDrive(TapeMover::operation *top)
+
+{
+    std::string assigned = planner.getDrive(tapeId);
+    std::shared_ptr<LTFSDMDrive> drive;
+
+    if (assigned.compare("") == 0
+            || (drive = inventory->getDrive(assigned)) == nullptr
+            || driveIsUsable(drive) == false)
+        return false;
+
+    for (std::shared_ptr<LTFSDMCartridge> cart : inventory->getCartridges()) {
+        if (drive->get_le()->get_slot() != cart->get_le()->get_slot())
+            continue;
+        if (cart->getState() != LTFSDMCartridge::TAPE_MOUNTED
+                || planner.isWanted(cart->get_le()->GetObjectID()))
+            return false;
+        TRACE(Trace::always, assigned, cart->get_le()->GetObjectID());
+        Scheduler::moveTape(assigned, cart->get_le()->GetObjectID(),
+                TapeMover::UNMOUNT);
+        metrics.increment("scheduler", "assigned unmounts");
+        *top = TapeMover::UNMOUNT;
+        return true;
+    }
+
+    TRACE(Trace::always, assigned, tapeId);
+    Scheduler::moveTape(assigned, tapeId, mountTarget);
+    metrics.increment("scheduler", "assigned mounts");
+    *top = mountTarget;
+    return true;
+}
+
+bool Scheduler::stageTape()
+
+{
+    TapeMover::operation top;
+    bool found;
+
+    // the drive assigned by the mount planner
+    if (useAssignedDrive(&top)) {
+        metrics.increment("scheduler",
+                top == TapeMover::UNMOUNT ?
+                        "prestaged unmounts" : "prestaged mounts");
+        return true;
+    }
+
+    // mount the cartridge if there is an empty drive
+    for (std::shared_ptr<LTFSDMDrive> drive : inventory->getDrives()) {
+        if (drive->isBusy() || drive->getMoveReqNum() != Const::UNSET)
+            continue;
+        found = false;
+        for (std::shared_ptr<LTFSDMCartridge> cart : inventory->getCartridges()) {
+            if (drive->get_le()->get_slot() == cart->get_le()->get_slot()
+                    && cart->getState() == LTFSDMCartridge::TAPE_MOUNTED) {
+                found = true;
+                break;
+            }
+        }
+        if (found == false) {
+            Scheduler::moveTape(drive->get_le()->GetObjectID(), tapeId,
+                    mountTarget);
+            metrics.increment("scheduler", "prestaged mounts");
+            return true;
+        }
+    }
+
+    // unmount a cartridge early that is not required anymore
+    for (std::shared_ptr<LTFSDMDrive> drive : inventory->getDrives()) {
+        if (drive->isBusy() || drive->getMoveReqNum() != Const::UNSET)
+            continue;
+        for (std::shared_ptr<LTFSDMCartridge> cart : inventory->getCartridges()) {
+            if (drive->get_le()->get_slot() == cart->get_le()->get_slot()
+                    && cart->getState() == LTFSDMCartridge::TAPE_MOUNTED
+                    && planner.isWanted(cart->get_le()->GetObjectID())
+                            == false) {
+                Scheduler::moveTape(drive->get_le()->GetObjectID(),
+                        cart->get_le()->GetObjectID(), TapeMover::UNMOUNT);
+                metrics.increment("scheduler", "prestaged unmounts");
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+void Scheduler::prestage()
+
+{
+    std::shared_ptr<LTFSDMCartridge> cart;
+
+    std::lock_guard<std::recursive_mutex> lock(LTFSDMInventory::mtx);
+
+    for (MountPlanner::request_t req : planner.getRequests()) {
+        if (req.scheduled || req.tapeId.compare("") == 0
+                || req.op == DataBase::MOUNT || req.op == DataBase::MOVE
+                || req.op == DataBase::UNMOUNT)
+            continue;
+
+        if ((cart = inventory->getCartridge(req.tapeId)) == nullptr
+                || cart->getState() != LTFSDMCartridge::TAPE_UNMOUNTED)
+            continue;
+
+        op = req.op;
+        reqNum = req.reqNum;
+        pool = req.pool;
+        tapeId = req.tapeId;
+
+        if (inventory->requestExists(reqNum, moveReqKey()))
+            continue;
+
+        if (op == DataBase::FORMAT || op == DataBase::CHECK)
+            mountTarget = TapeMover::MOVE;
+        else
+            mountTarget = TapeMover::MOUNT;
+
+        TRACE(Trace::always, op, reqNum, tapeId);
+
+        // no idle drive left
+        if (stageTape() == false)
+            break;
+    }
+}
+
 bool Scheduler::poolResAvail(unsigned long minFileSize)
 
 {
@@ -287,18 +504,7 @@ bool Scheduler::poolResAvail(unsigned long minFileSize)
             return false;
 
     // check if there is a tape to unmount
-    for (std::shared_ptr<LTFSDMDrive> drive : inventory->getDrives()) {
-        if (driveIsUsable(drive) == false)
-            continue;
-        for (std::shared_ptr<LTFSDMCartridge> cart : inventory->getCartridges()) {
-            if ((drive->get_le()->get_slot() == cart->get_le()->get_slot())
-                    && (cart->getState() == LTFSDMCartridge::TAPE_MOUNTED)) {
-                Scheduler::moveTape(drive->get_le()->GetObjectID(),
-                        cart->get_le()->GetObjectID(), TapeMover::UNMOUNT);
-                return false;
-            }
-        }
-    }
+    unmountTape();
 
     return false;
 }
@@ -306,10 +512,27 @@ bool Scheduler::poolResAvail(unsigned long minFileSize)
 bool Scheduler::tapeResAvail()
 
 {
+    TapeMover::operation top;
     bool found;
 
     assert(tapeId.compare("") != 0);
 
+    if (inventory->getCartridge(tapeId)->getState()
+            == LTFSDMCartridge::TAPE_INUSE
+            && (op == DataBase::TRARECALL || op == DataBase::SELRECALL)) {
+        for (std::shared_ptr<LTFSDMDrive> drive : inventory->getDrives()) {
+            if (drive->get_le()->get_slot()
+                    == inventory->getCartridge(tapeId)->get_le()->get_slot()
+                    && op < drive->getToUnblock()) {
+                TRACE(Trace::always, op, drive->getToUnblock(),
+                        drive->get_le()->GetObjectID());
+                drive->setToUnblock(op);
+                metrics.increment("scheduler", "suspend requests");
+                break;
+            }
+        }
+    }
+
     if (inventory->getCartridge(tapeId)->getState()
             == LTFSDMCartridge::TAPE_MOVING
             || inventory->getCartridge(tapeId)->getState()
@@ -336,6 +559,14 @@ bool Scheduler::tapeResAvail()
         return true;
     }
 
+    // the drive assigned by the mount planner
+    if (inventory->getCartridge(tapeId)->getState()
+            == LTFSDMCartridge::TAPE_UNMOUNTED && useAssignedDrive(&top)) {
+        if (top == TapeMover::UNMOUNT)
+            inventory->getCartridge(tapeId)->unsetRequested();
+        return false;
+    }
+
     // looking for a free drive
     for (std::shared_ptr<LTFSDMDrive> drive : inventory->getDrives()) {
         if (driveIsUsable(drive) == false)
@@ -359,18 +590,9 @@ bool Scheduler::tapeResAvail()
     }
 
     // looking for a tape to unmount
-    for (std::shared_ptr<LTFSDMDrive> drive : inventory->getDrives()) {
-        if (driveIsUsable(drive) == false)
-            continue;
-        for (std::shared_ptr<LTFSDMCartridge> cart : inventory->getCartridges()) {
-            if ((drive->get_le()->get_slot() == cart->get_le()->get_slot())
-                    && (cart->getState() == LTFSDMCartridge::TAPE_MOUNTED)) {
-                Scheduler::moveTape(drive->get_le()->GetObjectID(),
-                        cart->get_le()->GetObjectID(), TapeMover::UNMOUNT);
-                inventory->getCartridge(tapeId)->unsetRequested();
-                return false;
-            }
-        }
+    if (unmountTape()) {
+        inventory->getCartridge(tapeId)->unsetRequested();
+        return false;
     }
 
     if (inventory->getCartridge(tapeId)->isRequested())
@@ -382,6 +604,7 @@ bool Scheduler::tapeResAvail()
             TRACE(Trace::always, op, drive->getToUnblock(),
                     drive->get_le()->GetObjectID());
             drive->setToUnblock(op);
+            metrics.increment("scheduler", "suspend requests");
             inventory->getCartridge(tapeId)->setRequested();
             break;
         }
@@ -435,15 +658,110 @@ bool Scheduler::resAvail(unsigned long minFileSize)
 unsigned long Scheduler::smallestMigJob(int reqNum, int replNum)
 
 {
-    unsigned long min;
+    return Migration::tapeSize(jobStats.minPending(reqNum, replNum));
+}
+
+void Scheduler::checkRecallWait()
+
+{
+    time_t now = time(NULL);
 
-    SQLStatement stmt = SQLStatement(Scheduler::SMALLEST_MIG_JOB) << reqNum
-            << FsObj::RESIDENT << replNum;
-    stmt.prepare();
-    stmt.step(&min);
-    stmt.finalize();
+    if (op != DataBase::TRARECALL && op != DataBase::SELRECALL)
+        return;
 
-    return min;
+    std::lock_guard<std::mutex> lock(waitmtx);
+    auto it = recallWait.find(std::make_pair(reqNum, tapeId));
+
+    if (it == recallWait.end()) {
+        recallWait[std::make_pair(reqNum, tapeId)] = { now, now };
+        return;
+    }
+
+    if (now - it->second.renewed < Const::RECALL_WAIT_LIMIT)
+        return;
+
+    /*
+     * A previous request to suspend an operation on behalf of this
+     * cartridge did not make it available. Allow to request it again.
+     */
+    TRACE(Trace::always, reqNum, tapeId, now - it->second.added);
+    it->second.renewed = now;
+    inventory->getCartridge(tapeId)->unsetRequested();
+}
+
+void Scheduler::recallScheduled()
+
+{
+    time_t waited;
+
+    std::lock_guard<std::mutex> lock(waitmtx);
+    auto it = recallWait.find(std::make_pair(reqNum, tapeId));
+
+    if (it == recallWait.end())
+        return;
+
+    waited = time(NULL) - it->second.added;
+    TRACE(Trace::always, reqNum, tapeId, waited);
+    if (waited >= Const::RECALL_WAIT_LIMIT)
+        MSG(LTFSDMS0118W, reqNum, waited, tapeId);
+
+    recallWait.erase(it);
+}
+
+/*
+ * Recalls that are removed before they got scheduled (failed, cleaned up
+ * or deleted) are not tracked any longer.
+ */
+void Scheduler::recallRemoved(int reqNum)
+
+{
+    std::lock_guard<std::mutex> lock(waitmtx);
+
+    recallWait.erase(recallWait.lower_bound(std::make_pair(reqNum, "")),
+            recallWait.lower_bound(std::make_pair(reqNum + 1, "")));
+}
+
+/*
+ * The keys of the timers of a request (see Metrics::startTimer) start
+ * with the key of the request number. This way all timers of a request
+ * can be cancelled when it is removed (Metrics::cancelTimers).
+ */
+std::string Scheduler::timerKey(int reqNum)
+
+{
+    return std::to_string(reqNum) + ":";
+}
+
+std::string Scheduler::timerKey(DataBase::operation op, int reqNum,
+        int replNum, std::string tapeId)
+
+{
+    std::stringstream key;
+
+    key << timerKey(reqNum);
+    if (op == DataBase::MIGRATION)
+        key << "M(" << replNum << ")";
+    else if (op == DataBase::SELRECALL)
+        key << "SR(" << tapeId << ")";
+    else if (op == DataBase::TRARECALL)
+        key << "TR(" << tapeId << ")";
+
+    return key.str();
+}
+
+/*
+ * A request that is set to DataBase::REQ_NEW again after it has been
+ * processed (e.g. a migration to further cartridges) keeps its
+ * TIME_ADDED value for the order of scheduling. Its queue wait is
+ * measured from the time it is queued again.
+ */
+void Scheduler::requeued(DataBase::operation op, int reqNum, int replNum,
+        std::string tapeId)
+
+{
+    metrics.startTimer("scheduler",
+            std::string("queue wait ") + DataBase::opStr(op),
+            timerKey(op, reqNum, replNum, tapeId));
 }
 
 void Scheduler::invoke()
@@ -468,6 +786,8 @@ void Scheduler::run(long key)
     std::stringstream ssql;
     std::unique_lock<std::mutex> lock(mtx);
     unsigned long minFileSize;
+    long timeAdded;
+    std::string timer;
 
     while (true) {
         cond.wait(lock);
@@ -477,12 +797,34 @@ void Scheduler::run(long key)
             break;
         }
 
+        planner.clear();
+
         selstmt(Scheduler::SELECT_REQUEST) << DataBase::REQ_NEW;
 
         selstmt.prepare();
         while (selstmt.step(&op, &reqNum, &tgtState, &numRepl, &replNum, &pool,
-                &tapeId, &driveId)) {
+                &tapeId, &driveId, &timeAdded))
+            planner.add( { op, reqNum, tgtState, numRepl, replNum, pool, tapeId,
+                    driveId, timeAdded, false });
+        selstmt.finalize();
+
+        planner.plan();
+        if (planner.getMoves() > 0)
+            metrics.add("scheduler", "planned moves",
+                    (unsigned long) planner.getMoves());
+
+        for (unsigned long pos = 0; pos < planner.getRequests().size(); pos++) {
             std::lock_guard<std::recursive_mutex> lock(LTFSDMInventory::mtx);
+            MountPlanner::request_t req = planner.getRequests()[pos];
+
+            op = req.op;
+            reqNum = req.reqNum;
+            tgtState = req.tgtState;
+            numRepl = req.numRepl;
+            replNum = req.replNum;
+            pool = req.pool;
+            tapeId = req.tapeId;
+            driveId = req.driveId;
 
             TRACE(Trace::always, op, reqNum, replNum, tapeId, driveId);
 
@@ -496,9 +838,24 @@ void Scheduler::run(long key)
             else
                 mountTarget = TapeMover::MOUNT;
 
+            checkRecallWait();
+
             if (resAvail(minFileSize) == false)
                 continue;
 
+            planner.setScheduled(pos);
+            recallScheduled();
+
+            timer = timerKey(op, reqNum, replNum, tapeId);
+            if (metrics.stopTimer("scheduler", "suspend to resume", timer)
+                    == false
+                    && metrics.stopTimer("scheduler",
+                            std::string("queue wait ") + DataBase::opStr(op),
+                            timer) == false)
+                metrics.add("scheduler",
+                        std::string("queue wait ") + DataBase::opStr(op),
+                        std::max(0L, DataBase::timeAdded() - req.timeAdded));
+
             TRACE(Trace::always, reqNum, tgtState, numRepl, replNum, pool, op);
 
             std::stringstream thrdinfo;
@@ -582,7 +939,8 @@ void Scheduler::run(long key)
                     TRACE(Trace::error, op);
             }
         }
-        selstmt.finalize();
+
+        prestage();
     }
     MSG(LTFSDMS0081I);
     subs.waitAllRemaining();
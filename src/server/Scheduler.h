@@ -30,6 +30,14 @@ private:
     std::string driveId;
     std::string pool;
     SubServer subs;
+    MountPlanner planner;
+    struct recall_wait_t
+    {
+        time_t added;
+        time_t renewed;
+    };
+    static std::map<std::pair<int, std::string>, recall_wait_t> recallWait;
+    static std::mutex waitmtx;
     static std::mutex mtx;
     static std::condition_variable cond;
 
@@ -37,17 +45,23 @@ private:
     bool driveIsUsable(std::shared_ptr<LTFSDMDrive> drive);
     void moveTape(std::string driveId, std::string tapeId,
             TapeMover::operation op);
+    bool unmountTape();
+    bool useAssignedDrive(TapeMover::operation *top);
+    std::string moveReqKey();
+    bool stageTape();
+    void prestage();
     bool poolResAvail(unsigned long minFileSize);
     bool tapeResAvail();
     bool resAvail(unsigned long minFileSize);
     bool resAvailTapeMove();
     unsigned long smallestMigJob(int reqNum, int replNum);
+    void checkRecallWait();
+    void recallScheduled();
 
     static const std::string SELECT_REQUEST;
     static const std::string UPDATE_REQUEST;
     static const std::string UPDATE_MIG_REQUEST;
     static const std::string UPDATE_REC_REQUEST;
-    static const std::string SMALLEST_MIG_JOB;
 public:
     static std::mutex updmtx;
     static std::condition_variable updcond;
@@ -55,6 +69,12 @@ public:
     static std::map<std::string, std::atomic<bool>> suspend_map;
 
     static void invoke();
+    static void recallRemoved(int reqNum);
+    static std::string timerKey(int reqNum);
+    static std::string timerKey(DataBase::operation op, int reqNum,
+            int replNum, std::string tapeId);
+    static void requeued(DataBase::operation op, int reqNum, int replNum,
+            std::string tapeId);
 
     Scheduler() :
             op(DataBase::NOOP), reqNum(Const::UNSET), numRepl(Const::UNSET), replNum(
@@ -28,7 +28,8 @@
        recall requests are added to the internal queues.
     2. The Scheduler identifies a selective recall request to get scheduled.
        The order of files being recalled depends on the starting block of
-       the data files on tape: @snippet server/SQLStatements.cc sel_recall_sql_qry
+       the data files on tape (see JobStore::select, for the SQLite job
+       store: @snippet server/SQLStatements.cc select_jobs_sql_qry )
 
     @dot
     digraph sel_recall {
@@ -83,7 +84,8 @@
 
     Thereafter the file names of the files to be recalled are sent to the backend.
     When receiving this information corresponding entries are added to the SQL
-    table JOB_QUEUE. For each file one entry is created. After that an entry is
+    table JOB_QUEUE (or to the in-memory job store, see @ref job_store).
+    For each file one entry is created. After that an entry is
     added to the SQL table REQUEST_QUEUE.
 
     This is an example of these two tables in case of selectively recalling
@@ -113,6 +115,7 @@
       @ref LTFSDmProtocol::LTFSDmSelRecRequest::state "recreq.state()")
     - respond back to the client with a request number
     - MessageParser::getObjects: retrieving file names to recall
+        - SelRecall::prepareJob: retrieve the file information
         - SelRecall::addJob: add recall information the the SQLite table JOB_QUEUE
     - SelRecall::addRequest: add a request to the SQLite table REQUEST_QUEUE
     - MessageParser::reqStatusMessage: provide updates to the recall processing to the client
@@ -166,6 +169,11 @@
     -# Process all these jobs in FsObj::RECALLING_MIG or FsObj::RECALLING_PREMIG state
        which results in the recall of all corresponding files. For all jobs in
        FsObj::RECALLING_PREMIG state there will no data transfer happen.
+       The jobs are read in portions of Const::JOB_UPDATE_BATCH jobs. The
+       statement is finalized before a portion is processed such that no
+       job is updated while the JOB_QUEUE table is traversed. Failures are
+       written via the write-behind queue (see @ref job_state_queue) which
+       is flushed before the next portion is read.
        The following change indicates that the recall of file file.4 failed:
        @dot
        digraph step_1 {
@@ -179,11 +187,13 @@
             before -> after [];
        }
        @enddot
-    -# A list is returned containing the inode numbers of these files where
+    -# A list is returned containing the file uids of these files where
        the previous operation was successful. Change all corresponding jobs
        to FsObj::PREMIGRATED or FsObj::RESIDENT depending of the target
-       state. The following changed indicates that recall stopped
-       before file file.5 and target state is premigrated:
+       state. The jobs are updated by their file uid in transactions of
+       Const::JOB_UPDATE_BATCH files (see JobStore::changeState)
+       after each portion. The following changed indicates that
+       recall stopped before file file.5 and target state is premigrated:
        @dot
        digraph step_1 {
             compound=true;
@@ -196,7 +206,7 @@
             before -> after [];
        }
        @enddot
-    -# The remaining jobs (those where no corresponding inode numbers were
+    -# The remaining jobs (those where no corresponding file uids were
        in the list) have not been processed and need to be changed to the
        original state if these were still in FsObj::RECALLING_MIG or
        FsObj::RECALLING_PREMIG state. Jobs that failed in the second step
@@ -229,15 +239,18 @@
     -# The attributes on the disk file are updated or removed in the case of target state resident.
  */
 
-void SelRecall::addJob(std::string fileName)
+void SelRecall::prepareJob(std::string fileName,
+        std::vector<JobStore::job_t> *jobs)
 
 {
     struct stat statbuf;
-    SQLStatement stmt;
     std::string tapeName;
-    int state;
     FsObj::mig_target_attr_t attr;
-    fuid_t fuid;
+    JobStore::job_t job = { DataBase::SELRECALL, fileName, reqNumber,
+            targetState, JobStore::NO_REPL, "", 0, {
+                    (unsigned long) Const::UNSET, (unsigned long) Const::UNSET,
+                    (unsigned int) Const::UNSET, (unsigned long) Const::UNSET },
+            0, 0, time(NULL), Const::FAILED_TAPE_ID, FsObj::FAILED, 0, 0 };
 
     try {
         FsObj fso(fileName);
@@ -248,63 +261,69 @@ void SelRecall::addJob(std::string fileName)
             return;
         }
 
-        state = fso.getMigState();
-        if (state == FsObj::RESIDENT) {
+        job.state = fso.getMigState();
+        if (job.state == FsObj::RESIDENT) {
             MSG(LTFSDMS0026I, fileName.c_str());
             return;
         }
 
         attr = fso.getAttribute();
 
-        if (state == FsObj::MIGRATED) {
+        if (job.state == FsObj::MIGRATED) {
             needsTape.insert(attr.tapeInfo[0].tapeId);
         }
 
         tapeName = Server::getTapeName(&fso, attr.tapeInfo[0].tapeId);
 
-        fuid = fso.getfuid();
-        stmt(SelRecall::ADD_JOB) << DataBase::SELRECALL << fileName << reqNumber
-                << targetState << statbuf.st_size << fuid.fsid_h << fuid.fsid_l
-                << fuid.igen << fuid.inum << statbuf.st_mtim.tv_sec
-                << statbuf.st_mtim.tv_nsec << time(NULL) << state
-                << attr.tapeInfo[0].tapeId << attr.tapeInfo[0].startBlock;
+        job.fileSize = statbuf.st_size;
+        job.fuid = fso.getfuid();
+        job.mtimeSec = statbuf.st_mtim.tv_sec;
+        job.mtimeNsec = statbuf.st_mtim.tv_nsec;
+        job.tapeId = attr.tapeInfo[0].tapeId;
+        job.startBlock = attr.tapeInfo[0].startBlock;
     } catch (const std::exception& e) {
         TRACE(Trace::error, e.what());
-        stmt(SelRecall::ADD_JOB) << DataBase::SELRECALL << fileName << reqNumber
-                << targetState << Const::UNSET << Const::UNSET << Const::UNSET
-                << Const::UNSET << Const::UNSET << 0 << 0 << time(NULL)
-                << FsObj::FAILED << Const::FAILED_TAPE_ID << 0;
+        job.fileSize = 0;
+        job.fuid = (fuid_t ) { (unsigned long) Const::UNSET,
+                        (unsigned long) Const::UNSET,
+                        (unsigned int) Const::UNSET,
+                        (unsigned long) Const::UNSET };
+        job.mtimeSec = 0;
+        job.mtimeNsec = 0;
+        job.tapeId = Const::FAILED_TAPE_ID;
+        job.state = FsObj::FAILED;
+        job.startBlock = 0;
         MSG(LTFSDMS0017E, fileName.c_str());
     }
 
-    TRACE(Trace::normal, stmt.str());
+    jobs->push_back(job);
+}
 
-    stmt.doall();
+void SelRecall::addJob(const JobStore::job_t& job)
 
-    TRACE(Trace::always, fileName, attr.tapeInfo[0].tapeId,
-            attr.tapeInfo[0].startBlock);
+{
+    jobStore->add(job);
 
-    return;
+    TRACE(Trace::always, job.fileName, job.tapeId, job.startBlock);
 }
 
 void SelRecall::addRequest()
 
 {
-    SQLStatement gettapesstmt = SQLStatement(SelRecall::GET_TAPES) << reqNumber;
     SQLStatement addreqstmt;
-    std::string tapeId;
+    std::vector<std::string> tapeIds;
     int state;
     std::stringstream thrdinfo;
     SubServer subs;
 
-    gettapesstmt.prepare();
-
     {
         std::lock_guard<std::mutex> updlock(Scheduler::updmtx);
         Scheduler::updReq[reqNumber] = false;
     }
 
-    while (gettapesstmt.step(&tapeId)) {
+    jobStore->tapes(reqNumber, &tapeIds);
+
+    for (std::string tapeId : tapeIds) {
         if (tapeId.compare(Const::FAILED_TAPE_ID) == 0)
             state = DataBase::REQ_COMPLETED;
         else if (needsTape.count(tapeId) > 0)
@@ -313,7 +332,7 @@ void SelRecall::addRequest()
             state = DataBase::REQ_INPROGRESS;
 
         addreqstmt(SelRecall::ADD_REQUEST) << DataBase::SELRECALL << reqNumber
-                << targetState << tapeId << time(NULL) << state;
+                << targetState << tapeId << DataBase::timeAdded() << state;
 
         TRACE(Trace::normal, addreqstmt.str());
 
@@ -331,19 +350,18 @@ void SelRecall::addRequest()
         }
     }
 
-    gettapesstmt.finalize();
-
     subs.waitAllRemaining();
 }
 
-unsigned long SelRecall::recall(std::string fileName, std::string tapeId,
-        FsObj::file_state state, FsObj::file_state toState)
+unsigned long SelRecall::recall(std::string fileName, std::string driveId,
+        std::string tapeId, FsObj::file_state state, FsObj::file_state toState)
 
 {
     struct stat statbuf;
     struct stat statbuf_tape;
     std::string tapeName;
-    char buffer[Const::READ_BUFFER_SIZE];
+    std::shared_ptr<LTFSDMDrive> drive;
+    char *buffer;
     long rsize;
     long wsize;
     int fd = -1;
@@ -366,6 +384,10 @@ unsigned long SelRecall::recall(std::string fileName, std::string tapeId,
         if (state == FsObj::RESIDENT) {
             return 0;
         } else if (state == FsObj::MIGRATED) {
+            if ((drive = inventory->getDrive(driveId)) == nullptr) {
+                TRACE(Trace::error, driveId);
+                THROW(Error::GENERAL_ERROR, driveId);
+            }
             tapeName = Server::getTapeName(&target, tapeId);
             fd = Server::openTapeRetry(tapeId, tapeName.c_str(),
             O_RDWR | O_CLOEXEC);
@@ -388,28 +410,40 @@ unsigned long SelRecall::recall(std::string fileName, std::string tapeId,
 
             target.prepareRecall();
 
-            while (offset < statbuf.st_size) {
-                if (Server::forcedTerminate)
-                    THROW(Error::OK);
-
-                rsize = read(fd, buffer, sizeof(buffer));
-                if (rsize == 0) {
-                    break;
+            {
+                LTFSDMDrive::Affinity affinity(drive);
+                std::lock_guard<std::mutex> readlock(*drive->mtx);
+                std::chrono::steady_clock::time_point start =
+                        std::chrono::steady_clock::now();
+
+                buffer = drive->getBuffer();
+
+                while (offset < statbuf.st_size) {
+                    if (Server::forcedTerminate)
+                        THROW(Error::OK);
+
+                    rsize = read(fd, buffer, Const::READ_BUFFER_SIZE);
+                    if (rsize == 0) {
+                        break;
+                    }
+
+                    if (rsize == -1) {
+                        TRACE(Trace::error, errno);
+                        MSG(LTFSDMS0023E, tapeName.c_str());
+                        THROW(Error::GENERAL_ERROR, fileName, errno);
+                    }
+                    wsize = target.write(offset, (unsigned long) rsize, buffer);
+                    if (wsize != rsize) {
+                        TRACE(Trace::error, errno, wsize, rsize);
+                        MSG(LTFSDMS0027E, fileName.c_str());
+                        close(fd);
+                        THROW(Error::GENERAL_ERROR, fileName, wsize, rsize);
+                    }
+                    offset += rsize;
                 }
 
-                if (rsize == -1) {
-                    TRACE(Trace::error, errno);
-                    MSG(LTFSDMS0023E, tapeName.c_str());
-                    THROW(Error::GENERAL_ERROR, fileName, errno);
-                }
-                wsize = target.write(offset, (unsigned long) rsize, buffer);
-                if (wsize != rsize) {
-                    TRACE(Trace::error, errno, wsize, rsize);
-                    MSG(LTFSDMS0027E, fileName.c_str());
-                    close(fd);
-                    THROW(Error::GENERAL_ERROR, fileName, wsize, rsize);
-                }
-                offset += rsize;
+                drive->transferred(false, offset,
+                        std::chrono::steady_clock::now() - start);
             }
 
             close(fd);
@@ -428,17 +462,16 @@ unsigned long SelRecall::recall(std::string fileName, std::string tapeId,
     return statbuf.st_size;
 }
 
-bool SelRecall::processFiles(std::string tapeId, FsObj::file_state toState,
-bool needsTape)
+bool SelRecall::processFiles(std::string driveId, std::string tapeId,
+        FsObj::file_state toState, bool needsTape)
 
 {
-    SQLStatement stmt;
-    std::string fileName;
     FsObj::file_state state;
-    unsigned long inum;
+    std::vector<JobStore::job_t> jobs;
     std::shared_ptr<LTFSDMDrive> drive = nullptr;
-    std::list<unsigned long> inumList;
+    std::vector<fuid_t> uidList;
     bool suspended = false;
+    bool finished = false;
     time_t start;
 
     TRACE(Trace::full, reqNumber);
@@ -460,90 +493,98 @@ bool needsTape)
         assert(drive != nullptr);
     }
 
-    stmt(SelRecall::SET_RECALLING) << FsObj::RECALLING_MIG << reqNumber
-            << FsObj::MIGRATED << tapeId;
-    TRACE(Trace::normal, stmt.str());
-    stmt.doall();
-
-    stmt(SelRecall::SET_RECALLING) << FsObj::RECALLING_PREMIG << reqNumber
-            << FsObj::PREMIGRATED << tapeId;
-    TRACE(Trace::normal, stmt.str());
-    stmt.doall();
+    TRACE(Trace::normal, reqNumber, tapeId);
+    jobStore->changeState(reqNumber, tapeId, JobStore::NO_REPL,
+            FsObj::MIGRATED, FsObj::RECALLING_MIG);
+    jobStore->changeState(reqNumber, tapeId, JobStore::NO_REPL,
+            FsObj::PREMIGRATED, FsObj::RECALLING_PREMIG);
 
-    stmt(SelRecall::SELECT_JOBS) << reqNumber << tapeId << FsObj::RECALLING_MIG
-            << FsObj::RECALLING_PREMIG;
-    TRACE(Trace::normal, stmt.str());
-    stmt.prepare();
     start = time(NULL);
-    while (stmt.step(&fileName, &state, &inum)) {
-        if (Server::terminate == true)
+    while (finished == false) {
+        // read a number of jobs before updating them
+        jobs.clear();
+        jobStore->select(reqNumber, tapeId, { FsObj::RECALLING_MIG,
+                FsObj::RECALLING_PREMIG }, Const::JOB_UPDATE_BATCH,
+                [&jobs] (const JobStore::job_t& job) {
+                    jobs.push_back(job);
+                    return true;
+                });
+
+        if (jobs.size() == 0)
             break;
 
-        if (state == FsObj::RECALLING_MIG)
-            state = FsObj::MIGRATED;
-        else
-            state = FsObj::PREMIGRATED;
+        for (const JobStore::job_t& job : jobs) {
+            if (Server::terminate == true) {
+                finished = true;
+                break;
+            }
 
-        TRACE(Trace::always, fileName, state, toState);
+            if (job.state == FsObj::RECALLING_MIG)
+                state = FsObj::MIGRATED;
+            else
+                state = FsObj::PREMIGRATED;
 
-        if (state == toState)
-            continue;
+            TRACE(Trace::always, job.fileName, state, toState);
 
-        if (needsTape && drive->getToUnblock() == DataBase::TRARECALL) {
-            TRACE(Trace::always, tapeId);
-            suspended = true;
-            break;
-        }
+            // nothing to do, the job is done
+            if (state == toState) {
+                uidList.push_back(job.fuid);
+                continue;
+            }
 
-        try {
-            if ((state == FsObj::MIGRATED) && (needsTape == false)) {
-                MSG(LTFSDMS0047E, fileName);
-                THROW(Error::GENERAL_ERROR, fileName);
+            if (needsTape && drive->getToUnblock() == DataBase::TRARECALL) {
+                TRACE(Trace::always, tapeId);
+                suspended = true;
+                finished = true;
+                break;
             }
-            recall(fileName, tapeId, state, toState);
-            inumList.push_back(inum);
-            mrStatus.updateSuccess(reqNumber, state, toState);
-        } catch (const std::exception& e) {
-            TRACE(Trace::error, e.what());
-            mrStatus.updateFailed(reqNumber, state);
-            SQLStatement failstmt = SQLStatement(SelRecall::FAIL_JOB)
-                    << FsObj::FAILED << fileName << reqNumber << tapeId;
-
-            TRACE(Trace::error, stmt.str());
-            failstmt.doall();
-        }
 
-        if (time(NULL) - start < 10)
-            continue;
+            try {
+                if ((state == FsObj::MIGRATED) && (needsTape == false)) {
+                    MSG(LTFSDMS0047E, job.fileName);
+                    THROW(Error::GENERAL_ERROR, job.fileName);
+                }
+                recall(job.fileName, driveId, tapeId, state, toState);
+                uidList.push_back(job.fuid);
+                mrStatus.updateSuccess(reqNumber, state, toState);
+            } catch (const std::exception& e) {
+                TRACE(Trace::error, e.what());
+                mrStatus.updateFailed(reqNumber, state);
+                TRACE(Trace::error, job.fileName, reqNumber, tapeId);
+                std::string fileName = job.fileName;
+                long reqNum = reqNumber;
+                jobStateQueue.add([fileName, reqNum]() {
+                    jobStore->fail(reqNum, fileName, JobStore::NO_REPL);
+                });
+            }
 
-        start = time(NULL);
+            if (time(NULL) - start < 10)
+                continue;
 
-        std::lock_guard<std::mutex> lock(Scheduler::updmtx);
-        Scheduler::updReq[reqNumber] = true;
-        Scheduler::updcond.notify_all();
+            start = time(NULL);
+
+            std::lock_guard<std::mutex> lock(Scheduler::updmtx);
+            Scheduler::updReq[reqNumber] = true;
+            Scheduler::updcond.notify_all();
+        }
+
+        jobStateQueue.flush();
+        TRACE(Trace::normal, uidList.size());
+        jobStore->changeState(reqNumber, tapeId, JobStore::NO_REPL, {
+                FsObj::RECALLING_MIG, FsObj::RECALLING_PREMIG }, toState,
+                uidList);
+        uidList.clear();
     }
     {
         std::lock_guard<std::mutex> lock(Scheduler::updmtx);
         Scheduler::updReq[reqNumber] = true;
         Scheduler::updcond.notify_all();
     }
-    stmt.finalize();
-
-    stmt(SelRecall::SET_JOB_SUCCESS) << toState << reqNumber << tapeId
-            << FsObj::RECALLING_MIG << FsObj::RECALLING_PREMIG
-            << genInumString(inumList);
-    TRACE(Trace::normal, stmt.str());
-    stmt.doall();
-
-    stmt(SelRecall::RESET_JOB_STATE) << FsObj::MIGRATED << reqNumber << tapeId
-            << FsObj::RECALLING_MIG;
-    TRACE(Trace::normal, stmt.str());
-    stmt.doall();
 
-    stmt(SelRecall::RESET_JOB_STATE) << FsObj::PREMIGRATED << reqNumber
-            << tapeId << FsObj::RECALLING_PREMIG;
-    TRACE(Trace::normal, stmt.str());
-    stmt.doall();
+    jobStore->changeState(reqNumber, tapeId, JobStore::NO_REPL,
+            FsObj::RECALLING_MIG, FsObj::MIGRATED);
+    jobStore->changeState(reqNumber, tapeId, JobStore::NO_REPL,
+            FsObj::RECALLING_PREMIG, FsObj::PREMIGRATED);
 
     return suspended;
 }
@@ -554,13 +595,16 @@ bool needsTape)
 {
     SQLStatement stmt;
     bool suspended = false;
+    Metrics::Timer timer("scheduler",
+            std::string("exec ") + DataBase::opStr(DataBase::SELRECALL));
 
     mrStatus.add(reqNumber);
 
     if (targetState == FsObj::PREMIGRATED)
-        suspended = processFiles(tapeId, FsObj::PREMIGRATED, needsTape);
+        suspended = processFiles(driveId, tapeId, FsObj::PREMIGRATED,
+                needsTape);
     else
-        suspended = processFiles(tapeId, FsObj::RESIDENT, needsTape);
+        suspended = processFiles(driveId, tapeId, FsObj::RESIDENT, needsTape);
 
     TRACE(Trace::always, reqNumber, needsTape, tapeId);
 
@@ -575,6 +619,13 @@ bool needsTape)
         inventory->getDrive(driveId)->clearToUnblock();
     }
 
+    if (suspended) {
+        metrics.increment("scheduler", "suspensions");
+        metrics.startTimer("scheduler", "suspend to resume",
+                Scheduler::timerKey(DataBase::SELRECALL, reqNumber,
+                        Const::UNSET, tapeId));
+    }
+
     std::unique_lock<std::mutex> updlock(Scheduler::updmtx);
 
     stmt(SelRecall::UPDATE_REQUEST)
@@ -19,11 +19,9 @@
 std::atomic<bool> Server::terminate;
 std::atomic<bool> Server::forcedTerminate;
 std::atomic<bool> Server::finishTerminate;
-std::mutex Server::termmtx;
-std::condition_variable Server::termcond;
 Configuration Server::conf;
 
-ThreadPool<Migration::mig_info_t, std::shared_ptr<std::list<unsigned long>>,
+ThreadPool<Migration::mig_info_t, std::shared_ptr<std::vector<fuid_t>>,
         FsObj::file_state> *Server::wqs;
 
 int Server::statTapeRetry(std::string tapeId, const char *pathname,
@@ -320,7 +318,8 @@ void Server::writeKey()
     keyFile.close();
 }
 
-void Server::initialize(bool dbUseMemory)
+void Server::initialize(bool dbUseMemory,
+        DataBase::storage_profile_t profile, JobStore::store_type storeType)
 
 {
     //! [set resource limits]
@@ -344,8 +343,10 @@ void Server::initialize(bool dbUseMemory)
     //! [init db]
     try {
         DB.cleanup();
-        DB.open(dbUseMemory);
+        DB.open(dbUseMemory, profile);
         DB.createTables();
+        jobStore = JobStore::create(storeType);
+        jobStore->open();
     } catch (const std::exception& e) {
         TRACE(Trace::error, e.what());
         MSG(LTFSDMS0014E);
@@ -427,18 +428,22 @@ void Server::run(sigset_t set)
 
     //! [thread pool for stubbing]
     Server::wqs = new ThreadPool<Migration::mig_info_t,
-            std::shared_ptr<std::list<unsigned long>>, FsObj::file_state>(
+            std::shared_ptr<std::vector<fuid_t>>, FsObj::file_state>(
             &Migration::changeFileState, Const::MAX_STUBBING_THREADS,
-            "stub1-wq");
+            "stub1-wq", Const::THREAD_POOL_QUEUE_SIZE, Executor::NORMAL,
+            false);
     //! [thread pool for stubbing]
 
     subs.enqueue("Scheduler", &Scheduler::run, &sched, key);
     subs.enqueue("SigHandler", &Server::signalHandler, set, key);
     subs.enqueue("Receiver", &Receiver::run, &recv, key, connector);
     subs.enqueue("RecallD", &TransRecall::run, &trec, connector);
+    subs.enqueue("JobStateQ", &JobStateQueue::run, &jobStateQueue);
 
     subs.waitAllRemaining();
 
+    jobStateQueue.flush();
+
     MSG(LTFSDMS0087I);
 
     TRACE(Trace::always, (bool) Server::terminate,
@@ -23,8 +23,6 @@ private:
     void writeKey();
     static void signalHandler(sigset_t set, long key);
 public:
-    static std::mutex termmtx;
-    static std::condition_variable termcond;
     static std::atomic<bool> terminate;
     static std::atomic<bool> forcedTerminate;
     static std::atomic<bool> finishTerminate;
@@ -32,7 +30,7 @@ public:
     static Configuration conf;
 
     static ThreadPool<Migration::mig_info_t,
-            std::shared_ptr<std::list<unsigned long>>, FsObj::file_state> *wqs;
+            std::shared_ptr<std::vector<fuid_t>>, FsObj::file_state> *wqs;
 
     static int statTapeRetry(std::string tapeId, const char *pathname,
             struct stat *buf);
@@ -52,7 +50,8 @@ public:
             key(Const::UNSET)
     {
     }
-    void initialize(bool dbUseMemory);
+    void initialize(bool dbUseMemory, DataBase::storage_profile_t profile,
+            JobStore::store_type storeType);
     void daemonize();
     void run(sigset_t set);
 };
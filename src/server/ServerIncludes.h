@@ -26,6 +26,12 @@
 #include <sys/xattr.h>
 #include <sys/resource.h>
 #include <sys/file.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/sysmacros.h>
+#include <sched.h>
 #include <libmount/libmount.h>
 #include <blkid/blkid.h>
 #include <sys/vfs.h>
@@ -35,6 +41,7 @@
 #include <sstream>
 #include <memory>
 #include <list>
+#include <deque>
 #include <condition_variable>
 #include <unordered_map>
 #include <thread>
@@ -42,7 +49,10 @@
 #include <map>
 #include <set>
 #include <vector>
+#include <queue>
+#include <algorithm>
 #include <future>
+#include <chrono>
 
 #include <sqlite3.h>
 
@@ -59,10 +69,18 @@
 
 #include "src/connector/Connector.h"
 
+#include "Latch.h"
+#include "Metrics.h"
+#include "Executor.h"
 #include "SubServer.h"
 #include "ThreadPool.h"
 #include "Status.h"
+#include "JobStats.h"
 #include "DataBase.h"
+#include "JobStore.h"
+#include "SQLiteJobStore.h"
+#include "MemoryJobStore.h"
+#include "JobStateQueue.h"
 #include "FileOperation.h"
 #include "MessageParser.h"
 #include "Receiver.h"
@@ -73,4 +91,5 @@
 #include "TapeMover.h"
 #include "TapeHandler.h"
 #include "LTFSDMInventory.h"
+#include "MountPlanner.h"
 #include "Scheduler.h"
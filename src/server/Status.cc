@@ -18,49 +18,147 @@
 
 Status mrStatus;
 
+/*
+ * The progress of a request is kept within a slot of its own cache line
+ * to avoid that the threads updating different requests interfere. The
+ * slot is found by linear probing over Const::STATUS_PROBE_LENGTH slots
+ * starting at the request number without holding a lock. Only Status::add
+ * and Status::remove take the mutex to allocate and to free a slot. If
+ * no slot is available the counters are kept within the allStates map
+ * which is protected by the mutex.
+ *
+ * The counters of a slot are updated atomically. To provide a consistent
+ * snapshot to Status::get the seq member of a slot works as a sequence
+ * lock that permits concurrent writers: the lower 32 bits count the
+ * active writers, the upper bits are incremented each time a writer
+ * finishes. A reader retries until no writer has been active while it
+ * read the counters. To not starve a reader by continuous updates it
+ * accepts a torn snapshot after Const::STATUS_READ_RETRIES attempts:
+ * each counter is still valid on its own.
+ *
+ * A slot is freed after the request completed (see
+ * FileOperation::queryResult) when no further updates are expected. A
+ * writer registers within seq before it checks that the slot still
+ * belongs to its request and Status::add does not reuse a slot with
+ * active writers. Thus an update that races with freeing a slot is
+ * dropped instead of being applied to the request reusing the slot.
+ */
+
+Status::counter_t Status::counter(FsObj::file_state state)
+
+{
+    switch (state) {
+        case FsObj::RESIDENT:
+            return CNT_RESIDENT;
+        case FsObj::TRANSFERRED:
+            return CNT_TRANSFERRED;
+        case FsObj::PREMIGRATED:
+            return CNT_PREMIGRATED;
+        case FsObj::MIGRATED:
+            return CNT_MIGRATED;
+        default:
+            return CNT_NONE;
+    }
+}
+
+Status::slot_t *Status::find(int reqNumber)
+
+{
+    for (int i = 0; i < Const::STATUS_PROBE_LENGTH; i++) {
+        slot_t& slot = slots[(static_cast<unsigned int>(reqNumber) + i)
+                % Const::STATUS_SLOTS];
+        if (slot.reqNumber == reqNumber)
+            return &slot;
+    }
+
+    return nullptr;
+}
+
+void Status::update(int reqNumber, Status::counter_t from,
+        Status::counter_t to)
+
+{
+    slot_t *slot = find(reqNumber);
+
+    if (slot == nullptr) {
+        std::lock_guard<std::mutex> lock(Status::mtx);
+        std::map<int, singleState>::iterator it = allStates.find(reqNumber);
+
+        if (it == allStates.end())
+            return;
+        if (from != CNT_NONE)
+            it->second.num[from]--;
+        if (to != CNT_NONE)
+            it->second.num[to]++;
+        return;
+    }
+
+    slot->seq++;
+    if (slot->reqNumber != reqNumber) {
+        slot->seq--;
+        return;
+    }
+    if (from != CNT_NONE)
+        slot->num[from]--;
+    if (to != CNT_NONE)
+        slot->num[to]++;
+    slot->seq += VERSION_ONE - 1;
+}
+
 void Status::add(int reqNumber)
 
 {
-    SQLStatement stmt;
-    int num;
-    FsObj::file_state migState;
+    std::map<FsObj::file_state, long> num;
 
     std::lock_guard<std::mutex> lock(Status::mtx);
 
     //assert( allStates.count(reqNumber) == 0 );
-    if (allStates.count(reqNumber) != 0)
+    if (find(reqNumber) != nullptr || allStates.count(reqNumber) != 0)
         return;
 
     singleState state;
 
-    stmt(Status::STATUS) << reqNumber;
-    stmt.prepare();
-    while (stmt.step(&migState, &num)) {
-        switch (migState) {
+    jobStore->countStates(reqNumber, &num);
+    for (std::pair<const FsObj::file_state, long>& entry : num) {
+        switch (entry.first) {
             case FsObj::RESIDENT:
             case FsObj::TRANSFERRING:
-                state.resident = num;
+                state.num[CNT_RESIDENT] = entry.second;
                 break;
             case FsObj::TRANSFERRED:
-                state.transferred = num;
+                state.num[CNT_TRANSFERRED] = entry.second;
                 break;
             case FsObj::PREMIGRATED:
             case FsObj::CHANGINGFSTATE:
             case FsObj::RECALLING_PREMIG:
-                state.premigrated = num;
+                state.num[CNT_PREMIGRATED] = entry.second;
                 break;
             case FsObj::MIGRATED:
             case FsObj::RECALLING_MIG:
-                state.migrated = num;
+                state.num[CNT_MIGRATED] = entry.second;
                 break;
             case FsObj::FAILED:
-                state.failed = num;
+                state.num[CNT_FAILED] = entry.second;
                 break;
             default:
-                TRACE(Trace::error, migState);
+                TRACE(Trace::error, entry.first);
         }
     }
-    stmt.finalize();
+
+    for (int i = 0; i < Const::STATUS_PROBE_LENGTH; i++) {
+        slot_t& slot = slots[(static_cast<unsigned int>(reqNumber) + i)
+                % Const::STATUS_SLOTS];
+        if (slot.reqNumber != Const::UNSET
+                || (slot.seq & ACTIVE_MASK) != 0)
+            continue;
+        for (int j = 0; j < NUM_COUNTERS; j++)
+            slot.num[j] = state.num[j];
+        // the slot becomes visible to other threads after it is complete
+        slot.reqNumber = reqNumber;
+        return;
+    }
+
+    TRACE(Trace::normal, reqNumber);
     allStates[reqNumber] = state;
 }
 
@@ -68,92 +166,60 @@ void Status::remove(int reqNumber)
 
 {
     std::lock_guard<std::mutex> lock(Status::mtx);
+    slot_t *slot = find(reqNumber);
 
-    allStates.erase(reqNumber);
+    if (slot != nullptr)
+        slot->reqNumber = Const::UNSET;
+    else
+        allStates.erase(reqNumber);
 }
 
 void Status::updateSuccess(int reqNumber, FsObj::file_state from,
         FsObj::file_state to)
 
 {
-    std::lock_guard<std::mutex> lock(Status::mtx);
-
-    assert(allStates.count(reqNumber) != 0);
-
-    singleState state = allStates[reqNumber];
-
-    switch (from) {
-        case FsObj::RESIDENT:
-            state.resident--;
-            break;
-        case FsObj::TRANSFERRED:
-            state.transferred--;
-            break;
-        case FsObj::PREMIGRATED:
-            state.premigrated--;
-            break;
-        case FsObj::MIGRATED:
-            state.migrated--;
-            break;
-        default:
-            break;
-    }
-
-    switch (to) {
-        case FsObj::RESIDENT:
-            state.resident++;
-            break;
-        case FsObj::TRANSFERRED:
-            state.transferred++;
-            break;
-        case FsObj::PREMIGRATED:
-            state.premigrated++;
-            break;
-        case FsObj::MIGRATED:
-            state.migrated++;
-            break;
-        default:
-            break;
-    }
-
-    allStates[reqNumber] = state;
+    update(reqNumber, counter(from), counter(to));
 }
 
 void Status::updateFailed(int reqNumber, FsObj::file_state from)
 
 {
-    std::lock_guard<std::mutex> lock(Status::mtx);
-
-    singleState state = allStates[reqNumber];
-
-    switch (from) {
-        case FsObj::RESIDENT:
-            state.resident--;
-            break;
-        case FsObj::PREMIGRATED:
-            state.premigrated--;
-            break;
-        case FsObj::MIGRATED:
-            state.migrated--;
-            break;
-        default:
-            break;
-    }
+    counter_t cnt = counter(from);
 
-    state.failed++;
-
-    allStates[reqNumber] = state;
+    update(reqNumber, cnt == CNT_TRANSFERRED ? CNT_NONE : cnt, CNT_FAILED);
 }
 
 void Status::get(int reqNumber, long *resident, long *transferred,
         long *premigrated, long *migrated, long *failed)
 
 {
-    std::lock_guard<std::mutex> lock(Status::mtx);
+    singleState state;
+    slot_t *slot = find(reqNumber);
+
+    if (slot == nullptr) {
+        std::lock_guard<std::mutex> lock(Status::mtx);
+        std::map<int, singleState>::iterator it = allStates.find(reqNumber);
+        if (it != allStates.end())
+            state = it->second;
+    } else {
+        for (int retries = 0;; retries++) {
+            unsigned long seq = slot->seq;
+            if ((seq & ACTIVE_MASK) == 0
+                    || retries >= Const::STATUS_READ_RETRIES) {
+                for (int i = 0; i < NUM_COUNTERS; i++)
+                    state.num[i] = slot->num[i];
+                if (slot->seq == seq || retries >= Const::STATUS_READ_RETRIES)
+                    break;
+            }
+            std::this_thread::yield();
+        }
+        if (slot->reqNumber != reqNumber)
+            state = singleState();
+    }
 
-    *resident = allStates[reqNumber].resident;
-    *transferred = allStates[reqNumber].transferred;
-    *premigrated = allStates[reqNumber].premigrated;
-    *migrated = allStates[reqNumber].migrated;
-    *failed = allStates[reqNumber].failed;
+    *resident = state.num[CNT_RESIDENT];
+    *transferred = state.num[CNT_TRANSFERRED];
+    *premigrated = state.num[CNT_PREMIGRATED];
+    *migrated = state.num[CNT_MIGRATED];
+    *failed = state.num[CNT_FAILED];
 }
@@ -19,21 +19,46 @@
 class Status
 {
 private:
+    enum counter_t
+    {
+        CNT_RESIDENT,
+        CNT_TRANSFERRED,
+        CNT_PREMIGRATED,
+        CNT_MIGRATED,
+        CNT_FAILED,
+        NUM_COUNTERS,
+        CNT_NONE = -1
+    };
+    static const unsigned long ACTIVE_MASK = 0xffffffffUL;
+    static const unsigned long VERSION_ONE = 0x100000000UL;
+
+    // one cache line per request
+    struct alignas(64) slot_t
+    {
+        std::atomic<long> reqNumber;
+        std::atomic<unsigned long> seq;
+        std::atomic<long> num[NUM_COUNTERS];
+    };
     struct singleState
     {
-        long resident = 0;
-        long transferred = 0;
-        long premigrated = 0;
-        long migrated = 0;
-        long failed = 0;
+        long num[NUM_COUNTERS] = { };
     };
+    slot_t slots[Const::STATUS_SLOTS];
     std::map<int, singleState> allStates;
     std::mutex mtx;
 
-    static const std::string STATUS;
+    static counter_t counter(FsObj::file_state state);
+    slot_t *find(int reqNumber);
+    void update(int reqNumber, counter_t from, counter_t to);
 public:
     Status()
     {
+        for (slot_t& slot : slots) {
+            slot.reqNumber = Const::UNSET;
+            slot.seq = 0;
+            for (std::atomic<long>& num : slot.num)
+                num = 0;
+        }
     }
     void add(int reqNumber);
     void remove(int reqNumber);
@@ -16,16 +16,20 @@
  *******************************************************************************/
 #include "ServerIncludes.h"
 
-void SubServer::waitThread(std::string label, std::shared_future<void> task,
-        std::shared_future<void> prev_waiter)
+void SubServer::execute(std::shared_ptr<SubServer::Hold> hold,
+        std::shared_ptr<std::packaged_task<void()>> task)
 
 {
-    int countb;
+    Executor::setThreadName(hold->label);
 
-    TRACE(Trace::always, label);
+    TRACE(Trace::always, hold->label);
+
+    current() = hold.get();
+    (*task)();
+    current() = nullptr;
 
     try {
-        task.get();
+        task->get_future().get();
     } catch (const std::exception& e) {
         MSG(LTFSDMS0074E, e.what());
         TRACE(Trace::always, e.what());
@@ -33,37 +37,41 @@ void SubServer::waitThread(std::string label, std::shared_future<void> task,
         Connector::forcedTerminate = true;
         kill(getpid(), SIGUSR1);
     }
+}
 
-    countb = --count;
+void SubServer::Hold::resume(std::function<void()> func)
 
-    if (countb < maxThreads) {
-        bcond.notify_one();
-    }
+{
+    std::shared_ptr<std::packaged_task<void()>> task = std::make_shared<
+            std::packaged_task<void()>>(func);
 
-    if (!countb) {
-        econd.notify_one();
-    }
+    Executor::instance().submit(subs->group,
+            std::bind(&SubServer::execute, subs, shared_from_this(), task));
+}
 
-    if (prev_waiter.valid() == true) {
-        prev_waiter.get();
-    }
+std::shared_ptr<SubServer::Hold> SubServer::hold()
+
+{
+    if (current() == nullptr)
+        return nullptr;
+
+    return current()->shared_from_this();
+}
+
+void SubServer::complete(std::string label)
+
+{
+    std::lock_guard<std::mutex> lock(mtx);
+
+    TRACE(Trace::full, label, count);
+
+    count--;
+    cond.notify_all();
 }
 
 void SubServer::waitAllRemaining()
 {
-    if (prev_waiter.valid() == true) {
-
-        try {
-            prev_waiter.get();
-        } catch (const std::exception& e) {
-            MSG(LTFSDMS0074E, e.what());
-            TRACE(Trace::always, e.what());
-            Server::forcedTerminate = true;
-            Connector::forcedTerminate = true;
-            kill(getpid(), SIGUSR1);
-        }
-
-        std::unique_lock<std::mutex> lock(emtx);
-        econd.wait(lock, [this] {return count == 0;});
-    }
+    Executor::Blocker blocker;
+    std::unique_lock<std::mutex> lock(mtx);
+    cond.wait(lock, [this] {return count == 0;});
 }
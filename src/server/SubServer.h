@@ -18,117 +18,125 @@
 
 /** @page standard_thread SubServer
 
-    The SubServer class is designated as a facility to start threads
-    and wait for their completion. It has the following capabilities:
+    The SubServer class is designated as a facility to execute functions
+    asynchronously and wait for their completion. It has the following
+    capabilities:
 
-    - It is possible to set a maximum number of threads. Further thread
-      creation is blocked if this limit is hit.
-    - A name can be specified for each thread to be created by calling
-      the SubServer::enqueue method.
-    - The method SubServer::waitAllRemaining blocks until all threads
+    - It is possible to set a maximum number of functions that are
+      executed concurrently. SubServer::enqueue blocks if this limit is
+      hit.
+    - A name can be specified for each function to be executed by
+      calling the SubServer::enqueue method. It is set as thread name
+      while the function is executed.
+    - The method SubServer::waitAllRemaining blocks until all functions
       are finished.
 
-    For each thread to be executed a waiter thread is created. This waiter
-    joins joins the following threads:
-
-    - the thread that has been newly started
-    - if it is not the first thread it waits for the previous waiter to
-      complete.
-
-    This additional waiter was necessary because of this upper limit of
-    number of threads. A simpler implementation would be to have a
-    vector of threads and join all of them at the when waiting for
-    completion. In this case there would be no control about when
-    a thread finished his work.
-
-    @dot
-    digraph sub_server {
-        compound=yes;
-        fontname="courier";
-        fontsize=11;
-        labeljust=l;
-        node [shape=record, width=1, fontname="courier", fontsize=11, fillcolor=white, style=filled];
-        style=solid;
-        sub_server [fontname="courier bold", fontcolor=dodgerblue4, label="SubServer", URL="@ref SubServer"];
-        subgraph cluster_1 {
-            thread_1 [label="thread 1"];
-            waiter_1 [label="waiter 1"];
-        }
-        subgraph cluster_2 {
-            thread_2 [label="thread 2"];
-            waiter_2 [label="waiter 2"];
-        }
-        subgraph cluster_3 {
-            thread_3 [label="thread 3"];
-            waiter_3 [label="waiter 3"];
-        }
-        subgraph cluster_n {
-            thread_n [label="..."];
-            waiter_n [label="..."];
-        }
-        thread_1 -> waiter_1 -> thread_2 -> waiter_2 -> thread_3 -> waiter_3 -> thread_n -> waiter_n [style=invis]; // work around
-        sub_server:s -> thread_1:n [lhead=cluster_1, fontname="courier", fontsize=8, fontcolor=dodgerblue4, label="enqueue", URL="@ref SubServer::enqueue"];
-        sub_server:s -> thread_2:n [lhead=cluster_2, fontname="courier", fontsize=8, fontcolor=dodgerblue4, label="enqueue", URL="@ref SubServer::enqueue"];
-        sub_server:s -> thread_3:n [lhead=cluster_3, fontname="courier", fontsize=8, fontcolor=dodgerblue4, label="enqueue", URL="@ref SubServer::enqueue"];
-        sub_server:s -> thread_n:n [lhead=cluster_n, style=dotted];
-        waiter_1 -> thread_1 [label="join"];
-        waiter_2 -> thread_2 [label="1st join"];
-        waiter_3 -> thread_3 [label="1st join"];
-        waiter_n -> thread_n [style=dotted];
-        waiter_n -> waiter_3 [style=dotted, minlen=2];
-        waiter_3 -> waiter_2 -> waiter_1 [label="2nd join",minlen=2];
-    }
-    @enddot
+    The functions are executed as blocking tasks of the @ref executor
+    "Executor", the SubServer corresponds to a task group. When a
+    function completes the number of remaining functions is counted down
+    and SubServer::waitAllRemaining waits until this number becomes zero.
+    No thread is occupied to wait for a function to complete.
 
+    If a function throws an exception the backend is terminated: the
+    flags Server::forcedTerminate and Connector::forcedTerminate are set
+    and the signal SIGUSR1 is sent to the backend.
 
+    A function that would wait for the tasks of a ThreadPool can instead
+    continue with a further function when these tasks have completed
+    (SubServer::continueAfter). In between no thread is occupied. Each
+    enqueued function is represented by a SubServer::Hold object: the
+    function counts as finished when the last reference to it is
+    released, i.e. after the function and all of its continuations
+    have completed. Continuations are executed like the function itself
+    including the thread name and the exception handling. If
+    SubServer::continueAfter is not called within a function executed by
+    a SubServer it waits for the tasks and calls the continuation
+    directly. See @ref migration for an example.
  */
 
 class SubServer
 {
+public:
+    class Hold: public std::enable_shared_from_this<Hold>
+    {
+        friend class SubServer;
+    private:
+        SubServer *subs;
+        const std::string label;
+    public:
+        Hold(SubServer *_subs, std::string _label) :
+                subs(_subs), label(_label)
+        {
+        }
+        ~Hold()
+        {
+            subs->complete(label);
+        }
+        void resume(std::function<void()> func);
+    };
 private:
-    std::atomic<int> count;
-    std::atomic<int> maxThreads;
-    std::mutex emtx;
-    std::condition_variable econd;
-    std::mutex bmtx;
-    std::condition_variable bcond;
-    std::shared_future<void> prev_waiter;
-    void waitThread(std::string label, std::shared_future<void> thrd,
-            std::shared_future<void> prev_waiter);
+    int count;
+    const int maxThreads;
+    std::mutex mtx;
+    std::condition_variable cond;
+    const std::shared_ptr<Executor::Group> group;
+    static Hold *& current()
+    {
+        static thread_local Hold *hold = nullptr;
+        return hold;
+    }
+    void execute(std::shared_ptr<Hold> hold,
+            std::shared_ptr<std::packaged_task<void()>> task);
+    void complete(std::string label);
 public:
     SubServer() :
-            count(0), maxThreads(INT_MAX)
+            SubServer(INT_MAX)
     {
     }
     SubServer(int _maxThreads) :
-            count(0), maxThreads(_maxThreads)
+            count(0), maxThreads(_maxThreads), group(
+                    Executor::instance().createGroup("subs", Executor::NORMAL,
+                            _maxThreads, true))
+    {
+    }
+    ~SubServer()
     {
+        waitAllRemaining();
     }
 
     void waitAllRemaining();
 
+    static std::shared_ptr<Hold> hold();
+
+    template<typename Pool>
+    static void continueAfter(Pool *pool, int reqNum,
+            std::function<void()> next)
+    {
+        std::shared_ptr<Hold> held = hold();
+
+        if (held == nullptr) {
+            pool->waitCompletion(reqNum);
+            next();
+            return;
+        }
+
+        pool->whenComplete(reqNum, [held, next] {held->resume(next);});
+    }
+
     template<typename Function, typename ... Args>
     void enqueue(std::string label, Function&& f, Args ... args)
     {
-        int countb;
-        char threadName[64];
-        std::unique_lock < std::mutex > lock(bmtx);
-
-        countb = ++count;
+        std::shared_ptr<std::packaged_task<void()>> task = std::make_shared<
+                std::packaged_task<void()>>(std::bind(f, args ...));
 
-        if (countb >= maxThreads) {
-            bcond.wait(lock);
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            cond.wait(lock, [this] {return count < maxThreads;});
+            count++;
         }
 
-        memset(threadName, 0, 64);
-        pthread_getname_np(pthread_self(), threadName, 63);
-        pthread_setname_np(pthread_self(), label.c_str());
-        std::shared_future<void> task = std::async(std::launch::async, f,
-                args ...);
-        pthread_setname_np(pthread_self(), (std::string("w:") + label).c_str());
-        std::shared_future<void> waiter = std::async(std::launch::async,
-                &SubServer::waitThread, this, label, task, prev_waiter);
-        pthread_setname_np(pthread_self(), threadName);
-        prev_waiter = waiter;
+        Executor::instance().submit(group,
+                std::bind(&SubServer::execute, this,
+                        std::make_shared<Hold>(this, label), task));
     }
 };
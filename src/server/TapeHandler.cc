@@ -29,8 +29,8 @@ void TapeHandler::addRequest()
 
     stmt(TapeHandler::ADD_REQUEST)
             << (op == TapeHandler::FORMAT ? DataBase::FORMAT : DataBase::CHECK)
-            << reqNumber << Const::UNSET << tapeId << poolName << time(NULL)
-            << DataBase::REQ_NEW;
+            << reqNumber << Const::UNSET << tapeId << poolName
+            << DataBase::timeAdded() << DataBase::REQ_NEW;
 
     TRACE(Trace::normal, stmt.str());
 
@@ -42,6 +42,11 @@ void TapeHandler::execRequest()
 {
     std::shared_ptr<LTFSDMCartridge> cart;
     SQLStatement stmt;
+    Metrics::Timer timer("scheduler",
+            std::string("exec ")
+                    + DataBase::opStr(
+                            op == TapeHandler::FORMAT ?
+                                    DataBase::FORMAT : DataBase::CHECK));
 
     TRACE(Trace::always, op, driveId, tapeId, poolName);
 
@@ -26,7 +26,7 @@ void TapeMover::addRequest()
     TRACE(Trace::always, op, tapeId, driveId);
 
     stmt(TapeMover::ADD_REQUEST) << op << reqNumber << Const::UNSET << tapeId
-            << driveId << time(NULL) << DataBase::REQ_NEW;
+            << driveId << DataBase::timeAdded() << DataBase::REQ_NEW;
 
     TRACE(Trace::normal, stmt.str());
 
@@ -52,9 +52,15 @@ void TapeMover::execRequest()
         cart->setState(LTFSDMCartridge::TAPE_MOVING);
 
         if (op == TapeMover::UNMOUNT) {
+            Metrics::Timer timer("scheduler", "unmount " + driveId);
             inventory->unmount(driveId, tapeId);
+            metrics.increment("scheduler", "unmounts");
         } else {
+            Metrics::Timer timer("scheduler",
+                    (op == TapeMover::MOVE ? "move " : "mount ") + driveId);
             inventory->mount(driveId, tapeId, op);
+            metrics.increment("scheduler",
+                    op == TapeMover::MOVE ? "moves" : "mounts");
         }
 
         stmt(TapeMover::DELETE_REQUEST) << reqNum;
@@ -18,15 +18,22 @@
 
 /** @page thread_pool ThreadPool
 
-    The ThreadPool class is designated as a facility to start threads
-    and wait for their completion. It has the following capabilities
-    and limitations:
+    The ThreadPool class is designated as a facility to execute a
+    function asynchronously and to wait for its completion. It has the
+    following capabilities and limitations:
 
     - Only a single function can be specified to be executed by the
       threads, parameters can be different.
     - A single name can be specified for the threads.
-    - A thread can be reused up to 10 seconds of inactivity. Thereafter
-      it will terminate.
+    - The tasks are executed by the threads of the @ref executor
+      "Executor" that is shared by all ThreadPool objects. The maximum
+      number of threads is the number of tasks of this ThreadPool that
+      are executed concurrently.
+    - Tasks that have not been started yet are limited in number.
+      ThreadPool::enqueue returns immediately if this limit has not been
+      reached, otherwise it waits until a task has been started. The
+      time it waits is recorded as "enqueue wait" of the pool (see
+      @ref metrics).
 
     For the constructor of the class the following parameters need to
     be specified:
@@ -34,15 +41,31 @@
     - the function to be executed
     - the maximum number of threads
     - the name of the threads
-
-    A new thread can be enqueued with the ThreadPool::enqueue method.
+    - optionally the maximum number of tasks that have not been started
+      (default Const::THREAD_POOL_QUEUE_SIZE). It determines how far a
+      producer can run ahead of the threads before it is slowed down.
+    - optionally the priority of the tasks (default Executor::NORMAL)
+    - optionally if the tasks block (default true), see @ref executor.
+      Only tasks that neither wait for other tasks nor for events
+      outside the backend should be specified as not blocking.
+
+    A new task is enqueued with the ThreadPool::enqueue method.
     Only the function (that has been specified with the constructor)
     parameters and if necessary (if not Const::UNSET should be specified)
-    a request number as a first parameter. For ThreadPool::waitCompletion
-    method a request number can be specified to wait only for for specific
-    request to finish (if not Const::UNSET should be specified). This only is
-    the case for those ThreadPools that perform tasks for different request at
-    the same time.
+    a request number as a first parameter. The parameters are copied.
+    For ThreadPool::waitCompletion method a request number can be
+    specified to wait only for for specific request to finish (if not
+    Const::UNSET should be specified). It waits for all tasks of that
+    request including the ones that have not been started yet. This only
+    is the case for those ThreadPools that perform tasks for different
+    request at the same time. The tasks of each request are counted by
+    a separate Latch: completing a task only wakes up the threads that
+    wait for the same request.
+
+    Instead of waiting ThreadPool::whenComplete registers a function
+    that is called when all tasks of a request have completed. It is
+    used by SubServer::continueAfter to continue the processing of a
+    request without occupying a thread in the meantime.
 
     The ThreadPool is used by doing the following three steps:
 
@@ -54,149 +77,149 @@
     - Wait for all threads to complete by using the ThreadPool::waitCompletion
       method.
 
+    If the ThreadPool is destroyed it waits for all of its tasks to
+    complete. The program test/threadpool_bench.cc measures the number
+    of tasks per second.
+
  */
 
 template<typename ... Args> class ThreadPool
 {
 private:
-    std::mutex enqueue_mtx; // seems to be necessary
-
-    std::mutex mtx_main;
-    std::condition_variable cond_main;
-    std::condition_variable cond_init;
-    std::mutex mtx_resp;
-    std::condition_variable cond_resp;
-    std::condition_variable cond_cont;
+    std::mutex mtx;
+    std::condition_variable cond_space;
     std::condition_variable cond_fin;
 
-    std::packaged_task<void()> task;
-    std::atomic<int> started;
-    std::atomic<int> occupied;
-    std::atomic<bool> new_work;
-    std::atomic<int> global_req_num;
-    std::map<int, long> numJobs;
+    std::map<int, std::shared_ptr<Latch>> latches;
+    unsigned long queued;
+    long active;
 
     const std::function<void(Args ... args)> func;
-    const int num_thrds;
-    std::atomic<int> num_thrds_started;
-    std::thread *new_thread;
-    std::thread *last_thread;
-    const std::string name;
+    const unsigned long queue_size;
+    const std::shared_ptr<Executor::Group> group;
 
-    void threadfunc()
+    void execute(std::shared_ptr<Latch> latch,
+            std::shared_ptr<std::packaged_task<void()>> task)
     {
-        int req_num;
-        std::thread *t = last_thread;
-
-        pthread_setname_np(pthread_self(), name.c_str());
-
-        std::packaged_task < void() > ltask;
-        std::unique_lock < std::mutex > lock(mtx_main);
-        started++;
-        cond_init.notify_one();
-
-        while (true) {
-            cond_main.wait_for(lock, Const::IDLE_THREAD_LIVE_TIME);
-            if (new_work == false) {
-                lock.unlock();
-                if (t == nullptr) {
-                    num_thrds_started--;
-                    cond_main.notify_all();
-                    return;
-                }
-                num_thrds_started--;
-                cond_main.notify_all();
-                t->join();
-                delete (t);
-                return;
-            }
-            new_work = false;
-            occupied++;
-            req_num = global_req_num;
-            numJobs[req_num]++;
-
-            ltask = std::move(task);
-
-            lock.unlock();
-
-            std::unique_lock < std::mutex > lock2(mtx_resp);
-            cond_resp.notify_one();
-            lock2.unlock();
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            queued--;
+            cond_space.notify_one();
+        }
 
-            ltask();
-            ltask.reset();
+        (*task)();
+        task.reset();
 
-            lock.lock();
+        latch->done();
 
-            occupied--;
-            numJobs[req_num]--;
+        // the destructor may proceed as soon as the lock is released
+        std::lock_guard<std::mutex> lock(mtx);
+        if (--active == 0)
             cond_fin.notify_all();
-            if (occupied == num_thrds - 1)
-                cond_cont.notify_one();
-        }
     }
 
 public:
     ThreadPool(std::function<void(Args ... args)> func_, int num_thrds_,
-            std::string name_) :
-            started(0), occupied(0), new_work(false), func(func_), num_thrds(
-                    num_thrds_), num_thrds_started(0), new_thread(nullptr), last_thread(
-                    nullptr), name(name_)
+            std::string name_, unsigned long queue_size_ =
+                    Const::THREAD_POOL_QUEUE_SIZE, Executor::priority prio =
+                    Executor::NORMAL, bool blocking = true) :
+            queued(0), active(0), func(func_), queue_size(queue_size_), group(
+                    Executor::instance().createGroup(name_, prio, num_thrds_,
+                            blocking))
 
     {
     }
 
     void enqueue(int req_num, Args ... args)
     {
-        std::lock_guard < std::mutex > elock(enqueue_mtx);
-        std::unique_lock < std::mutex > lock(mtx_main);
-        new_work = true;
-        if (occupied == num_thrds)
-            cond_cont.wait(lock);
-
-        if (num_thrds_started == occupied) {
-            new_thread = new std::thread(&ThreadPool::threadfunc, this);
-            num_thrds_started++;
-            cond_init.wait(lock);
-            last_thread = new_thread;
-            new_thread = nullptr;
+        std::shared_ptr<std::packaged_task<void()>> task = std::make_shared<
+                std::packaged_task<void()>>(std::bind(func, args ...));
+        std::shared_ptr<Latch> latch;
+        std::chrono::steady_clock::time_point start;
+        bool blocked = false;
+
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            if (queued >= queue_size) {
+                start = std::chrono::steady_clock::now();
+                blocked = true;
+                cond_space.wait(lock, [this] {return queued < queue_size;});
+            }
+            queued++;
+            active++;
+            latch = latches[req_num];
+            if (latch == nullptr) {
+                latch = std::make_shared<Latch>();
+                latches[req_num] = latch;
+            }
+            latch->add();
         }
 
-        global_req_num = req_num;
-
-        std::packaged_task < void() > task_(std::bind(func, args ...));
-        task = std::move(task_);
+        if (blocked)
+            group->addEnqueueWait(std::chrono::steady_clock::now() - start);
 
-        std::unique_lock < std::mutex > lock2(mtx_resp);
-        cond_main.notify_one();
-        lock.unlock();
-        cond_resp.wait(lock2);
+        Executor::instance().submit(group,
+                std::bind(&ThreadPool::execute, this, latch, task));
     }
 
     void waitCompletion(int req_num)
 
     {
-        std::unique_lock < std::mutex > lock(mtx_main);
-        cond_fin.wait(lock, [this, req_num] {return numJobs[req_num] == 0;});
-        numJobs.erase(req_num);
+        std::shared_ptr<Latch> latch;
+
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            auto it = latches.find(req_num);
+            if (it == latches.end())
+                return;
+            latch = it->second;
+        }
+
+        {
+            Executor::Blocker blocker;
+            latch->wait();
+        }
+
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = latches.find(req_num);
+        if (it != latches.end() && it->second == latch
+                && latch->remaining() == 0)
+            latches.erase(it);
     }
 
-    ~ThreadPool()
+    // the continuation is called by the thread that completes the last task
+    void whenComplete(int req_num, std::function<void()> cont)
+
     {
-        if (last_thread != nullptr) {
-            try {
-                std::unique_lock < std::mutex > lock(mtx_main);
-
-                cond_main.wait(lock, [this] {return num_thrds_started == 0;});
-                last_thread->join();
-                delete (last_thread);
-                last_thread = nullptr;
-            } catch (const std::exception& e) {
-                TRACE(Trace::error, e.what());
-                MSG(LTFSDMS0074E, e.what());
-            }
+        std::shared_ptr<Latch> latch;
+
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            auto it = latches.find(req_num);
+            if (it != latches.end())
+                latch = it->second;
         }
 
-        return;
+        if (latch == nullptr) {
+            cont();
+            return;
+        }
+
+        latch->then([this, req_num, latch, cont] {
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                auto it = latches.find(req_num);
+                if (it != latches.end() && it->second == latch
+                        && latch->remaining() == 0)
+                    latches.erase(it);
+            }
+            cont();
+        });
+    }
+
+    ~ThreadPool()
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        cond_fin.wait(lock, [this] {return active == 0;});
     }
 };
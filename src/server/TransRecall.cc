@@ -87,11 +87,12 @@
        socket for recall events. Recall events are are initiated by
        applications that perform read, write, or truncate calls on a
        premigrated or migrated files. A corresponding
-       job is created within the JOB_QUEUE table and - if it does not exist - a
+       job is added to the @ref job_store and - if it does not exist - a
        request is created within the REQUEST_QUEUE table.
     2. The Scheduler identifies a transparent recall request to get scheduled.
        The order of files being recalled depends on the starting block of
-       the data files on tape: @snippet server/SQLStatements.cc trans_recall_sql_qry
+       the data files on tape (see JobStore::select, for the SQLite job
+       store: @snippet server/SQLStatements.cc select_jobs_sql_qry )
        If the transparent recall job is finally processed (even it is failed)
        the event is responded  as a Protocol Buffers message
        (LTFSDmProtocol::LTFSDmTransRecResp).
@@ -167,9 +168,17 @@
     no optimization if the file has been migrated to more than one tape to
     select between these tapes in an optimal way.
 
-    To add a corresponding job within the JOB_QUEUE table or if necessary
-    a request within the REQUEST_QUEUE table an additional thread is used
-    as part of the ThreadPool wqr executing the method TransRecall::addJob.
+    The connector does not block on a single event: the Fuse connector
+    multiplexes all connections of outstanding events (see @ref fuse_connector)
+    and only keeps a file descriptor for each event that needs to be
+    responded. All events that are available without waiting
+    (Connector::eventsPending), at most Const::TRANSPARENT_RECALL_BATCH,
+    are collected. To add the corresponding jobs within the JOB_QUEUE
+    table and if necessary the requests within the REQUEST_QUEUE table
+    the collected events are passed to the ThreadPool wqr executing the
+    method TransRecall::addJobs. The jobs are added within a single
+    JobStore::Batch and each request is only checked once. The pool uses
+    Const::TRANSPARENT_RECALL_THREADS threads.
 
     This is an example of these two tables in case of transparently recalling a few files:
 
@@ -197,18 +206,22 @@
         - wait for events: Connector::getEvents
         - create FsObj object according the recall information recinfo
         - determine the id of the first cartridge from the attributes
-        - enqueue the job and request creation   as part of the
-          ThreadPool wqr executing the method TransRecall::addJob.
+        - collect the event
+        - if no further event is pending or the batch is full: enqueue
+          the job and request creation as part of the ThreadPool wqr
+          executing the method TransRecall::addJobs.
 
     </TT>
     <TT>
-    TransRecall::addJob:
-    - determine path name on tape
-    - add a job within the JOB_QUEUE table
-    - if a request already exists: if (reqExists == true)
-        - change request state to new
-    - else
-        - create a request within the REQUEST_QUEUE table
+    TransRecall::addJobs:
+    - for each event: determine path name on tape (TransRecall::createJob)
+    - within a JobStore::Batch
+        - add the jobs within the JOB_QUEUE table
+        - for each request number:
+            - if a request already exists: if (reqExists == true)
+                - change request state to new
+            - else
+                - create a request within the REQUEST_QUEUE table
 
     </TT>
 
@@ -299,22 +312,22 @@
     -# The attributes on the disk file are updated or removed in the case of target state resident.
  */
 
-void TransRecall::addJob(Connector::rec_info_t recinfo, std::string tapeId,
-        long reqNum)
+/*
+ * Determines the job of a recall event. Returns false if the event
+ * already has been responded and no job needs to be added.
+ */
+bool TransRecall::createJob(Connector::rec_info_t recinfo, std::string tapeId,
+        long reqNum, JobStore::job_t *job)
 
 {
     struct stat statbuf;
-    SQLStatement stmt;
     std::string tapeName;
-    int state;
     FsObj::mig_target_attr_t attr;
-    std::string filename;
-    bool reqExists = false;
 
-    if (recinfo.filename.compare("") == 0)
-        filename = "NULL";
-    else
-        filename = std::string("'") + recinfo.filename + "'";
+    *job = JobStore::job_t { DataBase::TRARECALL, recinfo.filename, reqNum,
+            recinfo.toresident ? FsObj::RESIDENT : FsObj::PREMIGRATED,
+            Const::UNSET, "", 0, recinfo.fuid, 0, 0, time(NULL), tapeId,
+            FsObj::FAILED, 0, (std::intptr_t) recinfo.conn_info };
 
     try {
         FsObj fso(recinfo);
@@ -322,93 +335,142 @@ void TransRecall::addJob(Connector::rec_info_t recinfo, std::string tapeId,
 
         if (!S_ISREG(statbuf.st_mode)) {
             MSG(LTFSDMS0032E, recinfo.fuid.inum);
-            return;
+            Connector::respondRecallEvent(recinfo, false);
+            return false;
         }
 
-        state = fso.getMigState();
+        job->state = fso.getMigState();
 
-        if (state == FsObj::RESIDENT) {
+        if (job->state == FsObj::RESIDENT) {
             MSG(LTFSDMS0031I, recinfo.fuid.inum);
             Connector::respondRecallEvent(recinfo, true);
-            return;
+            return false;
         }
 
         attr = fso.getAttribute();
 
+        job->fileSize = statbuf.st_size;
+        job->mtimeSec = statbuf.st_mtime;
+        job->startBlock = attr.tapeInfo[0].startBlock;
+
         tapeName = Server::getTapeName(recinfo.fuid.fsid_h, recinfo.fuid.fsid_l,
                 recinfo.fuid.igen, recinfo.fuid.inum, tapeId);
     } catch (const std::exception& e) {
         TRACE(Trace::error, e.what());
-        if (filename.compare("NULL") != 0)
-            MSG(LTFSDMS0073E, filename);
+        if (recinfo.filename.compare("") != 0)
+            MSG(LTFSDMS0073E, recinfo.filename);
         else
             MSG(LTFSDMS0032E, recinfo.fuid.inum);
     }
 
-    stmt(TransRecall::ADD_JOB) << DataBase::TRARECALL << filename.c_str()
-            << reqNum
-            << (recinfo.toresident ? FsObj::RESIDENT : FsObj::PREMIGRATED)
-            << Const::UNSET << statbuf.st_size << recinfo.fuid.fsid_h
-            << recinfo.fuid.fsid_l << recinfo.fuid.igen << recinfo.fuid.inum
-            << statbuf.st_mtime << 0 << time(NULL) << state << tapeId
-            << attr.tapeInfo[0].startBlock << (std::intptr_t) recinfo.conn_info;
+    return true;
+}
 
-    TRACE(Trace::normal, stmt.str());
+/*
+ * The jobs of all events that have been received together are added
+ * within a single JobStore::Batch. The requests are checked and created
+ * once per request number instead of once per event.
+ */
+void TransRecall::addJobs(std::vector<TransRecall::event_t> events)
 
-    stmt.doall();
+{
+    SQLStatement stmt;
+    std::vector<JobStore::job_t> jobs;
+    std::vector<Connector::rec_info_t> failed;
+    std::map<long, std::string> requests;
+    JobStore::job_t job;
+    bool reqExists;
+    int state;
 
-    if (filename.compare("NULL") != 0)
-        TRACE(Trace::always, filename);
-    else
-        TRACE(Trace::always, recinfo.fuid.inum);
+    for (TransRecall::event_t& event : events)
+        if (createJob(event.recinfo, event.tapeId, event.reqNum, &job))
+            jobs.push_back(job);
 
-    TRACE(Trace::always, tapeId);
+    if (jobs.size() == 0)
+        return;
 
-    stmt(TransRecall::CHECK_REQUEST_EXISTS) << reqNum;
-    stmt.prepare();
-    while (stmt.step())
-        reqExists = true;
-    stmt.finalize();
+    {
+        JobStore::Batch batch;
 
-    if (reqExists == true) {
-        stmt(TransRecall::CHANGE_REQUEST_TO_NEW) << DataBase::REQ_NEW << reqNum
-                << tapeId;
-        TRACE(Trace::normal, stmt.str());
-        stmt.doall();
-        Scheduler::invoke();
-    } else {
-        stmt(TransRecall::ADD_REQUEST) << DataBase::TRARECALL << reqNum
-                << Const::UNSET << attr.tapeInfo[0].tapeId << time(NULL)
-                << DataBase::REQ_NEW;
-        TRACE(Trace::normal, stmt.str());
-        stmt.doall();
-        Scheduler::invoke();
+        for (const JobStore::job_t& job : jobs) {
+            try {
+                jobStore->add(job);
+            } catch (const std::exception& e) {
+                TRACE(Trace::error, e.what(), job.fuid.inum);
+                failed.push_back(
+                        (Connector::rec_info_t ) {
+                                        (struct conn_info_t *) job.connInfo,
+                                        job.targetState == FsObj::RESIDENT,
+                                        job.fuid, job.fileName });
+                continue;
+            }
+
+            if (job.fileName.compare("") != 0)
+                TRACE(Trace::always, job.fileName, job.tapeId);
+            else
+                TRACE(Trace::always, job.fuid.inum, job.tapeId);
+
+            requests[job.reqNumber] = job.tapeId;
+        }
+
+        for (std::pair<const long, std::string>& request : requests) {
+            reqExists = false;
+
+            stmt(TransRecall::CHECK_REQUEST_EXISTS) << request.first;
+            stmt.prepare();
+            while (stmt.step(&state))
+                reqExists = true;
+            stmt.finalize();
+
+            if (reqExists == true) {
+                if (state != DataBase::REQ_NEW)
+                    Scheduler::requeued(DataBase::TRARECALL, request.first,
+                            Const::UNSET, request.second);
+                stmt(TransRecall::CHANGE_REQUEST_TO_NEW) << DataBase::REQ_NEW
+                        << request.first << request.second;
+            } else
+                stmt(TransRecall::ADD_REQUEST) << DataBase::TRARECALL
+                        << request.first << Const::UNSET << request.second
+                        << DataBase::timeAdded() << DataBase::REQ_NEW;
+            TRACE(Trace::normal, stmt.str());
+            stmt.doall();
+        }
     }
+
+    for (Connector::rec_info_t& recinfo : failed)
+        Connector::respondRecallEvent(recinfo, false);
+
+    if (requests.size() > 0)
+        Scheduler::invoke();
 }
 
 void TransRecall::cleanupEvents()
 
 {
-    Connector::rec_info_t recinfo;
-    SQLStatement stmt = SQLStatement(TransRecall::REMAINING_JOBS)
-            << DataBase::TRARECALL;
-    TRACE(Trace::normal, stmt.str());
-    stmt.prepare();
-    while (stmt.step(&recinfo.fuid.fsid_h, &recinfo.fuid.fsid_l,
-            &recinfo.fuid.igen, &recinfo.fuid.inum, &recinfo.filename,
-            (std::intptr_t *) &recinfo.conn_info)) {
+    jobStore->list(Const::UNSET, [] (const JobStore::job_t& job) {
+        Connector::rec_info_t recinfo;
+
+        if (job.operation != DataBase::TRARECALL)
+        return true;
+
+        recinfo.fuid = job.fuid;
+        recinfo.filename = job.fileName;
+        recinfo.conn_info = (struct conn_info_t *) job.connInfo;
+        recinfo.toresident = false;
         TRACE(Trace::always, recinfo.filename, recinfo.fuid.inum);
         Connector::respondRecallEvent(recinfo, false);
-    }
-    stmt.finalize();
+        Scheduler::recallRemoved(job.reqNumber);
+        return true;
+    });
 }
 
 void TransRecall::run(std::shared_ptr<Connector> connector)
 
 {
-    ThreadPool<TransRecall, Connector::rec_info_t, std::string, long> wqr(
-            &TransRecall::addJob, Const::MAX_TRANSPARENT_RECALL_THREADS,
-            "trec-wq");
+    ThreadPool<TransRecall, std::vector<TransRecall::event_t>> wqr(
+            &TransRecall::addJobs, Const::TRANSPARENT_RECALL_THREADS,
+            "trec-wq", Const::THREAD_POOL_QUEUE_SIZE, Executor::HIGH, false);
+    std::vector<TransRecall::event_t> events;
     Connector::rec_info_t recinfo;
     std::map<std::string, long> reqmap;
     std::string tapeId;
@@ -452,9 +514,27 @@ void TransRecall::run(std::shared_ptr<Connector> connector)
 
     while (Connector::connectorTerminate == false) {
         try {
+            if (events.size() > 0
+                    && (events.size() >= Const::TRANSPARENT_RECALL_BATCH
+                            || connector->eventsPending() == false)) {
+                wqr.enqueue(Const::UNSET, TransRecall(), events);
+                events.clear();
+            }
             recinfo = connector->getEvents();
         } catch (const std::exception& e) {
             MSG(LTFSDMS0036W, e.what());
+            // back off and re-initialize the event source instead of
+            // failing repeatedly on a broken one
+            sleep(1);
+            try {
+                connector->endTransRecalls();
+                connector->initTransRecalls();
+            } catch (const std::exception& e) {
+                TRACE(Trace::error, e.what());
+                MSG(LTFSDMS0126E);
+                break;
+            }
+            continue;
         }
 
         // is sent for termination
@@ -500,19 +580,18 @@ void TransRecall::run(std::shared_ptr<Connector> connector)
             continue;
         }
 
-        std::stringstream thrdinfo;
-        thrdinfo << "TrRec(" << recinfo.fuid.inum << ")";
-
         if (reqmap.count(tapeId) == 0)
             reqmap[tapeId] = ++globalReqNumber;
 
         TRACE(Trace::always, recinfo.fuid.inum, tapeId, reqmap[tapeId]);
 
-        wqr.enqueue(Const::UNSET, TransRecall(), recinfo, tapeId,
-                reqmap[tapeId]);
+        events.push_back(
+                (TransRecall::event_t ) { recinfo, tapeId, reqmap[tapeId] });
     }
 
     MSG(LTFSDMS0083I);
+    if (events.size() > 0)
+        wqr.enqueue(Const::UNSET, TransRecall(), events);
     connector->endTransRecalls();
     wqr.waitCompletion(Const::UNSET);
     cleanupEvents();
@@ -520,13 +599,15 @@ void TransRecall::run(std::shared_ptr<Connector> connector)
 }
 
 unsigned long TransRecall::recall(Connector::rec_info_t recinfo,
-        std::string tapeId, FsObj::file_state state, FsObj::file_state toState)
+        std::string driveId, std::string tapeId, FsObj::file_state state,
+        FsObj::file_state toState)
 
 {
     struct stat statbuf;
     struct stat statbuf_tape;
     std::string tapeName;
-    char buffer[Const::READ_BUFFER_SIZE];
+    std::shared_ptr<LTFSDMDrive> drive;
+    char *buffer;
     long rsize;
     long wsize;
     int fd = -1;
@@ -549,6 +630,10 @@ unsigned long TransRecall::recall(Connector::rec_info_t recinfo,
         if (state == FsObj::RESIDENT) {
             return 0;
         } else if (state == FsObj::MIGRATED) {
+            if ((drive = inventory->getDrive(driveId)) == nullptr) {
+                TRACE(Trace::error, driveId);
+                THROW(Error::GENERAL_ERROR, driveId);
+            }
             tapeName = Server::getTapeName(recinfo.fuid.fsid_h,
                     recinfo.fuid.fsid_l, recinfo.fuid.igen, recinfo.fuid.inum,
                     tapeId);
@@ -577,28 +662,40 @@ unsigned long TransRecall::recall(Connector::rec_info_t recinfo,
 
             target.prepareRecall();
 
-            while (offset < statbuf.st_size) {
-                if (Server::forcedTerminate)
-                    THROW(Error::GENERAL_ERROR, tapeName);
+            {
+                LTFSDMDrive::Affinity affinity(drive);
+                std::lock_guard<std::mutex> readlock(*drive->mtx);
+                std::chrono::steady_clock::time_point start =
+                        std::chrono::steady_clock::now();
 
-                rsize = read(fd, buffer, sizeof(buffer));
-                if (rsize == 0) {
-                    break;
-                }
-                if (rsize == -1) {
-                    TRACE(Trace::error, errno);
-                    MSG(LTFSDMS0023E, tapeName.c_str());
-                    THROW(Error::GENERAL_ERROR, tapeName, errno);
-                }
-                wsize = target.write(offset, (unsigned long) rsize, buffer);
-                if (wsize != rsize) {
-                    TRACE(Trace::error, errno, wsize, rsize);
-                    MSG(LTFSDMS0033E, recinfo.fuid.inum);
-                    close(fd);
-                    THROW(Error::GENERAL_ERROR, recinfo.fuid.inum, wsize,
-                            rsize);
+                buffer = drive->getBuffer();
+
+                while (offset < statbuf.st_size) {
+                    if (Server::forcedTerminate)
+                        THROW(Error::GENERAL_ERROR, tapeName);
+
+                    rsize = read(fd, buffer, Const::READ_BUFFER_SIZE);
+                    if (rsize == 0) {
+                        break;
+                    }
+                    if (rsize == -1) {
+                        TRACE(Trace::error, errno);
+                        MSG(LTFSDMS0023E, tapeName.c_str());
+                        THROW(Error::GENERAL_ERROR, tapeName, errno);
+                    }
+                    wsize = target.write(offset, (unsigned long) rsize, buffer);
+                    if (wsize != rsize) {
+                        TRACE(Trace::error, errno, wsize, rsize);
+                        MSG(LTFSDMS0033E, recinfo.fuid.inum);
+                        close(fd);
+                        THROW(Error::GENERAL_ERROR, recinfo.fuid.inum, wsize,
+                                rsize);
+                    }
+                    offset += rsize;
                 }
-                offset += rsize;
+
+                drive->transferred(false, offset,
+                        std::chrono::steady_clock::now() - start);
             }
 
             close(fd);
@@ -617,69 +714,62 @@ unsigned long TransRecall::recall(Connector::rec_info_t recinfo,
     return statbuf.st_size;
 }
 
-void TransRecall::processFiles(int reqNum, std::string tapeId)
+void TransRecall::processFiles(int reqNum, std::string driveId,
+        std::string tapeId)
 
 {
-    Connector::rec_info_t recinfo;
-    SQLStatement stmt;
-    FsObj::file_state state;
-    FsObj::file_state toState;
     struct respinfo_t
     {
         Connector::rec_info_t recinfo;bool succeeded;
     };
     std::list<respinfo_t> resplist;
     int numFiles = 0;
-    bool succeeded;
-
-    stmt(TransRecall::SET_RECALLING) << FsObj::RECALLING_MIG << reqNum
-            << FsObj::MIGRATED << tapeId;
-    TRACE(Trace::normal, stmt.str());
-    stmt.doall();
-
-    stmt(TransRecall::SET_RECALLING) << FsObj::RECALLING_PREMIG << reqNum
-            << FsObj::PREMIGRATED << tapeId;
-    TRACE(Trace::normal, stmt.str());
-    stmt.doall();
-
-    stmt(TransRecall::SELECT_JOBS) << reqNum << FsObj::RECALLING_MIG
-            << FsObj::RECALLING_PREMIG << tapeId;
-    TRACE(Trace::normal, stmt.str());
-    stmt.prepare();
-    while (stmt.step(&recinfo.fuid.fsid_h, &recinfo.fuid.fsid_l,
-            &recinfo.fuid.igen, &recinfo.fuid.inum, &recinfo.filename, &state,
-            &toState, (std::intptr_t *) &recinfo.conn_info)) {
-        numFiles++;
-
-        if (state == FsObj::RECALLING_MIG)
-            state = FsObj::MIGRATED;
-        else
-            state = FsObj::PREMIGRATED;
 
-        if (toState == FsObj::RESIDENT)
-            recinfo.toresident = true;
+    TRACE(Trace::normal, reqNum, tapeId);
+    jobStore->changeState(reqNum, tapeId, JobStore::NO_REPL, FsObj::MIGRATED,
+            FsObj::RECALLING_MIG);
+    jobStore->changeState(reqNum, tapeId, JobStore::NO_REPL,
+            FsObj::PREMIGRATED, FsObj::RECALLING_PREMIG);
+
+    jobStore->select(reqNum, tapeId, { FsObj::RECALLING_MIG,
+            FsObj::RECALLING_PREMIG }, 0,
+            [driveId, tapeId, &resplist, &numFiles] (const JobStore::job_t& job) {
+                Connector::rec_info_t recinfo;
+                FsObj::file_state state;
+                FsObj::file_state toState = static_cast<FsObj::file_state>(job.targetState);
+                bool succeeded;
+
+                numFiles++;
+
+                recinfo.fuid = job.fuid;
+                recinfo.filename = job.fileName;
+                recinfo.conn_info = (struct conn_info_t *) job.connInfo;
+                recinfo.toresident = (toState == FsObj::RESIDENT);
+
+                if (job.state == FsObj::RECALLING_MIG)
+                state = FsObj::MIGRATED;
+                else
+                state = FsObj::PREMIGRATED;
 
-        TRACE(Trace::always, recinfo.filename, recinfo.fuid.inum, state,
-                toState);
+                TRACE(Trace::always, recinfo.filename, recinfo.fuid.inum, state,
+                        toState);
 
-        try {
-            recall(recinfo, tapeId, state, toState);
-            succeeded = true;
-        } catch (const std::exception& e) {
-            TRACE(Trace::error, e.what());
-            succeeded = false;
-        }
+                try {
+                    recall(recinfo, driveId, tapeId, state, toState);
+                    succeeded = true;
+                } catch (const std::exception& e) {
+                    TRACE(Trace::error, e.what());
+                    succeeded = false;
+                }
 
-        TRACE(Trace::always, succeeded);
-        resplist.push_back((respinfo_t ) { recinfo, succeeded });
-    }
-    stmt.finalize();
+                TRACE(Trace::always, succeeded);
+                resplist.push_back((respinfo_t ) {recinfo, succeeded});
+                return true;
+            });
     TRACE(Trace::always, numFiles);
 
-    stmt(TransRecall::DELETE_JOBS) << reqNum << FsObj::RECALLING_MIG
-            << FsObj::RECALLING_PREMIG << tapeId;
-    TRACE(Trace::normal, stmt.str());
-    stmt.doall();
+    jobStore->remove(reqNum, tapeId, { FsObj::RECALLING_MIG,
+            FsObj::RECALLING_PREMIG });
 
     for (respinfo_t respinfo : resplist)
         Connector::respondRecallEvent(respinfo.recinfo, respinfo.succeeded);
@@ -691,10 +781,12 @@ void TransRecall::execRequest(int reqNum, std::string driveId,
 {
     SQLStatement stmt;
     int remaining = 0;
+    Metrics::Timer timer("scheduler",
+            std::string("exec ") + DataBase::opStr(DataBase::TRARECALL));
 
     TRACE(Trace::always, reqNum, tapeId);
 
-    processFiles(reqNum, tapeId);
+    processFiles(reqNum, driveId, tapeId);
 
     {
         std::lock_guard<std::recursive_mutex> inventorylock(
@@ -707,19 +799,21 @@ void TransRecall::execRequest(int reqNum, std::string driveId,
         inventory->getDrive(driveId)->setFree();
     }
 
-    stmt(TransRecall::COUNT_REMAINING_JOBS) << reqNum << tapeId;
-    TRACE(Trace::normal, stmt.str());
-    stmt.prepare();
-    while (stmt.step(&remaining)) {
-    }
-    stmt.finalize();
+    remaining = jobStore->count(reqNum, tapeId);
+    TRACE(Trace::normal, remaining);
 
-    if (remaining)
+    if (remaining) {
+        Scheduler::requeued(DataBase::TRARECALL, reqNum, Const::UNSET, tapeId);
         stmt(TransRecall::CHANGE_REQUEST_TO_NEW) << DataBase::REQ_NEW << reqNum
                 << tapeId;
-    else
+    } else {
         stmt(TransRecall::DELETE_REQUEST) << reqNum << tapeId;
+    }
     TRACE(Trace::normal, stmt.str());
     stmt.doall();
+    if (!remaining) {
+        Scheduler::recallRemoved(reqNum);
+        metrics.cancelTimers("scheduler", Scheduler::timerKey(reqNum));
+    }
     Scheduler::invoke();
 }
@@ -20,30 +20,33 @@ class TransRecall
 
 {
 private:
-    static const std::string ADD_JOB;
     static const std::string CHECK_REQUEST_EXISTS;
     static const std::string CHANGE_REQUEST_TO_NEW;
     static const std::string ADD_REQUEST;
-    static const std::string REMAINING_JOBS;
-    static const std::string SET_RECALLING;
-    static const std::string SELECT_JOBS;
-    static const std::string DELETE_JOBS;
-    static const std::string COUNT_REMAINING_JOBS;
     static const std::string DELETE_REQUEST;
 
-    void processFiles(int reqNum, std::string tapeId);
+    void processFiles(int reqNum, std::string driveId, std::string tapeId);
+    bool createJob(Connector::rec_info_t recinfo, std::string tapeId,
+            long reqNum, JobStore::job_t *job);
 public:
+    struct event_t
+    {
+        Connector::rec_info_t recinfo;
+        std::string tapeId;
+        long reqNum;
+    };
+
     TransRecall()
     {
     }
     ~TransRecall()
     {
     }
-    void addJob(Connector::rec_info_t recinfo, std::string tapeId, long reqNum);
+    void addJobs(std::vector<TransRecall::event_t> events);
     void cleanupEvents();
     void run(std::shared_ptr<Connector> connector);
     static unsigned long recall(Connector::rec_info_t recinfo,
-            std::string tapeId, FsObj::file_state state,
+            std::string driveId, std::string tapeId, FsObj::file_state state,
             FsObj::file_state toState);
 
     void execRequest(int reqNum, std::string driveId, std::string tapeId);
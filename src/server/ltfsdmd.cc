@@ -29,7 +29,7 @@
     the
 
     @verbatim
-    ltfsdmd [-f] [-m] [-d <debug level>]
+    ltfsdmd [-f] [-m] [-p] [-s <storage profile>] [-j <job store>] [-d <debug level>]
     @endverbatim
 
     command.
@@ -40,8 +40,30 @@
     :---:|---
     -f | Start the backend in foreground. Messages will be printed out to stdout.
     -m | Store the SQLite database in memory. By default it is stored in "/var/run" which usually is memory mapped.
+    -p | Profile the SQL statements, see @ref ltfsdm_info_sql "ltfsdm info sql".
+    -s | Use a different storage profile for the SQLite database, see below.
+    -j | Keep the jobs in a different job store: "sqlite" (default) or "memory", see @ref job_store.
     -d | Use a different trace level. See @ref tracing_system "tracing" for details of trace levels.
 
+    The storage profile is either the name of a profile or a comma
+    separated list of a profile name followed by settings that override
+    the ones of that profile, e.g. "wal,synchronous=full":
+
+    setting | default | wal | meaning
+    ---|---|---|---
+    journal | SQLite default | WAL | journal mode: delete, truncate, persist, memory or wal
+    synchronous | SQLite default | NORMAL | synchronous level: off, normal or full
+    cache | SQLite default | 65536 | page cache size in KiB per connection
+    mmap | 0 | 256 | memory mapped I/O size in MiB per connection
+    connections | shared | thread | a single connection shared by all threads or a connection per thread
+
+    With a connection per thread SQLite does not need to serialize all
+    database accesses of the backend and readers are not blocked by
+    writers if WAL journaling is used. A database in memory (option -m)
+    is always accessed by a single shared connection. The script
+    test/dbbench.py compares the profiles for job ingest, state updates
+    and status queries under concurrent load.
+
     ## Server components
 
     Main task of the backend is the processing of migration and recall
@@ -88,41 +110,34 @@
 
     @verbatim
       Id   Target Id         Frame
-      12   Thread 0x7f8f62c7a700 (LWP 16635) "ltfsdmd" 0x00007f8f65889a9b in recv () from /lib64/libpthread.so.0
-      11   Thread 0x7f8f62479700 (LWP 16640) "Scheduler" 0x00007f8f65886945 in pthread_cond_wait@@GLIBC_2.3.2 () from /lib64/libpthread.so.0
-      10   Thread 0x7f8f61c78700 (LWP 16641) "w:Scheduler" 0x00007f8f65883f57 in pthread_join () from /lib64/libpthread.so.0
-      9    Thread 0x7f8f61477700 (LWP 16642) "SigHandler" 0x00007f8f6588a371 in sigwait () from /lib64/libpthread.so.0
-      8    Thread 0x7f8f60c76700 (LWP 16643) "w:SigHandler" 0x00007f8f65883f57 in pthread_join () from /lib64/libpthread.so.0
-      7    Thread 0x7f8f4bfff700 (LWP 16644) "Receiver" 0x00007f8f6588998d in accept () from /lib64/libpthread.so.0
-      6    Thread 0x7f8f4b7fe700 (LWP 16645) "w:Receiver" 0x00007f8f65883f57 in pthread_join () from /lib64/libpthread.so.0
-      5    Thread 0x7f8f4affd700 (LWP 16646) "RecallD" 0x00007f8f6588998d in accept () from /lib64/libpthread.so.0
-      4    Thread 0x7f8f4a7fc700 (LWP 16647) "w:RecallD" 0x00007f8f65883f57 in pthread_join () from /lib64/libpthread.so.0
+      8    Thread 0x7f8f62c7a700 (LWP 16635) "ltfsdmd" 0x00007f8f65889a9b in recv () from /lib64/libpthread.so.0
+      7    Thread 0x7f8f62479700 (LWP 16640) "Scheduler" 0x00007f8f65886945 in pthread_cond_wait@@GLIBC_2.3.2 () from /lib64/libpthread.so.0
+      6    Thread 0x7f8f61477700 (LWP 16642) "SigHandler" 0x00007f8f6588a371 in sigwait () from /lib64/libpthread.so.0
+      5    Thread 0x7f8f4bfff700 (LWP 16644) "Receiver" 0x00007f8f6588998d in accept () from /lib64/libpthread.so.0
+      4    Thread 0x7f8f4affd700 (LWP 16646) "RecallD" 0x00007f8f6588998d in accept () from /lib64/libpthread.so.0
       3    Thread 0x7f8f49ffb700 (LWP 16648) "ltfsdmd.ofs" 0x00007f8f640f07fd in read () from /lib64/libc.so.6
       2    Thread 0x7f8f497fa700 (LWP 16662) "ltfsdmd.ofs" 0x00007f8f640f07fd in read () from /lib64/libc.so.6
-    * 1    Thread 0x7f8f660e08c0 (LWP 16633) "ltfsdmd" 0x00007f8f65883f57 in pthread_join () from /lib64/libpthread.so.0
+    * 1    Thread 0x7f8f660e08c0 (LWP 16633) "ltfsdmd" 0x00007f8f65886945 in pthread_cond_wait@@GLIBC_2.3.2 () from /lib64/libpthread.so.0
     @endverbatim
 
     These threads have the following purpose
 
     Id | function being executed | description
     :---:|---|---
-    12 | - | communication with LTFS LE
-    11 | Scheduler::run | schedules requests based on free resources
-    10 | SubServer::waitThread | waits for Scheduler thread termination
-    9 | Server::signalHandler | cares about signals
-    8 | SubServer::waitThread | waits for signal handler thread termination
-    7 | Receiver::run | listens for client messages
-    6 | SubServer::waitThread | waits for Receiver thread termination
-    5 | TransRecall::run | listens for transparent recall requests
-    4 | SubServer::waitThread | waits for TransRecall thread termination
+    8 | - | communication with LTFS LE
+    7 | Scheduler::run | schedules requests based on free resources
+    6 | Server::signalHandler | cares about signals
+    5 | Receiver::run | listens for client messages
+    4 | TransRecall::run | listens for transparent recall requests
     3 | FuseFS::execute | started the Fuse connector process for a single file system
     2 | FuseFS::execute | started the Fuse connector process for another file system
     1 | ltfsdmd.cc:main() | main thread
 
     In this example two file systems are managed by LTFS Data Management.
     Therefore two Fuse threads exist (for starting the Fuse overlay
-    file system processes). Thread pools are not visible after initial
-    start since threads within a thread pool are created on request.
+    file system processes). Idle threads of the @ref executor "Executor"
+    are not visible after initial start since they are created on
+    request.
 
     Furthermore the scheduler is creating additional threads for each
     request being scheduled:
@@ -133,8 +148,6 @@
     SelRecall::execRequest | schedules a selective recall request
     TransRecall::execRequest | schedules a transparent recall request
 
-    For each of these threads there will be an additional waiter thread.
-
     The following thread pools are available:
 
     operation | object | function being executed | description
@@ -164,14 +177,15 @@
             TransRecall::run -> wqr (1 thread pool)
     @endverbatim
 
-    To create threads there are two facilities created:
-    - Threads normally created by the SubServer class. After the thread
-      function finishes the thread is terminated. For each thread an
-      additional waiter thread is created. See @subpage standard_thread.
-    - For a better performance and less overhead a ThreadPool class
-      exist. Threads will stay for another 10 seconds before termination
-      after the thread function terminates. Within these 10 seconds it
-      is possible to reuse them. See @subpage thread_pool.
+    To execute functions asynchronously there are two facilities created:
+    - The SubServer class for single functions, usually running for the
+      whole processing of a request. SubServer::waitAllRemaining waits
+      for all of them. See @subpage standard_thread.
+    - The ThreadPool class to execute the same function for many items,
+      e.g. files. See @subpage thread_pool.
+
+    Both are executing the functions on the threads of a single
+    @subpage executor "Executor".
 
 
     ## Backend Processing
@@ -180,6 +194,10 @@
 
     - @subpage receiver_and_message_processing
     - @subpage scheduler
+    - @subpage mount_planner
+    - @subpage metrics
+    - @subpage drive_placement
+    - @subpage job_stats
     - @subpage migration
     - @subpage selective_recall
 
@@ -323,6 +341,8 @@ int main(int argc, char **argv)
     int opt;
     sigset_t set;
     bool dbUseMemory = false;
+    DataBase::storage_profile_t profile = DataBase::DEFAULT_PROFILE;
+    JobStore::store_type storeType = JobStore::SQLITE;
     Trace::traceLevel tl = Trace::error;
 
     opterr = 0;
@@ -333,7 +353,7 @@ int main(int argc, char **argv)
     }
 
     //! [option processing]
-    while ((opt = getopt(argc, argv, "fmd:")) != -1) {
+    while ((opt = getopt(argc, argv, "fmps:j:d:")) != -1) {
         switch (opt) {
             case 'f':
                 detach = false;
@@ -341,6 +361,27 @@ int main(int argc, char **argv)
             case 'm':
                 dbUseMemory = true;
                 break;
+            case 'p':
+                SQLStatement::profiling = true;
+                break;
+            case 's':
+                try {
+                    profile = DataBase::parseProfile(optarg);
+                } catch (const std::exception& e) {
+                    MSG(LTFSDMS0120E, optarg);
+                    err = static_cast<int>(Error::GENERAL_ERROR);
+                    goto end;
+                }
+                break;
+            case 'j':
+                try {
+                    storeType = JobStore::parseType(optarg);
+                } catch (const std::exception& e) {
+                    MSG(LTFSDMS0121E, optarg);
+                    err = static_cast<int>(Error::GENERAL_ERROR);
+                    goto end;
+                }
+                break;
             case 'd':
                 try {
                     tl = (Trace::traceLevel) std::stoi(optarg);
@@ -379,7 +420,7 @@ int main(int argc, char **argv)
     MSG(LTFSDMX0029I, LTFSDM_VERSION);
 
     try {
-        ltfsdmd.initialize(dbUseMemory);
+        ltfsdmd.initialize(dbUseMemory, profile, storeType);
 
         if (detach)
             ltfsdmd.daemonize();
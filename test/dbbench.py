@@ -0,0 +1,248 @@
+#!/usr/bin/python
+
+# Copyright 2018 IBM Corp. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#  https://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Compares the SQLite storage profiles of the backend (see ltfsdmd -s).
+# For each profile the tables of src/server/SQLStatements.cc are created
+# within a database file and the following load is applied concurrently:
+#
+#  - ingest: jobs of migration requests are added in transactions of
+#    Const::MAX_OBJECTS_SEND files like MessageParser::getObjects does
+#  - update: jobs of already added requests are changed to transferred
+#    by file uid in transactions of Const::JOB_UPDATE_BATCH files
+#  - status: the status of the requests is queried like for the
+#    progress information of the clients
+#
+# usage: dbbench.py [-n <jobs per request>] [-r <requests>]
+#                   [-s <status threads>] [-d <directory>] [profile ...]
+
+import sys
+import os
+import os.path
+import re
+import time
+import getopt
+import threading
+import sqlite3
+
+sqlfile = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                       "..", "src", "server", "SQLStatements.cc")
+
+profiles = {
+    "default": { "journal": None, "synchronous": None, "cache": 0,
+                 "mmap": 0, "perthread": False },
+    "wal": { "journal": "WAL", "synchronous": "NORMAL", "cache": 64 * 1024,
+             "mmap": 256, "perthread": True },
+}
+
+MIGRATION = 4
+RESIDENT = 0
+TRANSFERRING = 3
+TRANSFERRED = 4
+MAX_OBJECTS_SEND = 100000
+JOB_UPDATE_BATCH = 10000
+
+def statements(filename):
+    with open(filename) as f:
+        text = f.read()
+    text = re.sub(r"/\*.*?\*/", "", text, flags=re.S)
+    text = re.sub(r"//[^\n]*", "", text)
+    stmts = {}
+    for m in re.finditer(r"const\s+std::string\s+(\w+::\w+)\s*=\s*(.*?);\s*\n",
+                         text, flags=re.S):
+        parts = re.findall(r'"((?:[^"\\]|\\.)*)"', m.group(2))
+        stmts[m.group(1)] = "".join(parts)
+    return stmts
+
+class Bench:
+    def __init__(self, name, dbfile, stmts, numjobs, numreqs, numstatus):
+        self.prof = profiles[name]
+        self.name = name
+        self.dbfile = dbfile
+        self.stmts = stmts
+        self.numjobs = numjobs
+        self.numreqs = numreqs
+        self.numstatus = numstatus
+        self.translock = threading.Lock()
+        self.shared = None
+        self.local = threading.local()
+        self.ingested = threading.Semaphore(0)
+        self.done = False
+        self.results = {}
+
+    def connect(self):
+        conn = sqlite3.connect(self.dbfile, timeout=60,
+                               isolation_level=None, check_same_thread=False)
+        if self.prof["synchronous"]:
+            conn.execute("PRAGMA synchronous=%s" % self.prof["synchronous"])
+        if self.prof["cache"]:
+            conn.execute("PRAGMA cache_size=%d" % -self.prof["cache"])
+        if self.prof["mmap"]:
+            conn.execute("PRAGMA mmap_size=%d" % (self.prof["mmap"] << 20))
+        return conn
+
+    def db(self):
+        if not self.prof["perthread"]:
+            return self.shared
+        if not hasattr(self.local, "conn"):
+            self.local.conn = self.connect()
+        return self.local.conn
+
+    def setup(self):
+        for f in [self.dbfile, self.dbfile + "-journal",
+                  self.dbfile + "-wal", self.dbfile + "-shm"]:
+            if os.path.exists(f):
+                os.unlink(f)
+        self.shared = self.connect()
+        if self.prof["journal"]:
+            self.shared.execute("PRAGMA journal_mode=%s" % self.prof["journal"])
+        for name in sorted(self.stmts):
+            if self.stmts[name].startswith("CREATE"):
+                self.shared.execute(self.stmts[name])
+
+    def transaction(self, func):
+        with self.translock:
+            db = self.db()
+            db.execute(self.stmts["DataBase::BEGIN_TRANSACTION"])
+            try:
+                func(db)
+            finally:
+                db.execute(self.stmts["DataBase::COMMIT_TRANSACTION"])
+
+    def directory(self, db, name):
+        db.execute(self.stmts["SQLiteJobStore::ADD_DIRECTORY"], (name,))
+        return db.execute(self.stmts["SQLiteJobStore::GET_DIRECTORY"],
+                          (name,)).fetchone()[0]
+
+    def ingest(self):
+        sql = self.stmts["SQLiteJobStore::ADD_JOB"]
+        start = time.time()
+        released = 0
+        try:
+            for req in range(self.numreqs):
+                for first in range(0, self.numjobs, MAX_OBJECTS_SEND):
+                    last = min(first + MAX_OBJECTS_SEND, self.numjobs)
+                    def add(db):
+                        dirid = self.directory(db, "/fs/req%d/" % req)
+                        for i in range(first, last):
+                            db.execute(sql, (MIGRATION, dirid, "file%d" % i,
+                                             req, 2, 0, "", 1024, 1, 2, 0,
+                                             req * self.numjobs + i, 0, 0,
+                                             int(time.time()), "", RESIDENT,
+                                             0, 0))
+                    self.transaction(add)
+                self.ingested.release()
+                released += 1
+        finally:
+            # do not let the update thread wait forever
+            for req in range(released, self.numreqs):
+                self.ingested.release()
+        self.results["ingest jobs/s"] = \
+            self.numreqs * self.numjobs / (time.time() - start)
+
+    def update(self):
+        setstmt = self.stmts["SQLiteJobStore::CHANGE_STATE"]
+        selstmt = self.stmts["SQLiteJobStore::SELECT_JOBS"]
+        succstmt = self.stmts["SQLiteJobStore::SET_JOB_STATE"]
+        total = 0
+        elapsed = 0.0
+        for req in range(self.numreqs):
+            self.ingested.acquire()
+            start = time.time()
+            db = self.db()
+            db.execute(setstmt, (TRANSFERRING, req, RESIDENT, "", 0, 0))
+            uids = [row[7:11] for row in
+                    db.execute(selstmt, (req, "", TRANSFERRING, TRANSFERRING,
+                                         -1)).fetchall()]
+            for first in range(0, len(uids), JOB_UPDATE_BATCH):
+                def upd(db):
+                    for uid in uids[first:first + JOB_UPDATE_BATCH]:
+                        db.execute(succstmt, (TRANSFERRED, req, "",
+                                              TRANSFERRING, TRANSFERRING,
+                                              0, 0) + tuple(uid))
+                self.transaction(upd)
+            total += len(uids)
+            elapsed += time.time() - start
+        self.results["update jobs/s"] = total / elapsed if elapsed else 0
+
+    def status(self, latencies):
+        sql = self.stmts["SQLiteJobStore::COUNT_STATES"]
+        req = 0
+        while not self.done:
+            start = time.time()
+            self.db().execute(sql, (req,)).fetchall()
+            latencies.append(time.time() - start)
+            req = (req + 1) % self.numreqs
+            time.sleep(0.001)
+
+    def run(self):
+        self.setup()
+        latencies = []
+        threads = [threading.Thread(target=self.ingest),
+                   threading.Thread(target=self.update)]
+        status = [threading.Thread(target=self.status, args=(latencies,))
+                  for i in range(self.numstatus)]
+        start = time.time()
+        for t in threads + status:
+            t.start()
+        for t in threads:
+            t.join()
+        self.done = True
+        for t in status:
+            t.join()
+        self.results["elapsed s"] = time.time() - start
+        latencies.sort()
+        if latencies:
+            self.results["status avg ms"] = \
+                1000 * sum(latencies) / len(latencies)
+            self.results["status p99 ms"] = \
+                1000 * latencies[int(len(latencies) * 0.99)]
+        return self.results
+
+def main():
+    numjobs = 200000
+    numreqs = 4
+    numstatus = 4
+    directory = "/dev/shm"
+
+    opts, args = getopt.getopt(sys.argv[1:], "n:r:s:d:")
+    for opt, val in opts:
+        if opt == "-n":
+            numjobs = int(val)
+        elif opt == "-r":
+            numreqs = int(val)
+        elif opt == "-s":
+            numstatus = int(val)
+        elif opt == "-d":
+            directory = val
+
+    names = args if args else sorted(profiles)
+    stmts = statements(sqlfile)
+
+    print("%d requests, %d jobs per request, %d status threads"
+          % (numreqs, numjobs, numstatus))
+    for name in names:
+        dbfile = os.path.join(directory, "dbbench.%d.db" % os.getpid())
+        bench = Bench(name, dbfile, stmts, numjobs, numreqs, numstatus)
+        results = bench.run()
+        bench.shared.close()
+        for f in [dbfile, dbfile + "-journal", dbfile + "-wal", dbfile + "-shm"]:
+            if os.path.exists(f):
+                os.unlink(f)
+        print("%-8s %s" % (name, ", ".join("%s: %.1f" % (k, results[k])
+                                            for k in sorted(results))))
+
+if __name__ == "__main__":
+    main()
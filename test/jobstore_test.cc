@@ -0,0 +1,330 @@
+/*******************************************************************************
+ * Copyright 2018 IBM Corp. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *******************************************************************************/
+
+/*
+ * Functional test of the MemoryJobStore (see src/server/MemoryJobStore.cc)
+ * without a tape library. It performs the sequence of job store
+ * operations of a migration and checks the results:
+ *
+ * - adding jobs and rejecting duplicates of a file name or uid per replica
+ * - JobStore::pending and JobStore::assign across a compaction
+ * - ordering and limit of JobStore::select
+ * - uid based JobStore::changeState and JobStore::fail
+ * - removing jobs, dropping the segment of a request and removing jobs
+ *   while iterating over them
+ *
+ * Build after the server has been built ("make") and run from the top
+ * level directory:
+ *
+ *   g++ -std=c++11 -D_FILE_OFFSET_BITS=64 -D_GNU_SOURCE -I. -I/usr/include/libxml2 \
+ *       test/jobstore_test.cc lib/server.a lib/communication.a lib/common.a \
+ *       -Lbin -L/opt/IBM/ltfs/lib64 -L/opt/ibm/ltfsle/lib64 -lconnector \
+ *       -lprotobuf -lsqlite3 -lboost_system -lboost_thread -lltfsadminlib \
+ *       -lpthread -o /tmp/jobstore_test
+ *   /tmp/jobstore_test
+ *
+ * The exit code is the number of failed checks.
+ */
+
+#include "src/server/ServerIncludes.h"
+
+static int failed = 0;
+
+#define CHECK(cond) check(cond, #cond, __LINE__)
+
+static void check(bool cond, const char *text, int line)
+
+{
+    if (cond)
+        return;
+
+    std::cerr << "line " << line << ": check failed: " << text << std::endl;
+    failed++;
+}
+
+static JobStore::job_t job(long reqNumber, int replNum, long num,
+        unsigned long startBlock)
+
+{
+    JobStore::job_t job;
+
+    job.operation = DataBase::MIGRATION;
+    job.fileName = "/fs/dir" + std::to_string(num / 100) + "/file"
+            + std::to_string(num);
+    job.reqNumber = reqNumber;
+    job.targetState = FsObj::MIGRATED;
+    job.replNum = replNum;
+    job.pool = "pool" + std::to_string(replNum);
+    job.fileSize = num;
+    job.fuid = (fuid_t ) { 1, 2, 3, static_cast<unsigned long>(num) };
+    job.mtimeSec = num;
+    job.mtimeNsec = 0;
+    job.lastUpd = 0;
+    job.tapeId = "";
+    job.state = FsObj::RESIDENT;
+    job.startBlock = startBlock;
+    job.connInfo = 0;
+
+    return job;
+}
+
+static bool duplicate(JobStore *store, const JobStore::job_t& job)
+
+{
+    try {
+        store->add(job);
+    } catch (const LTFSDMException& e) {
+        return e.getErrno() == SQLITE_CONSTRAINT_UNIQUE;
+    }
+
+    return false;
+}
+
+static std::vector<JobStore::job_t> select(JobStore *store, long reqNumber,
+        std::string tapeId, const std::vector<FsObj::file_state>& states,
+        unsigned long limit)
+
+{
+    std::vector<JobStore::job_t> jobs;
+
+    store->select(reqNumber, tapeId, states, limit,
+            [&jobs] (const JobStore::job_t& job) {
+                jobs.push_back(job);
+                return true;
+            });
+
+    return jobs;
+}
+
+static long countState(JobStore *store, long reqNumber,
+        FsObj::file_state state)
+
+{
+    std::map<FsObj::file_state, long> num;
+
+    store->countStates(reqNumber, &num);
+
+    return num.count(state) ? num[state] : 0;
+}
+
+/*
+ * Adds and duplicate rejection: a file may only be added once per
+ * replica, also if it belongs to another request.
+ */
+static void testAdd(JobStore *store)
+
+{
+    JobStore::job_t dup;
+
+    for (long num = 0; num < 10; num++)
+        store->add(job(1, 0, num, num));
+    store->add(job(1, 1, 0, 0));
+
+    CHECK(duplicate(store, job(1, 0, 5, 5)));
+    CHECK(duplicate(store, job(2, 0, 5, 5)));
+    dup = job(2, 0, 5, 5);
+    dup.fileName = "/fs/other";
+    CHECK(duplicate(store, dup));
+    dup = job(2, 0, 5, 5);
+    dup.fuid.inum = 1000;
+    CHECK(duplicate(store, dup));
+
+    CHECK(countState(store, 1, FsObj::RESIDENT) == 11);
+    CHECK(countState(store, 2, FsObj::RESIDENT) == 0);
+
+    store->remove(1);
+    CHECK(countState(store, 1, FsObj::RESIDENT) == 0);
+    store->add(job(2, 0, 5, 5));
+    store->remove(2);
+}
+
+/*
+ * Assigns jobs to cartridges like Migration::assignJobs after most of
+ * the jobs have been deleted and the segment has been compacted.
+ */
+static void testAssign(JobStore *store)
+
+{
+    const long numJobs = 3000;
+    const long numFailed = 2000;
+    std::vector<std::pair<unsigned long, long>> pending;
+    std::vector<long> ids;
+    std::vector<long> someIds;
+    std::vector<fuid_t> uids;
+    std::vector<JobStore::job_t> jobs;
+
+    for (long num = 0; num < numJobs; num++)
+        store->add(job(3, 0, num, numJobs - num));
+
+    store->pending(3, FsObj::RESIDENT, 0, &pending);
+    CHECK((long) pending.size() == numJobs);
+    // the file size is the number of the file
+    for (std::pair<unsigned long, long>& entry : pending) {
+        ids.push_back(entry.second);
+        if (entry.first < 10 || entry.first >= 2500)
+            someIds.push_back(entry.second);
+    }
+
+    for (long num = 0; num < numFailed; num++)
+        uids.push_back(job(3, 0, num, 0).fuid);
+    store->changeState(3, "", 0, { FsObj::RESIDENT }, FsObj::FAILED, uids);
+    CHECK(countState(store, 3, FsObj::FAILED) == numFailed);
+    store->remove(3, "", { FsObj::FAILED });
+    CHECK(store->count(3, "") == numJobs - numFailed);
+
+    // ids of deleted jobs are ignored
+    store->assign(3, someIds, FsObj::TRANSFERRING, "T00001L6");
+    CHECK(store->count(3, "T00001L6") == 500);
+    jobs = select(store, 3, "T00001L6", { FsObj::TRANSFERRING }, 0);
+    for (const JobStore::job_t& job : jobs)
+        CHECK(job.fuid.inum >= 2500);
+
+    store->assign(3, ids, FsObj::TRANSFERRING, "T00001L6");
+    CHECK(store->count(3, "") == 0);
+    CHECK(store->count(3, "T00001L6") == numJobs - numFailed);
+
+    jobs = select(store, 3, "T00001L6", { FsObj::TRANSFERRING }, 0);
+    CHECK((long) jobs.size() == numJobs - numFailed);
+    for (const JobStore::job_t& job : jobs)
+        CHECK((long) job.fuid.inum >= numFailed
+                && job.fileSize == job.fuid.inum);
+}
+
+/*
+ * The jobs are selected in the order of their starting block, the
+ * limit returns the first ones.
+ */
+static void testSelect(JobStore *store)
+
+{
+    std::vector<JobStore::job_t> jobs;
+    bool ordered = true;
+
+    jobs = select(store, 3, "T00001L6", { FsObj::TRANSFERRING }, 10);
+    CHECK(jobs.size() == 10);
+    for (unsigned int i = 0; i < jobs.size(); i++)
+        if (jobs[i].startBlock != i + 1)
+            ordered = false;
+    CHECK(ordered);
+
+    jobs = select(store, 3, "T00001L6", { FsObj::TRANSFERRING }, 0);
+    for (unsigned int i = 1; i < jobs.size(); i++)
+        if (jobs[i - 1].startBlock > jobs[i].startBlock)
+            ordered = false;
+    CHECK(ordered);
+
+    CHECK(select(store, 3, "T00002L6", { FsObj::TRANSFERRING }, 0).empty());
+    CHECK(select(store, 3, "T00001L6", { FsObj::PREMIGRATED }, 0).empty());
+}
+
+/*
+ * Changes the state of a list of files and fails single files.
+ */
+static void testChangeState(JobStore *store)
+
+{
+    std::vector<fuid_t> uids;
+
+    for (long num = 2000; num < 2100; num++)
+        uids.push_back(job(3, 0, num, 0).fuid);
+    // a file of the request that has been deleted before
+    uids.push_back(job(3, 0, 10, 0).fuid);
+
+    store->changeState(3, "T00001L6", 0, { FsObj::TRANSFERRING },
+            FsObj::PREMIGRATED, uids);
+    CHECK(countState(store, 3, FsObj::PREMIGRATED) == 100);
+    CHECK(countState(store, 3, FsObj::TRANSFERRING) == 900);
+
+    store->changeState(3, "T00001L6", 0, { FsObj::RESIDENT },
+            FsObj::MIGRATED, uids);
+    CHECK(countState(store, 3, FsObj::MIGRATED) == 0);
+
+    store->fail(3, job(3, 0, 2999, 0).fileName, 0);
+    store->fail(3, job(3, 0, 2998, 0).fileName, 1);
+    CHECK(countState(store, 3, FsObj::FAILED) == 1);
+    CHECK(countState(store, 3, FsObj::TRANSFERRING) == 899);
+
+    store->changeState(3, "T00001L6", 0, FsObj::PREMIGRATED,
+            FsObj::MIGRATED);
+    CHECK(countState(store, 3, FsObj::MIGRATED) == 100);
+    CHECK(countState(store, 3, FsObj::PREMIGRATED) == 0);
+}
+
+/*
+ * Removes all jobs of a request while iterating over them. The visitor
+ * is called without holding the lock of the store like for a concurrent
+ * removal. The jobs deleted in the meantime are skipped and the segment
+ * is dropped after the iteration.
+ */
+static void testRemove(JobStore *store)
+
+{
+    const long numJobs = 3000;
+    std::vector<std::string> tapeIds;
+    long visited = 0;
+
+    for (long num = 3000; num < 3000 + numJobs; num++)
+        store->add(job(3, 0, num, num));
+
+    store->tapes(3, &tapeIds);
+    CHECK(tapeIds.size() == 2);
+
+    store->list(3, [store, &visited] (const JobStore::job_t& job) {
+        if (visited++ == 0) {
+            store->remove(3, "T00001L6", {FsObj::TRANSFERRING,
+                FsObj::MIGRATED, FsObj::FAILED});
+            store->remove(3, "", {FsObj::RESIDENT});
+        }
+        return true;
+    });
+    CHECK(visited > 0 && visited < numJobs);
+
+    tapeIds.clear();
+    store->tapes(3, &tapeIds);
+    CHECK(tapeIds.empty());
+    CHECK(store->count(3, "T00001L6") == 0);
+
+    visited = 0;
+    store->list(Const::UNSET, [&visited] (const JobStore::job_t& job) {
+        visited++;
+        return true;
+    });
+    CHECK(visited == 0);
+
+    store->add(job(3, 0, 2500, 0));
+    CHECK(countState(store, 3, FsObj::RESIDENT) == 1);
+    store->remove(3);
+}
+
+int main(int argc, char **argv)
+
+{
+    MemoryJobStore store;
+
+    traceObject.setTrclevel(Trace::none);
+
+    store.open();
+    testAdd(&store);
+    testAssign(&store);
+    testSelect(&store);
+    testChangeState(&store);
+    testRemove(&store);
+
+    std::cout << "failed checks: " << failed << std::endl;
+
+    return failed;
+}
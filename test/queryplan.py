@@ -0,0 +1,84 @@
+#!/usr/bin/python
+
+# Copyright 2018 IBM Corp. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#  https://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Runs EXPLAIN QUERY PLAN for all statements of src/server/SQLStatements.cc
+# on an empty database that is created with the same tables and indexes
+# like the server does. It fails if a statement performs a full table scan
+# that is not listed within allowed_scans.
+
+import sys
+import os.path
+import re
+import sqlite3
+
+sqlfile = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                       "..", "src", "server", "SQLStatements.cc")
+
+# statements that are expected to read the whole table
+allowed_scans = [
+    "SQLiteJobStore::ALL_JOBS",
+    "MessageParser::ALL_REQUESTS",
+    "MessageParser::INFO_ALL_REQUESTS",
+]
+
+def statements(filename):
+    with open(filename) as f:
+        text = f.read()
+    text = re.sub(r"/\*.*?\*/", "", text, flags=re.S)
+    text = re.sub(r"//[^\n]*", "", text)
+    stmts = []
+    for m in re.finditer(r"const\s+std::string\s+(\w+::\w+)\s*=\s*(.*?);\s*\n",
+                         text, flags=re.S):
+        parts = re.findall(r'"((?:[^"\\]|\\.)*)"', m.group(2))
+        stmts.append((m.group(1), "".join(parts)))
+    return stmts
+
+def substitute(sql):
+    sql = re.sub(r"'%\d+%'", "'X'", sql)
+    sql = re.sub(r"%\d+%", "1", sql)
+    sql = re.sub(r"\?\d*", "1", sql)
+    return sql
+
+def main():
+    stmts = statements(sqlfile)
+    db = sqlite3.connect(":memory:")
+
+    for name, sql in stmts:
+        if sql.startswith("CREATE"):
+            db.execute(sql)
+
+    failed = 0
+    checked = 0
+    for name, sql in stmts:
+        if not re.match(r"(SELECT|UPDATE|DELETE)", sql):
+            continue
+        checked += 1
+        plan = db.execute("EXPLAIN QUERY PLAN " + substitute(sql)).fetchall()
+        details = [row[-1] for row in plan]
+        scans = [d for d in details
+                 if re.match(r"SCAN (TABLE )?(JOB_QUEUE|JOB_DIRECTORIES|REQUEST_QUEUE)\b", d)
+                 and "INDEX" not in d]
+        if scans and name not in allowed_scans:
+            failed += 1
+            print("FAILED  %s: %s" % (name, "; ".join(details)))
+        else:
+            print("ok      %s: %s" % (name, "; ".join(details)))
+
+    print("%d statements checked, %d full table scans" % (checked, failed))
+    return 1 if failed else 0
+
+if __name__ == "__main__":
+    sys.exit(main())
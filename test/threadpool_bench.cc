@@ -0,0 +1,191 @@
+/*******************************************************************************
+ * Copyright 2018 IBM Corp. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *******************************************************************************/
+
+/*
+ * Microbenchmark of the ThreadPool (see src/server/ThreadPool.h and
+ * src/server/Executor.h):
+ * a single producer enqueues tasks and waits for their completion. The
+ * producer and the tasks can be given some busy work to simulate e.g.
+ * stepping a SQL cursor while the tasks process the files. The pool is
+ * not blocking unless -b is specified.
+ *
+ * For a mixed load (-m) a second producer concurrently enqueues tasks
+ * that sleep (e.g. waiting for a tape drive) to a blocking pool. The
+ * peak number of executor threads is reported.
+ *
+ * Build and run from the top level directory:
+ *
+ *   g++ -std=c++11 -O2 -I. test/threadpool_bench.cc -o /tmp/threadpool_bench -pthread
+ *   /tmp/threadpool_bench [-n <tasks>] [-t <threads>] [-q <queue size>]
+ *                         [-w <task work us>] [-p <producer work us>] [-b]
+ *                         [-m <sleeping tasks>] [-s <task sleep us>]
+ */
+
+#include <sys/resource.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include <string>
+#include <memory>
+#include <algorithm>
+#include <list>
+#include <deque>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <future>
+#include <functional>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+
+#include "src/common/Const.h"
+
+// the Executor only traces errors of tasks
+#define TRACE(...)
+#define MSG(...)
+
+#include "src/server/Latch.h"
+#include "src/server/Metrics.h"
+#include "src/server/Executor.h"
+#include "src/server/ThreadPool.h"
+
+static std::atomic<unsigned long> done(0);
+static std::atomic<unsigned long> slept(0);
+
+static void spin(long usecs)
+
+{
+    std::chrono::steady_clock::time_point end =
+            std::chrono::steady_clock::now() + std::chrono::microseconds(usecs);
+
+    while (usecs > 0 && std::chrono::steady_clock::now() < end) {
+    }
+}
+
+static void task(long usecs)
+
+{
+    spin(usecs);
+    done++;
+}
+
+static void sleeper(long usecs)
+
+{
+    std::this_thread::sleep_for(std::chrono::microseconds(usecs));
+    slept++;
+}
+
+static unsigned long threadsPeak()
+
+{
+    std::list<Metrics::metric_t> metricList;
+
+    Executor::instance().getMetrics(&metricList);
+    for (const Metrics::metric_t& metric : metricList)
+        if (metric.name.compare("threads peak") == 0)
+            return metric.hist.count;
+
+    return 0;
+}
+
+int main(int argc, char **argv)
+
+{
+    long tasks = 200000;
+    int threads = 16;
+    unsigned long queueSize = Const::THREAD_POOL_QUEUE_SIZE;
+    long work = 0;
+    long produce = 0;
+    bool blocking = false;
+    long sleeping = 0;
+    long sleep = 1000;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:t:q:w:p:bm:s:")) != -1) {
+        switch (opt) {
+            case 'n':
+                tasks = std::stol(optarg);
+                break;
+            case 't':
+                threads = std::stoi(optarg);
+                break;
+            case 'q':
+                queueSize = std::stoul(optarg);
+                break;
+            case 'w':
+                work = std::stol(optarg);
+                break;
+            case 'p':
+                produce = std::stol(optarg);
+                break;
+            case 'b':
+                blocking = true;
+                break;
+            case 'm':
+                sleeping = std::stol(optarg);
+                break;
+            case 's':
+                sleep = std::stol(optarg);
+                break;
+            default:
+                std::cerr << "usage: " << argv[0]
+                        << " [-n tasks] [-t threads] [-q queue size]"
+                        << " [-w task work us] [-p producer work us] [-b]"
+                        << " [-m sleeping tasks] [-s task sleep us]"
+                        << std::endl;
+                return 1;
+        }
+    }
+
+    ThreadPool<long> wq(&task, threads, "bench-wq", queueSize,
+            Executor::NORMAL, blocking);
+    ThreadPool<long> wqio(&sleeper, threads, "bench-io", queueSize);
+
+    std::chrono::steady_clock::time_point start =
+            std::chrono::steady_clock::now();
+
+    std::thread io([&wqio, sleeping, sleep] {
+        for (long i = 0; i < sleeping; i++)
+            wqio.enqueue(Const::UNSET, sleep);
+        wqio.waitCompletion(Const::UNSET);
+    });
+
+    for (long i = 0; i < tasks; i++) {
+        spin(produce);
+        wq.enqueue(Const::UNSET, work);
+    }
+    wq.waitCompletion(Const::UNSET);
+
+    double secs = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+
+    io.join();
+
+    std::cout << "tasks: " << done << ", threads: " << threads
+            << ", task work us: " << work << ", producer work us: "
+            << produce << ", blocking: " << blocking << ", sleeping tasks: "
+            << slept << ", elapsed s: " << secs << ", tasks/s: "
+            << static_cast<long>(done / secs) << ", threads peak: "
+            << threadsPeak() << std::endl;
+
+    return done == static_cast<unsigned long>(tasks)
+            && slept == static_cast<unsigned long>(sleeping) ? 0 : 1;
+}